@@ -0,0 +1,105 @@
+#include <chrono>
+#include <cstdint>
+#include <latch>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "benchmark/benchmark.h"
+#include "lib/cpp/executor/bench/latency.h"
+#include "lib/cpp/executor/busy_poll.h"
+#include "lib/cpp/executor/cpu.h"
+#include "lib/cpp/executor/executor.h"
+
+namespace handbag::executor {
+namespace {
+
+constexpr int64_t kTasks = 10000;
+
+/// Arg 0 picks the executor: `CpuExecutor` with its default spinning (0),
+/// `CpuExecutor` that parks right away (1) or `BusyPollExecutor` (2). Arg 1 is
+/// the thread count.
+std::unique_ptr<IExecutor> MakeExecutor(benchmark::State& state) {
+  const auto thread_count = static_cast<size_t>(state.range(1));
+  switch (state.range(0)) {
+    case 0:
+      state.SetLabel("CpuExecutor");
+      return CpuExecutor::create({.thread_count = thread_count});
+    case 1:
+      state.SetLabel("CpuExecutor, no spinning");
+      return CpuExecutor::create(
+          {.thread_count = thread_count, .spin_time = absl::ZeroDuration()});
+    default:
+      state.SetLabel("BusyPollExecutor");
+      return BusyPollExecutor::create({.thread_count = thread_count});
+  }
+}
+
+void Stop(IExecutor& executor) {
+  dynamic_cast<start_stop::IStoppable&>(executor).stop().get();
+}
+
+/// Time from `Add` until the task starts, one task at a time with a pause in
+/// between, so a `CpuExecutor` worker has to be woken up for every task.
+void BM_EnqueueToStartLatency(benchmark::State& state) {
+  auto executor = MakeExecutor(state);
+  std::vector<bench::Clock::duration> latencies;
+  for (const auto& x : state) {
+    (void)x;
+
+    latencies.push_back(bench::MeasureEnqueueToStart(*executor));
+
+    // Long enough for an idle `CpuExecutor` worker to stop spinning.
+    state.PauseTiming();
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+    state.ResumeTiming();
+  }
+
+  bench::ReportPercentiles(state, latencies);
+  Stop(*executor);
+}
+
+BENCHMARK(BM_EnqueueToStartLatency)
+    ->ArgsProduct({{0, 1, 2}, {1}})
+    ->UseRealTime();
+
+/// Same, back to back: the worker is still awake when the next task comes.
+void BM_EnqueueToStartLatencyBackToBack(benchmark::State& state) {
+  auto executor = MakeExecutor(state);
+  std::vector<bench::Clock::duration> latencies;
+  for (const auto& x : state) {
+    (void)x;
+
+    latencies.push_back(bench::MeasureEnqueueToStart(*executor));
+  }
+
+  bench::ReportPercentiles(state, latencies);
+  Stop(*executor);
+}
+
+BENCHMARK(BM_EnqueueToStartLatencyBackToBack)
+    ->ArgsProduct({{0, 1, 2}, {1}})
+    ->UseRealTime();
+
+/// Throughput of empty tasks from a single producer.
+void BM_EmptyTasks(benchmark::State& state) {
+  auto executor = MakeExecutor(state);
+  for (const auto& x : state) {
+    (void)x;
+
+    std::latch done(kTasks);
+    for (int64_t i = 0; i < kTasks; ++i) {
+      executor->Add([&done] { done.count_down(); });
+    }
+    done.wait();
+  }
+
+  state.SetItemsProcessed(state.iterations() * kTasks);
+  Stop(*executor);
+}
+
+BENCHMARK(BM_EmptyTasks)->ArgsProduct({{0, 2}, {1, 2}})->UseRealTime();
+
+}  // namespace
+}  // namespace handbag::executor
@@ -0,0 +1,256 @@
+#include <array>
+#include <atomic>
+#include <barrier>
+#include <cstdint>
+#include <latch>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "lib/cpp/executor/bench/latency.h"
+#include "lib/cpp/executor/cpu.h"
+#include "lib/cpp/executor/executor.h"
+
+namespace handbag::executor {
+namespace {
+
+constexpr int64_t kTasks = 10000;
+
+std::unique_ptr<CpuExecutor> MakeExecutor(
+    const int64_t thread_count, const int64_t queue_capacity = 0) {
+  auto res = CpuExecutor::create(
+      {.thread_count = static_cast<size_t>(thread_count),
+       .queue_capacity = queue_capacity > 0
+                             ? std::optional(static_cast<size_t>(
+                                   queue_capacity))
+                             : std::nullopt});
+  return res;
+}
+
+/// Producer threads started once per benchmark, so that the timed loop
+/// doesn't pay for creating and joining them.
+class Producers {
+ public:
+  Producers(CpuExecutor& executor, const int64_t count)
+      : executor_(executor), count_(count), start_(count + 1) {
+    for (int64_t producer = 0; producer < count_; ++producer) {
+      threads_.emplace_back([this, producer] { Produce(producer); });
+    }
+  }
+
+  Producers(const Producers&) = delete;
+  Producers& operator=(const Producers&) = delete;
+
+  ~Producers() {
+    stopping_ = true;
+    start_.arrive_and_wait();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  /// Releases the producers to add `kTasks` empty tasks between them and
+  /// waits for all of them to run.
+  void AddEmptyTasks() {
+    std::latch done(kTasks);
+    done_ = &done;
+    start_.arrive_and_wait();
+    done.wait();
+  }
+
+ private:
+  void Produce(const int64_t producer) {
+    const auto begin = kTasks * producer / count_;
+    const auto end = kTasks * (producer + 1) / count_;
+    for (;;) {
+      start_.arrive_and_wait();
+      if (stopping_) {
+        return;
+      }
+
+      auto& done = *done_;
+      for (auto i = begin; i < end; ++i) {
+        executor_.Add([&done] { done.count_down(); });
+      }
+    }
+  }
+
+ private:
+  CpuExecutor& executor_;
+  const int64_t count_;
+  // Reused every iteration, unlike a latch. `done_` and `stopping_` are
+  // published by the barrier.
+  std::barrier<> start_;
+  std::latch* done_ = nullptr;
+  bool stopping_ = false;
+  std::vector<std::thread> threads_;
+};
+
+// Args: thread count, producer count.
+void BM_EmptyTasks(benchmark::State& state) {
+  auto executor = MakeExecutor(state.range(0));
+  Producers producers(*executor, state.range(1));
+  for (const auto& x : state) {
+    (void)x;
+
+    producers.AddEmptyTasks();
+  }
+
+  state.SetItemsProcessed(state.iterations() * kTasks);
+  executor->stop().get();
+}
+
+BENCHMARK(BM_EmptyTasks)
+    ->ArgsProduct({{1, 2, 4, 8}, {1, 2, 4}})
+    ->UseRealTime();
+
+// Args: thread count, queue capacity.
+void BM_BoundedQueue(benchmark::State& state) {
+  auto executor = MakeExecutor(state.range(0), state.range(1));
+  Producers producers(*executor, 4);
+  for (const auto& x : state) {
+    (void)x;
+
+    producers.AddEmptyTasks();
+  }
+
+  state.SetItemsProcessed(state.iterations() * kTasks);
+  executor->stop().get();
+}
+
+BENCHMARK(BM_BoundedQueue)
+    ->ArgsProduct({{1, 4}, {0, 16, 256, 4096}})
+    ->UseRealTime();
+
+/// Time from `Add` until the task starts, one task at a time, so it includes
+/// waking up an idle worker. Reported as percentiles in microseconds.
+void BM_EnqueueToStartLatency(benchmark::State& state) {
+  auto executor = MakeExecutor(state.range(0));
+  std::vector<bench::Clock::duration> latencies;
+  for (const auto& x : state) {
+    (void)x;
+
+    latencies.push_back(bench::MeasureEnqueueToStart(*executor));
+  }
+
+  bench::ReportPercentiles(state, latencies);
+  executor->stop().get();
+}
+
+BENCHMARK(BM_EnqueueToStartLatency)->Arg(1)->Arg(4)->UseRealTime();
+
+void BM_Add(benchmark::State& state) {
+  auto executor = MakeExecutor(4);
+  Producers producers(*executor, 1);
+  for (const auto& x : state) {
+    (void)x;
+
+    producers.AddEmptyTasks();
+  }
+
+  state.SetItemsProcessed(state.iterations() * kTasks);
+  executor->stop().get();
+}
+
+BENCHMARK(BM_Add)->UseRealTime();
+
+/// Same as `BM_Add`, but every task gets a future.
+void BM_AddTo(benchmark::State& state) {
+  auto executor = MakeExecutor(4);
+  std::vector<Future<void>> futures;
+  futures.reserve(kTasks);
+  for (const auto& x : state) {
+    (void)x;
+
+    for (int64_t i = 0; i < kTasks; ++i) {
+      futures.push_back(AddTo(*executor, [] {}));
+    }
+    for (auto& future : futures) {
+      future.Get();
+    }
+    futures.clear();
+  }
+
+  state.SetItemsProcessed(state.iterations() * kTasks);
+  executor->stop().get();
+}
+
+BENCHMARK(BM_AddTo)->UseRealTime();
+
+/// A closure bigger than `absl::AnyInvocable` keeps inline but small enough
+/// for `ExecutorTask`, submitted through `Add` (arg 0) or `AddTask` (arg 1).
+void BM_AddLargeClosure(benchmark::State& state) {
+  auto executor = MakeExecutor(4);
+  const bool inline_task = state.range(0) != 0;
+  state.SetLabel(inline_task ? "ExecutorTask" : "AnyInvocable");
+  for (const auto& x : state) {
+    (void)x;
+
+    std::latch done(kTasks);
+    for (int64_t i = 0; i < kTasks; ++i) {
+      auto closure = [&done, payload = std::array<int64_t, 5>{i}] {
+        benchmark::DoNotOptimize(payload);
+        done.count_down();
+      };
+      if (inline_task) {
+        executor->AddTask(std::move(closure), TaskOptions());
+      } else {
+        executor->Add(std::move(closure));
+      }
+    }
+    done.wait();
+  }
+
+  state.SetItemsProcessed(state.iterations() * kTasks);
+  executor->stop().get();
+}
+
+BENCHMARK(BM_AddLargeClosure)->Arg(0)->Arg(1)->UseRealTime();
+
+void FanOut(CpuExecutor& executor, const int64_t fan_out, const int64_t depth,
+            std::latch& done) {
+  if (depth == 0) {
+    done.count_down();
+    return;
+  }
+
+  for (int64_t i = 0; i < fan_out; ++i) {
+    executor.Add([&executor, fan_out, depth, &done] {
+      FanOut(executor, fan_out, depth - 1, done);
+    });
+  }
+}
+
+// Args: thread count, fan-out; every task spawns fan-out children, 4 levels
+// deep.
+void BM_RecursiveFanOut(benchmark::State& state) {
+  constexpr int64_t kDepth = 4;
+
+  auto executor = MakeExecutor(state.range(0));
+  const auto fan_out = state.range(1);
+  int64_t leaves = 1;
+  for (int64_t level = 0; level < kDepth; ++level) {
+    leaves *= fan_out;
+  }
+
+  for (const auto& x : state) {
+    (void)x;
+
+    std::latch done(leaves);
+    FanOut(*executor, fan_out, kDepth, done);
+    done.wait();
+  }
+
+  state.SetItemsProcessed(state.iterations() * leaves);
+  executor->stop().get();
+}
+
+BENCHMARK(BM_RecursiveFanOut)
+    ->ArgsProduct({{1, 4, 8}, {4, 10}})
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace handbag::executor
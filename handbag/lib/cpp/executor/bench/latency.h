@@ -0,0 +1,50 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <latch>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "lib/cpp/executor/executor.h"
+
+namespace handbag::executor::bench {
+
+using Clock = std::chrono::steady_clock;
+
+/// Time from `Add` until the task starts, for a single task.
+inline Clock::duration MeasureEnqueueToStart(IExecutor& executor) {
+  std::latch done(1);
+  Clock::duration res;
+  const auto enqueued_at = Clock::now();
+  executor.Add([&] {
+    res = Clock::now() - enqueued_at;
+    done.count_down();
+  });
+  done.wait();
+  return res;
+}
+
+/// Reports the p50, p99 and p999 of `latencies` in microseconds as counters.
+/// Sorts `latencies`.
+inline void ReportPercentiles(benchmark::State& state,
+                              std::vector<Clock::duration>& latencies) {
+  if (latencies.empty()) {
+    return;
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  const auto percentile = [&](const double quantile) {
+    const auto index = static_cast<size_t>(
+        quantile * static_cast<double>(latencies.size() - 1));
+    auto res = std::chrono::duration<double, std::micro>(latencies[index])
+                   .count();
+    return res;
+  };
+  state.counters["p50_us"] = percentile(0.5);
+  state.counters["p99_us"] = percentile(0.99);
+  state.counters["p999_us"] = percentile(0.999);
+}
+
+}  // namespace handbag::executor::bench
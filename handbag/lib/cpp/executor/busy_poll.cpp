@@ -0,0 +1,384 @@
+#include "lib/cpp/executor/busy_poll.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <future>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/optimization.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/log/log.h"
+#include "absl/synchronization/mutex.h"
+#include "lib/cpp/executor/internal/parking.h"
+#include "lib/cpp/executor/internal/spsc_queue.h"
+#include "lib/cpp/executor/internal/topology.h"
+#include "lib/cpp/repr/repr.h"
+#include "lib/cpp/start_stop/state.h"
+
+namespace handbag::executor {
+
+namespace {
+using Ring = internal_executor::SpscQueue<ExecutorTask>;
+
+constexpr size_t kDefaultThreadCount = 1;
+constexpr size_t kDefaultRingCapacity = 1024;
+constexpr size_t kDefaultMaxProducerCount = 64;
+// Most tasks a worker takes from a ring in a row, so a busy producer can't
+// hold up the others.
+constexpr size_t kPollBatch = 32;
+// Longest run of pause instructions between two polls of an idle worker, a
+// few microseconds on current CPUs.
+constexpr size_t kMaxBackoff = 64;
+// Producers past `max_producer_count`.
+constexpr size_t kSharedSlot = std::numeric_limits<size_t>::max();
+
+/// Spins for `backoff` pauses and doubles it, up to `kMaxBackoff`.
+void Backoff(size_t& backoff) noexcept {
+  for (size_t i = 0; i < backoff; ++i) {
+    internal_executor::CpuRelax();
+  }
+  backoff = std::min(backoff * 2, kMaxBackoff);
+}
+
+struct WorkerContext {
+  const void* owner = nullptr;
+  size_t index = 0;
+};
+
+thread_local WorkerContext current_worker;
+
+/// Executors are told apart by id rather than by address, which may be reused
+/// by an executor created later.
+std::atomic<uint64_t> next_executor_id = 1;
+
+struct ProducerContext {
+  uint64_t executor_id = 0;
+  size_t slot = 0;
+  // Round-robin over the workers, private to the producer.
+  size_t next_worker = 0;
+};
+
+// One entry per executor the thread ever added to. Entries of destroyed
+// executors are not removed: the list only grows, by a few bytes per executor.
+thread_local std::vector<ProducerContext> producers;
+}  // namespace
+
+class BusyPollExecutor::Impl final : public IExecutor,
+                                     public start_stop::IStoppable,
+                                     public IRepr,
+                                     public start_stop::StoppableState {
+  struct alignas(ABSL_CACHELINE_SIZE) Worker {
+    explicit Worker(const size_t max_producer_count)
+        : rings(std::make_unique<std::atomic<Ring*>[]>(max_producer_count)),
+          ring_count(max_producer_count) {}
+
+    ~Worker() {
+      for (size_t i = 0; i < ring_count; ++i) {
+        delete rings[i].load(std::memory_order_relaxed);
+      }
+    }
+
+    // One per producer slot, allocated by the producer on its first push.
+    const std::unique_ptr<std::atomic<Ring*>[]> rings;
+    const size_t ring_count;
+    // Tasks the worker added itself, touched by nobody else.
+    std::deque<ExecutorTask> local;
+    // Tasks of the producers that didn't get a slot.
+    absl::Mutex mutex;
+    std::deque<ExecutorTask> shared ABSL_GUARDED_BY(mutex);
+    std::atomic<size_t> shared_size = 0;
+  };
+
+ public:
+  Impl(const IExecutor* const owner, const BusyPollExecutorParams& params)
+      : owner_(owner),
+        id_(next_executor_id.fetch_add(1, std::memory_order_relaxed)),
+        name_(params.name.has_value() ? params.name.value() : "BusyPoll"),
+        cpus_(params.cpus.value_or(std::vector<size_t>())),
+        ring_capacity_(params.ring_capacity.value_or(kDefaultRingCapacity)),
+        max_producer_count_(
+            params.max_producer_count.value_or(kDefaultMaxProducerCount)) {
+    const auto thread_count = std::max<size_t>(
+        params.thread_count.value_or(kDefaultThreadCount), 1);
+    workers_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+      workers_.push_back(std::make_unique<Worker>(max_producer_count_));
+    }
+
+    threads_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+      threads_.push_back(
+          std::async(std::launch::async, &Impl::WorkerTask, this, i));
+    }
+  }
+
+  void Add(absl::AnyInvocable<void() &&> task) noexcept override {
+    ExecutorTask inline_task = std::move(task);
+    Push(inline_task, true);
+  }
+
+  bool TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept override {
+    ExecutorTask inline_task = std::move(task);
+    if (!Push(inline_task, false)) {
+      task = std::move(*inline_task.target<absl::AnyInvocable<void() &&>>());
+      return false;
+    }
+
+    return true;
+  }
+
+  void AddTask(ExecutorTask task,
+               const TaskOptions& options) noexcept override {
+    if (options.cancellation.has_value()) {
+      IExecutor::AddTask(std::move(task), options);
+      return;
+    }
+
+    Push(task, true);
+  }
+
+  std::future<void> stop() override {
+    SetStopping();
+
+    auto res = std::async(std::launch::async, [this]() noexcept {
+      for (auto& thread : threads_) {
+        try {
+          thread.get();
+        } catch (...) {
+          auto eptr = std::current_exception();
+          std::string message;
+          try {
+            std::rethrow_exception(eptr);
+          } catch (const std::exception& exc) {
+            message = exc.what();
+          }
+
+          LOG(ERROR) << *this << "; what() = " << message;
+        }
+      }
+
+      SetStopped();
+    });
+
+    return res;
+  }
+
+  std::string GetRepr() const noexcept override {
+    return Repr::create("BusyPollExecutor")
+        .field("name", name_)
+        .field("thread_count", workers_.size())
+        .field("pinned", !cpus_.empty())
+        .field("ring_capacity", ring_capacity_)
+        .field("max_producer_count", max_producer_count_)
+        .field("producer_count",
+               producer_count_.load(std::memory_order_relaxed))
+        .end();
+  }
+
+ private:
+  ProducerContext& Producer() noexcept {
+    for (auto& producer : producers) {
+      if (producer.executor_id == id_) {
+        return producer;
+      }
+    }
+
+    auto slot = producer_count_.fetch_add(1);
+    if (slot >= max_producer_count_) {
+      slot = kSharedSlot;
+    }
+    auto& res = producers.emplace_back(
+        ProducerContext{.executor_id = id_, .slot = slot});
+    return res;
+  }
+
+  Ring& GetRing(Worker& worker, const size_t slot) {
+    auto* res = worker.rings[slot].load(std::memory_order_relaxed);
+    if (ABSL_PREDICT_FALSE(res == nullptr)) {
+      res = new Ring(ring_capacity_);
+      worker.rings[slot].store(res, std::memory_order_release);
+    }
+
+    return *res;
+  }
+
+  /// `task` is moved from only if it was accepted. With `wait` set, spins
+  /// while the ring is full, unless the executor is stopping.
+  bool Push(ExecutorTask& task, const bool wait) noexcept {
+    if (current_worker.owner == this) {
+      workers_[current_worker.index]->local.push_back(std::move(task));
+      return true;
+    }
+
+    auto& producer = Producer();
+    auto& worker = *workers_[producer.next_worker++ % workers_.size()];
+    if (ABSL_PREDICT_FALSE(producer.slot == kSharedSlot)) {
+      const absl::MutexLock lock(&worker.mutex);
+      worker.shared.push_back(std::move(task));
+      worker.shared_size.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+
+    auto& ring = GetRing(worker, producer.slot);
+    for (size_t backoff = 1; !ring.TryPush(std::move(task));) {
+      if (!wait || IsStoppingOrStopped()) {
+        return false;
+      }
+
+      Backoff(backoff);
+    }
+
+    return true;
+  }
+
+  void Run(ExecutorTask task) noexcept {
+    try {
+      std::move(task)();
+    } catch (...) {
+      auto eptr = std::current_exception();
+      std::string message;
+      try {
+        std::rethrow_exception(eptr);
+      } catch (const std::exception& exc) {
+        message = exc.what();
+      }
+
+      LOG(ERROR) << *this << "; what() = " << message;
+    }
+  }
+
+  /// One pass over all the queues of the worker, returns the number of tasks
+  /// run.
+  size_t Poll(Worker& worker) {
+    size_t res = 0;
+    const auto producer_count = std::min(
+        producer_count_.load(std::memory_order_acquire), max_producer_count_);
+    for (size_t i = 0; i < producer_count; ++i) {
+      auto* const ring = worker.rings[i].load(std::memory_order_acquire);
+      if (ring == nullptr) {
+        continue;
+      }
+
+      ExecutorTask task;
+      for (size_t n = 0; n < kPollBatch && ring->TryPop(task); ++n) {
+        Run(std::move(task));
+        ++res;
+      }
+    }
+
+    if (ABSL_PREDICT_FALSE(
+            worker.shared_size.load(std::memory_order_relaxed) > 0)) {
+      std::vector<ExecutorTask> tasks;
+      {
+        const absl::MutexLock lock(&worker.mutex);
+        while (tasks.size() < kPollBatch && !worker.shared.empty()) {
+          tasks.push_back(std::move(worker.shared.front()));
+          worker.shared.pop_front();
+        }
+        worker.shared_size.fetch_sub(tasks.size(), std::memory_order_relaxed);
+      }
+      for (auto& task : tasks) {
+        Run(std::move(task));
+      }
+      res += tasks.size();
+    }
+
+    // Tasks these add go to the next pass.
+    for (auto n = worker.local.size(); n > 0; --n) {
+      auto task = std::move(worker.local.front());
+      worker.local.pop_front();
+      Run(std::move(task));
+      ++res;
+    }
+
+    return res;
+  }
+
+  void WorkerTask(const size_t index) {
+    internal_executor::SetCurrentThreadName(name_ + ":" +
+                                            std::to_string(index));
+    if (!cpus_.empty()) {
+      const auto cpu = cpus_[index % cpus_.size()];
+      if (!internal_executor::PinCurrentThread(std::span(&cpu, 1))) {
+        LOG(WARNING) << *this << "; failed to pin worker " << index;
+      }
+    }
+
+    current_worker = {.owner = this, .index = index};
+    const internal_executor::ScopedCurrentExecutor current_executor(owner_);
+    auto& worker = *workers_[index];
+    for (size_t backoff = 1;;) {
+      // Read before the pass, so that whatever was added before `stop` is
+      // still run.
+      const bool stopping = IsStoppingOrStopped();
+      if (Poll(worker) > 0) {
+        backoff = 1;
+        continue;
+      }
+
+      if (stopping) {
+        break;
+      }
+
+      Backoff(backoff);
+    }
+
+    current_worker = {};
+  }
+
+ private:
+  // The public executor, for `IsCurrentThreadIn`.
+  const IExecutor* const owner_;
+  const uint64_t id_;
+  const std::string name_;
+  const std::vector<size_t> cpus_;
+  const size_t ring_capacity_;
+  const size_t max_producer_count_;
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  // Slots handed out, may exceed `max_producer_count_`.
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<size_t> producer_count_ = 0;
+  std::vector<std::future<void>> threads_;
+};
+
+BusyPollExecutor::BusyPollExecutor(NotPubliclyConstructible /*npc*/,
+                                   const BusyPollExecutorParams& params)
+    : i_(std::make_unique<Impl>(this, params)) {}
+
+BusyPollExecutor::~BusyPollExecutor() = default;
+
+std::unique_ptr<BusyPollExecutor> BusyPollExecutor::create(
+    const BusyPollExecutorParams& params) {
+  auto res =
+      std::make_unique<BusyPollExecutor>(NotPubliclyConstructible(), params);
+  return res;
+}
+
+void BusyPollExecutor::Add(absl::AnyInvocable<void() &&> task) noexcept {
+  i_->Add(std::move(task));
+}
+
+bool BusyPollExecutor::TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept {
+  auto res = i_->TryAdd(std::move(task));
+  return res;
+}
+
+void BusyPollExecutor::AddTask(ExecutorTask task,
+                               const TaskOptions& options) noexcept {
+  i_->AddTask(std::move(task), options);
+}
+
+std::future<void> BusyPollExecutor::stop() {
+  auto res = i_->stop();
+  return res;
+}
+
+}  // namespace handbag::executor
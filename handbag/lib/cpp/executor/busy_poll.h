@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/functional/any_invocable.h"
+#include "lib/cpp/executor/executor.h"
+#include "lib/cpp/start_stop/start_stop.h"
+
+namespace handbag::executor {
+
+struct BusyPollExecutorParams {
+  /// Also names the worker threads ("<name>:<index>").
+  std::optional<std::string> name = {};
+  /// Defaults to 1.
+  std::optional<size_t> thread_count = {};
+  /// Worker `i` is pinned to `cpus[i % cpus.size()]`. The cores should be
+  /// dedicated to the workers (e.g. `isolcpus`), they are never given up. Not
+  /// pinned unless set.
+  std::optional<std::vector<size_t>> cpus = {};
+  /// Capacity of every producer's ring to every worker, rounded up to a power
+  /// of two. Defaults to 1024.
+  std::optional<size_t> ring_capacity = {};
+  /// Threads that get rings of their own, the ones that come later share a
+  /// locked queue per worker. Defaults to 64. A slot is taken by the first
+  /// `Add` of a thread and is never given back, not even when the thread
+  /// exits: with short-lived producers (e.g. a thread per request) the slots
+  /// run out and everything goes through the locked queues. Keep the
+  /// producers long-lived, or hand their tasks over through a thread that is.
+  std::optional<size_t> max_producer_count = {};
+};
+
+/// Executor for latency-critical paths: its workers never sleep, they spin
+/// polling a ring per producer thread, with a pause instruction and
+/// exponential backoff in between, so a task starts without a futex wake-up.
+/// Every worker burns its core even when there is nothing to do.
+///
+/// A producer spreads its tasks round-robin over the workers, each through its
+/// own single-producer single-consumer ring; tasks added from a worker stay on
+/// it. `Add` spins while the ring is full, `TryAdd` rejects. Task options are
+/// ignored, except for cancellation.
+class BusyPollExecutor final : public IExecutor,
+                               public start_stop::IStoppable {
+  class NotPubliclyConstructible {};
+
+ public:
+  BusyPollExecutor() = delete;
+  BusyPollExecutor(const BusyPollExecutor&) = delete;
+  BusyPollExecutor(BusyPollExecutor&&) = delete;
+  BusyPollExecutor& operator=(const BusyPollExecutor&) = delete;
+  BusyPollExecutor& operator=(BusyPollExecutor&&) = delete;
+
+  BusyPollExecutor(NotPubliclyConstructible /*npc*/,
+                   const BusyPollExecutorParams& params);
+  ~BusyPollExecutor() override;
+
+  static std::unique_ptr<BusyPollExecutor> create(
+      const BusyPollExecutorParams& params = {});
+
+  void Add(absl::AnyInvocable<void() &&> task) noexcept override;
+  bool TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept override;
+  void AddTask(ExecutorTask task, const TaskOptions& options) noexcept override;
+
+  /// Tasks added before `stop` are run, ones added after may be dropped.
+  std::future<void> stop() override;
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> i_;
+};
+
+}  // namespace handbag::executor
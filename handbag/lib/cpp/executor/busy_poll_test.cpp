@@ -0,0 +1,119 @@
+#include "lib/cpp/executor/busy_poll.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <functional>
+#include <latch>
+#include <thread>
+#include <vector>
+
+#include "absl/functional/any_invocable.h"
+#include "absl/synchronization/notification.h"
+
+using namespace ::testing;
+
+namespace handbag::executor::tests {
+namespace {
+
+TEST(BusyPollExecutorTest, RunsTasks) {
+  auto executor = BusyPollExecutor::create({.thread_count = 2});
+
+  std::vector<Future<int>> results;
+  for (int i = 0; i < 1000; ++i) {
+    results.push_back(AddTo(*executor, [i] { return i * 2; }));
+  }
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_THAT(results[i].Get(), Eq(i * 2));
+  }
+
+  executor->stop().get();
+}
+
+TEST(BusyPollExecutorTest, MoreProducersThanRings) {
+  auto executor =
+      BusyPollExecutor::create({.thread_count = 2, .max_producer_count = 2});
+
+  constexpr int kProducers = 4;
+  constexpr int kTasks = 1000;
+  std::atomic<int> done = 0;
+  std::latch all_done(kProducers * kTasks);
+  std::vector<std::thread> producers;
+  for (int i = 0; i < kProducers; ++i) {
+    producers.emplace_back([&] {
+      for (int j = 0; j < kTasks; ++j) {
+        executor->Add([&] {
+          (void)done.fetch_add(1);
+          all_done.count_down();
+        });
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+
+  all_done.wait();
+  EXPECT_THAT(done.load(), Eq(kProducers * kTasks));
+  executor->stop().get();
+}
+
+TEST(BusyPollExecutorTest, TryAddRejectsWhenRingIsFull) {
+  auto executor =
+      BusyPollExecutor::create({.thread_count = 1, .ring_capacity = 2});
+
+  absl::Notification started;
+  absl::Notification release;
+  executor->Add([&] {
+    started.Notify();
+    release.WaitForNotification();
+  });
+  started.WaitForNotification();
+
+  int calls = 0;
+  EXPECT_TRUE(executor->TryAdd([&] { ++calls; }));
+  EXPECT_TRUE(executor->TryAdd([&] { ++calls; }));
+  absl::AnyInvocable<void() &&> rejected = [&] { ++calls; };
+  EXPECT_FALSE(executor->TryAdd(std::move(rejected)));
+  // NOLINTNEXTLINE(bugprone-use-after-move)
+  ASSERT_TRUE(static_cast<bool>(rejected));
+
+  release.Notify();
+  executor->stop().get();
+  EXPECT_THAT(calls, Eq(2));
+}
+
+TEST(BusyPollExecutorTest, TasksFromWorkers) {
+  auto executor = BusyPollExecutor::create({.thread_count = 2});
+
+  std::atomic<int> depth = 0;
+  absl::Notification done;
+  std::function<void()> chain = [&] {
+    EXPECT_TRUE(IsCurrentThreadIn(*executor));
+    if (depth.fetch_add(1) + 1 == 100) {
+      done.Notify();
+      return;
+    }
+    executor->Add(chain);
+  };
+  executor->Add(chain);
+  done.WaitForNotification();
+  EXPECT_FALSE(IsCurrentThreadIn(*executor));
+
+  executor->stop().get();
+}
+
+TEST(BusyPollExecutorTest, StopRunsQueuedTasks) {
+  auto executor = BusyPollExecutor::create({.thread_count = 2});
+
+  std::atomic<int> done = 0;
+  for (int i = 0; i < 1000; ++i) {
+    executor->Add([&] { (void)done.fetch_add(1); });
+  }
+  executor->stop().get();
+  EXPECT_THAT(done.load(), Eq(1000));
+}
+
+}  // namespace
+}  // namespace handbag::executor::tests
@@ -0,0 +1 @@
+#include "lib/cpp/executor/cancellation.h"
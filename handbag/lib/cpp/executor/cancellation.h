@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace handbag {
+
+/// Result of a task dropped without being run: it was cancelled, shed by an
+/// overloaded executor or discarded by a stopping one.
+class TaskCancelledError final : public std::runtime_error {
+ public:
+  TaskCancelledError() : std::runtime_error("task cancelled") {}
+};
+
+namespace internal_executor {
+struct CancellationState {
+  std::atomic<bool> cancelled = false;
+};
+}  // namespace internal_executor
+
+/// Tells whether its `CancellationSource` was cancelled. A default constructed
+/// token is never cancelled.
+class CancellationToken {
+ public:
+  CancellationToken() = default;
+
+  bool IsCancelled() const noexcept {
+    auto res = state_ != nullptr &&
+               state_->cancelled.load(std::memory_order_acquire);
+    return res;
+  }
+
+ private:
+  friend class CancellationSource;
+
+  explicit CancellationToken(
+      std::shared_ptr<const internal_executor::CancellationState> state)
+      : state_(std::move(state)) {}
+
+ private:
+  std::shared_ptr<const internal_executor::CancellationState> state_;
+};
+
+/// Cancels the tasks submitted with its tokens, e.g. all the tasks of a
+/// request that timed out. Copies share the same state.
+class CancellationSource {
+ public:
+  CancellationSource()
+      : state_(std::make_shared<internal_executor::CancellationState>()) {}
+
+  void Cancel() noexcept {
+    state_->cancelled.store(true, std::memory_order_release);
+  }
+
+  bool IsCancelled() const noexcept {
+    auto res = state_->cancelled.load(std::memory_order_acquire);
+    return res;
+  }
+
+  CancellationToken GetToken() const noexcept {
+    CancellationToken res(state_);
+    return res;
+  }
+
+ private:
+  std::shared_ptr<internal_executor::CancellationState> state_;
+};
+
+}  // namespace handbag
@@ -0,0 +1,21 @@
+#include "lib/cpp/executor/coro.h"
+
+namespace handbag::internal_executor {
+
+namespace {
+thread_local ScheduleOnScope* current_schedule_on_scope = nullptr;
+}  // namespace
+
+ScheduleOnScope::ScheduleOnScope(
+    const ScheduleOnAwaiter* const awaiter) noexcept
+    : awaiter_(awaiter), outer_(current_schedule_on_scope) {
+  current_schedule_on_scope = this;
+}
+
+ScheduleOnScope::~ScheduleOnScope() { current_schedule_on_scope = outer_; }
+
+ScheduleOnScope* ScheduleOnScope::Current() noexcept {
+  return current_schedule_on_scope;
+}
+
+}  // namespace handbag::internal_executor
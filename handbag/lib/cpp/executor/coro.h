@@ -0,0 +1,352 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "lib/cpp/executor/cancellation.h"
+#include "lib/cpp/executor/executor.h"
+#include "lib/cpp/executor/future.h"
+#include "lib/cpp/executor/internal/frame_pool.h"
+
+namespace handbag {
+
+template <typename T = void>
+class Task;
+
+namespace internal_executor {
+
+/// Frames of all the coroutines here come from the frame pool.
+struct PooledFrame {
+  static void* operator new(const size_t size) {
+    auto* const res = AllocateFrame(size);
+    return res;
+  }
+
+  static void operator delete(void* const ptr, const size_t size) noexcept {
+    DeallocateFrame(ptr, size);
+  }
+};
+
+template <typename T>
+class TaskPromiseBase : public PooledFrame {
+  struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<Promise> handle) noexcept {
+      auto res = handle.promise().continuation_;
+      return res;
+    }
+
+    void await_resume() const noexcept {}
+  };
+
+ public:
+  using Value = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+
+  FinalAwaiter final_suspend() const noexcept { return {}; }
+
+  void unhandled_exception() noexcept {
+    exception_ = std::current_exception();
+  }
+
+  void SetContinuation(const std::coroutine_handle<> continuation) noexcept {
+    continuation_ = continuation;
+  }
+
+  /// Must be called at most once, after the coroutine has finished.
+  Value TakeValue() {
+    if (exception_) {
+      std::rethrow_exception(exception_);
+    }
+
+    auto res = std::move(*value_);
+    return res;
+  }
+
+ protected:
+  std::optional<Value> value_;
+
+ private:
+  std::exception_ptr exception_;
+  std::coroutine_handle<> continuation_ = std::noop_coroutine();
+};
+
+template <typename T>
+class TaskPromise final : public TaskPromiseBase<T> {
+ public:
+  Task<T> get_return_object() noexcept;
+
+  template <typename U>
+  void return_value(U&& value) {
+    this->value_.emplace(std::forward<U>(value));
+  }
+};
+
+template <>
+class TaskPromise<void> final : public TaskPromiseBase<void> {
+ public:
+  Task<void> get_return_object() noexcept;
+
+  void return_void() noexcept { this->value_.emplace(); }
+};
+
+/// Coroutine that starts right away and frees itself once done.
+struct DetachedCoroutine {
+  struct promise_type : PooledFrame {
+    DetachedCoroutine get_return_object() const noexcept { return {}; }
+    std::suspend_never initial_suspend() const noexcept { return {}; }
+    std::suspend_never final_suspend() const noexcept { return {}; }
+    void return_void() const noexcept {}
+    void unhandled_exception() const noexcept { std::terminate(); }
+  };
+};
+
+class ScheduleOnAwaiter;
+
+/// Marks the thread that is inside `ScheduleOnAwaiter::await_suspend`, so that
+/// a task dropped synchronously by `AddTask` is told apart from one run or
+/// dropped by another thread. Lives on the stack of `await_suspend`, not in the
+/// coroutine frame, which may be gone by the time `AddTask` returns.
+class ScheduleOnScope {
+ public:
+  explicit ScheduleOnScope(const ScheduleOnAwaiter* awaiter) noexcept;
+  ScheduleOnScope(const ScheduleOnScope&) = delete;
+  ScheduleOnScope& operator=(const ScheduleOnScope&) = delete;
+  ~ScheduleOnScope();
+
+  /// Innermost scope of the calling thread, `nullptr` if there is none.
+  static ScheduleOnScope* Current() noexcept;
+
+  const ScheduleOnAwaiter* awaiter() const noexcept { return awaiter_; }
+
+  bool dropped() const noexcept { return dropped_; }
+  void SetDropped() noexcept { dropped_ = true; }
+
+ private:
+  const ScheduleOnAwaiter* awaiter_;
+  ScheduleOnScope* outer_;
+  bool dropped_ = false;
+};
+
+class ScheduleOnAwaiter {
+  /// Owns the suspended coroutine while it's queued. An executor that drops
+  /// it instead of running it (cancelled, shed or stopped) resumes the
+  /// coroutine right away, with `TaskCancelledError` thrown from the
+  /// `co_await`, so that neither the frame nor the futures waiting on it are
+  /// left behind.
+  class Resumer {
+   public:
+    Resumer(ScheduleOnAwaiter* const awaiter,
+            const std::coroutine_handle<> handle) noexcept
+        : awaiter_(awaiter), handle_(handle) {}
+    Resumer(const Resumer&) = delete;
+    Resumer& operator=(const Resumer&) = delete;
+    Resumer(Resumer&& other) noexcept
+        : awaiter_(std::exchange(other.awaiter_, nullptr)),
+          handle_(other.handle_) {}
+    Resumer& operator=(Resumer&&) = delete;
+    ~Resumer() {
+      auto* const awaiter = std::exchange(awaiter_, nullptr);
+      if (awaiter == nullptr) {
+        return;
+      }
+
+      awaiter->cancelled_ = true;
+      // Dropped by `AddTask` before it returned: the coroutine must not
+      // resume under the executor, `await_suspend` resumes it instead.
+      auto* const scope = ScheduleOnScope::Current();
+      if (scope != nullptr && scope->awaiter() == awaiter) {
+        scope->SetDropped();
+        return;
+      }
+
+      handle_.resume();
+    }
+
+    void operator()() && {
+      awaiter_ = nullptr;
+      handle_.resume();
+    }
+
+   private:
+    ScheduleOnAwaiter* awaiter_;
+    std::coroutine_handle<> handle_;
+  };
+
+ public:
+  ScheduleOnAwaiter(IExecutor& executor, const TaskOptions& options) noexcept
+      : executor_(executor), options_(options) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(const std::coroutine_handle<> handle) noexcept {
+    bool dropped = false;
+    {
+      ScheduleOnScope scope(this);
+      executor_.AddTask(Resumer(this, handle), options_);
+      dropped = scope.dropped();
+    }
+    // The task may already have run on the executor and the frame may be
+    // gone: `this` is not touched past this point. Only a task dropped before
+    // `AddTask` returned continues on the calling thread.
+    if (dropped) {
+      handle.resume();
+    }
+  }
+
+  void await_resume() const {
+    if (cancelled_) {
+      throw TaskCancelledError();
+    }
+  }
+
+ private:
+  IExecutor& executor_;
+  const TaskOptions options_;
+  bool cancelled_ = false;
+};
+
+template <typename T>
+DetachedCoroutine Drive(IExecutor* executor, Task<T> task,
+                        Promise<T> promise);
+
+}  // namespace internal_executor
+
+/// Lazily started coroutine producing a `T`. It runs once awaited, and resumes
+/// its awaiter right when it finishes, on whatever thread it finished on.
+/// Frames are allocated from a per-thread pool.
+///
+/// Use `Start` or `StartOn` to run a task from outside of a coroutine.
+template <typename T>
+class [[nodiscard]] Task {
+  using Handle = std::coroutine_handle<internal_executor::TaskPromise<T>>;
+
+ public:
+  using promise_type = internal_executor::TaskPromise<T>;
+
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+  Task(Task&& other) noexcept
+      : handle_(std::exchange(other.handle_, nullptr)) {}
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+  }
+  ~Task() { Reset(); }
+
+  auto operator co_await() && noexcept {
+    struct Awaiter {
+      Handle handle;
+
+      bool await_ready() const noexcept { return false; }
+
+      std::coroutine_handle<> await_suspend(
+          const std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().SetContinuation(awaiting);
+        return handle;
+      }
+
+      T await_resume() {
+        if constexpr (std::is_void_v<T>) {
+          handle.promise().TakeValue();
+        } else {
+          return handle.promise().TakeValue();
+        }
+      }
+    };
+
+    return Awaiter{handle_};
+  }
+
+ private:
+  friend class internal_executor::TaskPromise<T>;
+
+  explicit Task(const Handle handle) noexcept : handle_(handle) {}
+
+  void Reset() noexcept {
+    if (handle_) {
+      std::exchange(handle_, nullptr).destroy();
+    }
+  }
+
+ private:
+  Handle handle_;
+};
+
+/// Suspends the awaiting coroutine and resumes it on `executor`. If the
+/// executor drops the task instead of running it (`options.cancellation`,
+/// load shedding, `stop`), the coroutine is resumed on the thread that
+/// dropped it and the `co_await` throws `TaskCancelledError`.
+inline internal_executor::ScheduleOnAwaiter ScheduleOn(
+    IExecutor& executor, const TaskOptions& options = {}) noexcept {
+  internal_executor::ScheduleOnAwaiter res(executor, options);
+  return res;
+}
+
+/// Runs `task` on the calling thread until it first suspends.
+template <typename T>
+Future<T> Start(Task<T> task) {
+  Promise<T> promise;
+  auto res = promise.GetFuture();
+  internal_executor::Drive<T>(nullptr, std::move(task), std::move(promise));
+  return res;
+}
+
+/// Runs `task` on `executor`.
+template <typename T>
+Future<T> StartOn(IExecutor& executor, Task<T> task) {
+  Promise<T> promise;
+  auto res = promise.GetFuture();
+  internal_executor::Drive<T>(&executor, std::move(task), std::move(promise));
+  return res;
+}
+
+/// Impl
+
+namespace internal_executor {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept {
+  Task<T> res(std::coroutine_handle<TaskPromise>::from_promise(*this));
+  return res;
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+  Task<void> res(std::coroutine_handle<TaskPromise>::from_promise(*this));
+  return res;
+}
+
+template <typename T>
+DetachedCoroutine Drive(IExecutor* const executor, Task<T> task,
+                        Promise<T> promise) {
+  try {
+    if (executor != nullptr) {
+      co_await ScheduleOn(*executor);
+    }
+
+    if constexpr (std::is_void_v<T>) {
+      co_await std::move(task);
+      promise.SetValue();
+    } else {
+      promise.SetValue(co_await std::move(task));
+    }
+  } catch (...) {
+    promise.SetException(std::current_exception());
+  }
+}
+
+}  // namespace internal_executor
+
+}  // namespace handbag
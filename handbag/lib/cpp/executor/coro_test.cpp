@@ -0,0 +1,226 @@
+#include "lib/cpp/executor/coro.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lib/cpp/executor/cancellation.h"
+#include "lib/cpp/executor/cpu.h"
+#include "lib/cpp/executor/executor.h"
+#include "lib/cpp/executor/internal/frame_pool.h"
+
+using namespace ::testing;
+
+namespace handbag::tests {
+namespace {
+
+Task<int> Constant(const int value) { co_return value; }
+
+Task<int64_t> Sum(const int count) {
+  int64_t res = 0;
+  for (int i = 0; i < count; ++i) {
+    res += co_await Constant(i);
+  }
+  co_return res;
+}
+
+Task<void> Throw() {
+  throw std::runtime_error("NEEDLE");
+  co_return;
+}
+
+Task<std::string> Rethrow() {
+  co_await Throw();
+  co_return "unreachable";
+}
+
+Task<std::thread::id> HopTo(IExecutor& executor) {
+  co_await ScheduleOn(executor);
+  co_return std::this_thread::get_id();
+}
+
+// Hops back and forth, so every hop is submitted from outside of the executor
+// it goes to.
+Task<int> CountMissedHops(IExecutor& first, IExecutor& second,
+                          const int count) {
+  int res = 0;
+  for (int i = 0; i < count; ++i) {
+    auto& executor = i % 2 == 0 ? first : second;
+    co_await ScheduleOn(executor);
+    if (!IsCurrentThreadIn(executor)) {
+      ++res;
+    }
+  }
+  co_return res;
+}
+
+// The options are named: gcc 12 destroys aggregate temporaries of a
+// `co_await` expression twice.
+Task<int> HopCancelled(IExecutor& executor, const CancellationToken token) {
+  const TaskOptions options{.cancellation = token};
+  co_await ScheduleOn(executor, options);
+  co_return 1;
+}
+
+Task<bool> CatchCancelled(IExecutor& executor, const CancellationToken token) {
+  const TaskOptions options{.cancellation = token};
+  try {
+    co_await ScheduleOn(executor, options);
+  } catch (const TaskCancelledError&) {
+    co_return true;
+  }
+  co_return false;
+}
+
+Task<int> AwaitFuture(IExecutor& executor) {
+  const auto value = co_await AddTo(executor, [] { return 20; });
+  co_return value + co_await AddTo(executor, [] { return 22; });
+}
+
+Task<int> Square(IExecutor& executor, const int value) {
+  co_await ScheduleOn(executor);
+  co_return value * value;
+}
+
+Task<int> FanOut(IExecutor& executor, const int count) {
+  std::vector<Future<int>> parts;
+  for (int i = 0; i < count; ++i) {
+    parts.push_back(StartOn(executor, Square(executor, i)));
+  }
+
+  int res = 0;
+  for (auto& part : parts) {
+    res += co_await std::move(part);
+  }
+  co_return res;
+}
+
+TEST(CoroTest, Start) {
+  auto future = Start(Constant(42));
+  EXPECT_TRUE(future.IsReady());
+  EXPECT_THAT(future.Get(), Eq(42));
+}
+
+TEST(CoroTest, LongChainOfSynchronousTasks) {
+  EXPECT_THAT(Start(Sum(10000)).Get(), Eq(int64_t{49995000}));
+}
+
+TEST(CoroTest, Exceptions) {
+  EXPECT_THAT([] { Start(Rethrow()).Get(); },
+              ThrowsMessage<std::runtime_error>(Eq("NEEDLE")));
+}
+
+TEST(CoroTest, ScheduleOn) {
+  auto executor = executor::CpuExecutor::create({.thread_count = 2});
+
+  EXPECT_THAT(Start(HopTo(*executor)).Get(), Ne(std::this_thread::get_id()));
+
+  executor->stop().get();
+}
+
+TEST(CoroTest, ScheduleOnAlwaysContinuesOnExecutor) {
+  auto first = executor::CpuExecutor::create({.thread_count = 2});
+  auto second = executor::CpuExecutor::create({.thread_count = 2});
+
+  // Workers often pick a hop up while it's still being submitted.
+  EXPECT_THAT(Start(CountMissedHops(*first, *second, 20000)).Get(), Eq(0));
+
+  first->stop().get();
+  second->stop().get();
+}
+
+TEST(CoroTest, ScheduleOnTaskRunBeforeAddReturns) {
+  // Runs every task on a thread of its own, and returns once it's done.
+  struct Joining final : IExecutor {
+    void Add(absl::AnyInvocable<void() &&> task) noexcept override {
+      std::thread([&task] { std::move(task)(); }).join();
+    }
+    bool TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept override {
+      Add(std::move(task));
+      return true;
+    }
+  } joining;
+
+  EXPECT_THAT(Start(HopTo(joining)).Get(), Ne(std::this_thread::get_id()));
+}
+
+TEST(CoroTest, CancelledScheduleOn) {
+  auto executor = executor::CpuExecutor::create({.thread_count = 2});
+  CancellationSource source;
+  source.Cancel();
+
+  // The dropped resumption fails the awaiting coroutine instead of leaking it.
+  auto future = StartOn(*executor, HopCancelled(*executor, source.GetToken()));
+  EXPECT_THROW(future.Get(), TaskCancelledError);
+  EXPECT_TRUE(
+      StartOn(*executor, CatchCancelled(*executor, source.GetToken())).Get());
+  EXPECT_FALSE(
+      StartOn(*executor, CatchCancelled(*executor, CancellationToken())).Get());
+
+  executor->stop().get();
+}
+
+TEST(CoroTest, AwaitFuture) {
+  auto executor = executor::CpuExecutor::create({.thread_count = 2});
+
+  EXPECT_THAT(StartOn(*executor, AwaitFuture(*executor)).Get(), Eq(42));
+
+  executor->stop().get();
+}
+
+TEST(CoroTest, FanOut) {
+  auto executor = executor::CpuExecutor::create({.thread_count = 4});
+
+  int expected = 0;
+  for (int i = 0; i < 100; ++i) {
+    expected += i * i;
+  }
+  EXPECT_THAT(StartOn(*executor, FanOut(*executor, 100)).Get(), Eq(expected));
+
+  executor->stop().get();
+}
+
+TEST(CoroTest, FramePoolReusesFrames) {
+  auto* const frame = internal_executor::AllocateFrame(200);
+  internal_executor::DeallocateFrame(frame, 200);
+  // Same size class.
+  auto* const reused = internal_executor::AllocateFrame(220);
+  EXPECT_THAT(reused, Eq(frame));
+  internal_executor::DeallocateFrame(reused, 220);
+
+  auto* const large = internal_executor::AllocateFrame(1 << 20);
+  internal_executor::DeallocateFrame(large, 1 << 20);
+}
+
+TEST(CoroTest, FramePoolTakesBackFramesFreedElsewhere) {
+  // Larger than the coroutines here, so that this thread has none cached.
+  auto* const frame = internal_executor::AllocateFrame(900);
+  std::thread([frame] { internal_executor::DeallocateFrame(frame, 900); })
+      .join();
+  EXPECT_THAT(internal_executor::AllocateFrame(900), Eq(frame));
+  internal_executor::DeallocateFrame(frame, 900);
+}
+
+TEST(CoroTest, FramePoolOutlivesExitedThread) {
+  std::vector<void*> frames;
+  std::thread([&frames] {
+    for (int i = 0; i < 3; ++i) {
+      frames.push_back(internal_executor::AllocateFrame(400));
+    }
+    internal_executor::DeallocateFrame(frames.back(), 400);
+    frames.pop_back();
+  }).join();
+
+  // Freed straight away, the owner's lists are gone.
+  for (auto* const frame : frames) {
+    internal_executor::DeallocateFrame(frame, 400);
+  }
+}
+
+}  // namespace
+}  // namespace handbag::tests
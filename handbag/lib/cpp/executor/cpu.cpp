@@ -1,24 +1,462 @@
 #include "lib/cpp/executor/cpu.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
 #include <exception>
+#include <functional>
 #include <future>
-#include <queue>
+#include <latch>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
 #include <thread>
+#include <type_traits>
+#include <vector>
 
 #include "absl/base/optimization.h"
 #include "absl/base/thread_annotations.h"
+#include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "lib/cpp/executor/internal/mpmc_queue.h"
+#include "lib/cpp/executor/internal/parking.h"
+#include "lib/cpp/executor/internal/stats.h"
+#include "lib/cpp/executor/internal/topology.h"
 #include "lib/cpp/repr/repr.h"
 #include "lib/cpp/start_stop/state.h"
 
 namespace handbag::executor {
 
 namespace {
+using Task = absl::AnyInvocable<void() &&>;
+
+constexpr size_t kDefaultStarvationGuardInterval = 16;
+constexpr absl::Duration kDefaultSpinTime = absl::Microseconds(20);
+constexpr absl::Duration kDefaultIdleTimeout = absl::Seconds(10);
+// A worker takes the task in its next slot at most this many times in a row
+// before it looks at the rest of its queue.
+constexpr size_t kMaxNextPicks = 3;
+// Thieves leave a task in the next slot alone for this long: it is usually
+// the continuation of the task its worker is running, and the data is still
+// in that worker's cache.
+constexpr absl::Duration kNextStealDelay = absl::Microseconds(3);
+// Lane of the unbounded executor that all workers share.
+constexpr size_t kUrgentLane = static_cast<size_t>(ETaskPriority::High);
+// Lane of the bounded executor that goes through the lock-free ring.
+constexpr size_t kRingLane = static_cast<size_t>(ETaskPriority::Normal);
+
 struct Params {
   std::string name;
   size_t thread_count = 0;
+  size_t min_thread_count = 0;
+  absl::Duration idle_timeout;
+  absl::Duration spin_time;
+  std::vector<size_t> cpus;
+  bool pinned = false;
+  bool numa_aware = false;
   size_t queue_capacity = 0;
+  size_t queue_memory_budget = 0;
+  size_t starvation_guard_interval = 0;
+  absl::Duration max_queue_time;
+  size_t max_compensating_thread_count = 0;
+};
+
+struct QueuedTask {
+  ExecutorTask task;
+  absl::Time deadline = absl::InfiniteFuture();
+  CancellationToken cancellation = {};
+  // `internal_executor::NowNanos()` at submission.
+  uint64_t enqueued_at = 0;
+  // Counted against `queue_memory_budget`.
+  size_t size_bytes = 0;
+  // Empty for tasks that aren't accounted per label.
+  std::string_view label = {};
+};
+
+QueuedTask MakeQueuedTask(ExecutorTask&& task, const TaskOptions& options) {
+  QueuedTask res{
+      .task = std::move(task),
+      .deadline = options.deadline.value_or(absl::InfiniteFuture()),
+      .cancellation = options.cancellation.value_or(CancellationToken()),
+      .enqueued_at = internal_executor::NowNanos(),
+      .label = options.label.value_or(std::string_view())};
+  res.size_bytes = options.size_bytes.has_value() ? options.size_bytes.value()
+                                                  : res.task.GetSize();
+  return res;
+}
+
+/// The task a `QueuedTask` was made of, for handing back a rejected one.
+template <typename T>
+T TakeBack(ExecutorTask& task) noexcept {
+  if constexpr (std::is_same_v<T, ExecutorTask>) {
+    return std::move(task);
+  } else {
+    return std::move(*task.target<T>());
+  }
+}
+
+size_t LaneIndex(const TaskOptions& options) noexcept {
+  auto res =
+      static_cast<size_t>(options.priority.value_or(ETaskPriority::Normal));
+  return res;
+}
+
+/// Lanes are scanned from the highest priority down, or from the lowest up
+/// when `lowest_first` is set.
+template <typename Invocable>
+bool ForEachLane(const bool lowest_first, Invocable&& invocable) {
+  for (size_t i = 0; i < kTaskPriorityCount; ++i) {
+    const auto lane = lowest_first ? kTaskPriorityCount - 1 - i : i;
+    if (invocable(lane)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/// Tasks of a single priority. Tasks with a deadline are kept in a min-heap
+/// and go first, the rest are FIFO.
+class Lane {
+ public:
+  bool IsEmpty() const noexcept {
+    auto res = fifo_.empty() && edf_.empty();
+    return res;
+  }
+
+  void Push(QueuedTask&& task) {
+    if (task.deadline == absl::InfiniteFuture()) {
+      fifo_.push_back(std::move(task));
+    } else {
+      edf_.push_back(std::move(task));
+      std::push_heap(edf_.begin(), edf_.end(), &Lane::IsLater);
+    }
+  }
+
+  /// Must not be empty.
+  QueuedTask Pop() {
+    if (!edf_.empty()) {
+      std::pop_heap(edf_.begin(), edf_.end(), &Lane::IsLater);
+      auto res = std::move(edf_.back());
+      edf_.pop_back();
+      return res;
+    }
+
+    auto res = std::move(fifo_.front());
+    fifo_.pop_front();
+    return res;
+  }
+
+  size_t size() const noexcept { return fifo_.size() + edf_.size(); }
+
+ private:
+  static bool IsLater(const QueuedTask& lhs, const QueuedTask& rhs) noexcept {
+    auto res = lhs.deadline > rhs.deadline;
+    return res;
+  }
+
+ private:
+  std::deque<QueuedTask> fifo_;
+  std::vector<QueuedTask> edf_;
+};
+
+/// Queue owned by a single worker, one lane per priority. The owner pushes to
+/// the back and pops from the front, thieves take up to a half of the most
+/// important non-empty lane. The lock is only contended when somebody steals
+/// from the worker.
+///
+/// Tasks the worker submits itself go to its next slot instead (LIFO): it
+/// runs them right after the current one, while their data is still in cache.
+class alignas(ABSL_CACHELINE_SIZE) WorkerQueue {
+ public:
+  void Push(const size_t lane, QueuedTask&& task) {
+    const absl::MutexLock lock(&mutex_);
+    lanes_[lane].Push(std::move(task));
+    size_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /// Owner only. A task already in the slot goes to the back of its lane.
+  void PushNext(const size_t lane, QueuedTask&& task) {
+    const absl::MutexLock lock(&mutex_);
+    if (next_.has_value()) {
+      lanes_[next_lane_].Push(std::move(*next_));
+    }
+    next_ = std::move(task);
+    next_lane_ = lane;
+    has_next_.store(true, std::memory_order_relaxed);
+    size_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /// Returns the memory held by the tasks.
+  template <typename T>
+  uint64_t PushBatch(const std::span<T> tasks, const uint64_t enqueued_at) {
+    const absl::MutexLock lock(&mutex_);
+    auto& lane = lanes_[static_cast<size_t>(ETaskPriority::Normal)];
+    uint64_t res = 0;
+    for (auto& task : tasks) {
+      QueuedTask queued{.task = std::move(task), .enqueued_at = enqueued_at};
+      queued.size_bytes = queued.task.GetSize();
+      res += queued.size_bytes;
+      lane.Push(std::move(queued));
+    }
+    size_.fetch_add(tasks.size(), std::memory_order_relaxed);
+    return res;
+  }
+
+  /// Owner only. The next slot goes first if `prefer_next` is set and no
+  /// more important task is queued, and last otherwise.
+  bool TryPop(const bool lowest_first, const bool prefer_next,
+              QueuedTask& task, bool& from_next) {
+    if (IsEmpty()) {
+      return false;
+    }
+
+    const absl::MutexLock lock(&mutex_);
+    if (next_.has_value() && prefer_next && !lowest_first &&
+        !HasMoreImportantThan(next_lane_)) {
+      from_next = true;
+      TakeNext(task);
+      return true;
+    }
+
+    auto res = ForEachLane(lowest_first, [&](const size_t lane) {
+      if (lanes_[lane].IsEmpty()) {
+        return false;
+      }
+
+      task = lanes_[lane].Pop();
+      size_.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    });
+    if (!res && next_.has_value()) {
+      from_next = true;
+      TakeNext(task);
+      res = true;
+    }
+
+    return res;
+  }
+
+  bool HasNext() const noexcept {
+    auto res = has_next_.load(std::memory_order_relaxed);
+    return res;
+  }
+
+  bool StealNext(QueuedTask& task) {
+    if (!HasNext()) {
+      return false;
+    }
+
+    const absl::MutexLock lock(&mutex_);
+    if (!next_.has_value()) {
+      return false;
+    }
+
+    TakeNext(task);
+    return true;
+  }
+
+  /// Returns the lane the tasks were taken from. Leaves the next slot alone.
+  size_t StealHalf(std::vector<QueuedTask>& dst) {
+    if (IsEmpty()) {
+      return 0;
+    }
+
+    const absl::MutexLock lock(&mutex_);
+    size_t res = 0;
+    ForEachLane(false, [&](const size_t lane) {
+      if (lanes_[lane].IsEmpty()) {
+        return false;
+      }
+
+      const auto count = (lanes_[lane].size() + 1) / 2;
+      for (size_t i = 0; i < count; ++i) {
+        dst.push_back(lanes_[lane].Pop());
+      }
+      size_.fetch_sub(count, std::memory_order_relaxed);
+      res = lane;
+      return true;
+    });
+    return res;
+  }
+
+ private:
+  bool IsEmpty() const noexcept {
+    auto res = size_.load(std::memory_order_relaxed) == 0;
+    return res;
+  }
+
+  bool HasMoreImportantThan(const size_t lane) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    for (size_t i = 0; i < lane; ++i) {
+      if (!lanes_[i].IsEmpty()) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  void TakeNext(QueuedTask& task) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    task = std::move(*next_);
+    next_.reset();
+    has_next_.store(false, std::memory_order_relaxed);
+    size_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+ private:
+  absl::Mutex mutex_;
+  std::array<Lane, kTaskPriorityCount> lanes_ ABSL_GUARDED_BY(mutex_);
+  std::optional<QueuedTask> next_ ABSL_GUARDED_BY(mutex_);
+  size_t next_lane_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Lets thieves skip empty queues without taking the lock.
+  std::atomic<size_t> size_ = 0;
+  std::atomic<bool> has_next_ = false;
+};
+
+/// High priority tasks of all producers, which every worker checks before its
+/// own queue: an urgent task must not wait behind a long task of the worker
+/// it happened to be pushed to while the other workers run their backlogs.
+/// Also holds the tasks a bounded executor doesn't put into its ring.
+class alignas(ABSL_CACHELINE_SIZE) SharedLane {
+ public:
+  void Push(QueuedTask&& task) {
+    const absl::MutexLock lock(&mutex_);
+    lane_.Push(std::move(task));
+    size_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  bool TryPop(QueuedTask& task) {
+    if (size_.load(std::memory_order_relaxed) == 0) {
+      return false;
+    }
+
+    const absl::MutexLock lock(&mutex_);
+    if (lane_.IsEmpty()) {
+      return false;
+    }
+
+    task = lane_.Pop();
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+ private:
+  absl::Mutex mutex_;
+  Lane lane_ ABSL_GUARDED_BY(mutex_);
+  // Lets workers skip the lock while there are no urgent tasks.
+  std::atomic<size_t> size_ = 0;
+};
+
+struct WorkerPlacement {
+  size_t node = 0;
+  // Empty if the worker is not pinned.
+  std::vector<size_t> cpus;
+  // Workers to steal from, the ones on the same node first.
+  std::vector<size_t> victims;
+  // Set by the worker before it reports being ready.
+  bool pin_failed = false;
+};
+
+/// Spreads `thread_count` workers over `nodes` in proportion to the number of
+/// their CPUs.
+std::vector<WorkerPlacement> PlaceWorkers(
+    const std::vector<internal_executor::NumaNode>& nodes,
+    const size_t thread_count, const bool pinned) {
+  std::vector<size_t> cpu_nodes;
+  for (size_t node = 0; node < nodes.size(); ++node) {
+    cpu_nodes.insert(cpu_nodes.end(), nodes[node].cpus.size(), node);
+  }
+
+  std::vector<WorkerPlacement> res(thread_count);
+  for (size_t i = 0; i < thread_count; ++i) {
+    res[i].node = cpu_nodes[i * cpu_nodes.size() / thread_count];
+    if (pinned) {
+      res[i].cpus = nodes[res[i].node].cpus;
+    }
+  }
+
+  for (size_t i = 0; i < thread_count; ++i) {
+    for (const bool local : {true, false}) {
+      for (size_t offset = 1; offset < thread_count; ++offset) {
+        const auto victim = (i + offset) % thread_count;
+        if ((res[victim].node == res[i].node) == local) {
+          res[i].victims.push_back(victim);
+        }
+      }
+    }
+  }
+
+  return res;
+}
+
+std::vector<internal_executor::NumaNode> GetNodes(const Params& params) {
+  if (!params.numa_aware) {
+    return {{.cpus = params.cpus}};
+  }
+
+  std::vector<internal_executor::NumaNode> res;
+  for (auto& node : internal_executor::GetNumaNodes()) {
+    std::erase_if(node.cpus, [&](const size_t cpu) {
+      return std::find(params.cpus.begin(), params.cpus.end(), cpu) ==
+             params.cpus.end();
+    });
+    if (!node.cpus.empty()) {
+      res.push_back(std::move(node));
+    }
+  }
+
+  if (res.empty()) {
+    res.push_back({.cpus = params.cpus});
+  }
+
+  return res;
+}
+
+enum class EIdleResult {
+  Work,
+  Stop,
+  Retire,
+};
+
+struct WorkerContext {
+  void* owner = nullptr;
+  size_t index = 0;
+  // Nesting level of `ScopedBlockingRegion`s on this worker.
+  size_t blocking_depth = 0;
+};
+
+thread_local WorkerContext current_worker;
+
+/// Written only by the owning worker, read by `GetStats()`.
+struct alignas(ABSL_CACHELINE_SIZE) WorkerStats {
+  std::atomic<uint64_t> started = 0;
+  std::atomic<uint64_t> started_bytes = 0;
+  std::atomic<uint64_t> completed = 0;
+  std::atomic<uint64_t> failed = 0;
+  std::atomic<uint64_t> cancelled = 0;
+  std::atomic<uint64_t> shed = 0;
+  internal_executor::OwnedDurationHistogram queue_wait;
+  internal_executor::OwnedDurationHistogram run_time;
+  internal_executor::OwnedLabelTable labels;
+};
+
+/// Submission counters, sharded to keep producers from contending on a single
+/// cache line.
+struct alignas(ABSL_CACHELINE_SIZE) ProducerStats {
+  std::atomic<uint64_t> submitted = 0;
+  std::atomic<uint64_t> submitted_bytes = 0;
+  std::atomic<uint64_t> rejected = 0;
+};
+
+struct alignas(ABSL_CACHELINE_SIZE) WorkerParker {
+  internal_executor::Parker parker;
 };
 }  // namespace
 
@@ -27,107 +465,1011 @@ class CpuExecutor::Impl final : public IExecutor,
                                 public IRepr,
                                 public start_stop::StoppableState {
  public:
-  Impl(const CpuExecutorParams& params)
-      : params_{
+  Impl(const IExecutor* const owner, const CpuExecutorParams& params)
+      : owner_(owner),
+        params_{
             .name = params.name.has_value() ? params.name.value() : "CpuExec",
-            .thread_count = params.thread_count > 0
-                                ? params.thread_count.value()
-                                : std::thread::hardware_concurrency(),
-            .queue_capacity = params.queue_capacity.has_value()
-                                  ? params.queue_capacity.value()
-                                  : std::numeric_limits<size_t>::max()} {
-    workers_.reserve(params_.thread_count);
-    for (size_t i = 0; i < params_.thread_count; ++i) {
-      auto worker = std::async(std::launch::async, &Impl::WorkerTask, this);
-      workers_.push_back(std::move(worker));
+            .idle_timeout = params.idle_timeout.value_or(kDefaultIdleTimeout),
+            .spin_time = params.spin_time.value_or(kDefaultSpinTime),
+            .cpus = params.cpus.has_value() && !params.cpus->empty()
+                        ? params.cpus.value()
+                        : internal_executor::GetAvailableCpus(),
+            .pinned = params.cpus.has_value() ||
+                      params.numa_aware.value_or(false),
+            .numa_aware = params.numa_aware.value_or(false),
+            // A zero capacity queue would never accept anything.
+            .queue_capacity =
+                params.queue_capacity.has_value()
+                    ? std::max<size_t>(params.queue_capacity.value(), 1)
+                    : std::numeric_limits<size_t>::max(),
+            .queue_memory_budget = params.queue_memory_budget.value_or(
+                std::numeric_limits<size_t>::max()),
+            .starvation_guard_interval =
+                params.starvation_guard_interval > 0
+                    ? params.starvation_guard_interval.value()
+                    : kDefaultStarvationGuardInterval,
+            .max_queue_time =
+                params.max_queue_time.value_or(absl::InfiniteDuration()),
+            .max_compensating_thread_count =
+                params.max_compensating_thread_count.value_or(0)} {
+    params_.thread_count = params.thread_count > 0
+                               ? params.thread_count.value()
+                               : params_.cpus.size();
+    params_.min_thread_count =
+        params.min_thread_count > 0
+            ? std::min(params.min_thread_count.value(), params_.thread_count)
+            : params_.thread_count;
+    max_queue_nanos_ =
+        params_.max_queue_time == absl::InfiniteDuration()
+            ? std::numeric_limits<uint64_t>::max()
+            : static_cast<uint64_t>(std::max<int64_t>(
+                  absl::ToInt64Nanoseconds(params_.max_queue_time), 0));
+    placements_ =
+        PlaceWorkers(GetNodes(params_), SlotCount(), params_.pinned);
+
+    if (params.queue_capacity.has_value()) {
+      bounded_ =
+          std::make_unique<internal_executor::BoundedMpmcQueue<QueuedTask>>(
+              params_.queue_capacity);
+    } else {
+      queues_.resize(SlotCount());
+    }
+
+    worker_stats_.resize(SlotCount());
+    // Workers use their own shard, other threads share the second half.
+    producer_stats_ = std::make_unique<ProducerStats[]>(2 * SlotCount());
+    parkers_ = std::make_unique<WorkerParker[]>(SlotCount());
+    is_idle_.resize(SlotCount());
+    idle_.reserve(SlotCount());
+
+    // Slots of the workers an elastic executor doesn't start right away, and
+    // of the compensating ones, are set up here; their workers may be started
+    // at any time later.
+    for (size_t i = params_.min_thread_count; i < SlotCount(); ++i) {
+      if (!IsBounded()) {
+        queues_[i] = std::make_unique<WorkerQueue>();
+      }
+      worker_stats_[i] = std::make_unique<WorkerStats>();
+      free_slots_.push_back(i);
+    }
+    // Lowest slots are reused first.
+    std::reverse(free_slots_.begin(), free_slots_.end());
+
+    // Workers allocate their own queues once pinned, so the memory ends up
+    // on their node; nothing may be submitted or stolen before that.
+    ready_.emplace(static_cast<std::ptrdiff_t>(params_.min_thread_count));
+    workers_.resize(SlotCount());
+    live_workers_ = params_.min_thread_count;
+    for (size_t i = 0; i < params_.min_thread_count; ++i) {
+      workers_[i] =
+          std::async(std::launch::async, &Impl::WorkerTask, this, i, true);
+    }
+    ready_->wait();
+
+    for (size_t i = 0; i < SlotCount(); ++i) {
+      if (placements_[i].pin_failed) {
+        LOG(WARNING) << *this << "; failed to pin worker " << i;
+      }
     }
   }
 
   void Add(absl::AnyInvocable<void() &&> task) noexcept override {
-    const absl::MutexLock lock(&mutex_);
-    if (!HasSpareCapacity()) {
-      mutex_.Await(absl::Condition(this, &Impl::HasSpareCapacity));
+    Add(std::move(task), TaskOptions());
+  }
+
+  bool TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept override {
+    auto res = TryAdd(std::move(task), TaskOptions());
+    return res;
+  }
+
+  void Add(absl::AnyInvocable<void() &&> task,
+           const TaskOptions& options) noexcept override {
+    AddTask(std::move(task), options);
+  }
+
+  void AddTask(ExecutorTask task,
+               const TaskOptions& options) noexcept override {
+    const auto lane = LaneIndex(options);
+    auto queued = MakeQueuedTask(std::move(task), options);
+    auto& shard = ProducerShard();
+    shard.submitted.fetch_add(1, std::memory_order_relaxed);
+    shard.submitted_bytes.fetch_add(queued.size_bytes,
+                                    std::memory_order_relaxed);
+    if (HasMemoryBudget()) {
+      ReserveMemory(queued.size_bytes);
+    }
+    if (!IsBounded()) {
+      Push(lane, std::move(queued), options);
+      return;
     }
 
-    tasks_.push(std::move(task));
+    if (TryAdmit(1) == 0) {
+      blocked_producers_.fetch_add(1);
+      for (;;) {
+        const auto epoch = space_epoch_.load();
+        if (TryAdmit(1) > 0) {
+          break;
+        }
+
+        space_epoch_.wait(epoch);
+      }
+      blocked_producers_.fetch_sub(1);
+    }
+
+    PushBounded(lane, std::move(queued));
+    Wake(1);
   }
 
-  bool TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept override {
-    const absl::MutexLock lock(&mutex_);
-    if (!HasSpareCapacity()) {
+  bool TryAdd(absl::AnyInvocable<void() &&>&& task,
+              const TaskOptions& options) noexcept override {
+    ExecutorTask wrapped(std::move(task));
+    auto res = TryAddTask(std::move(wrapped), options);
+    if (!res) {
+      task = TakeBack<Task>(wrapped);
+    }
+    return res;
+  }
+
+  bool TryAddTask(ExecutorTask&& task,
+                  const TaskOptions& options) noexcept override {
+    if (!IsBounded() && !HasMemoryBudget()) {
+      AddTask(std::move(task), options);
+      return true;
+    }
+
+    const auto lane = LaneIndex(options);
+    auto queued = MakeQueuedTask(std::move(task), options);
+    const auto size_bytes = queued.size_bytes;
+    auto& shard = ProducerShard();
+    const auto reject = [&] {
+      task = std::move(queued.task);
+      shard.rejected.fetch_add(1, std::memory_order_relaxed);
       return false;
+    };
+    if (HasMemoryBudget() && !TryReserveMemory(size_bytes)) {
+      return reject();
+    }
+    if (IsBounded() && TryAdmit(1) == 0) {
+      if (HasMemoryBudget()) {
+        ReleaseMemory(size_bytes);
+      }
+      return reject();
     }
 
-    tasks_.push(std::move(task));
+    shard.submitted.fetch_add(1, std::memory_order_relaxed);
+    shard.submitted_bytes.fetch_add(size_bytes, std::memory_order_relaxed);
+    if (!IsBounded()) {
+      Push(lane, std::move(queued), options);
+      return true;
+    }
 
+    PushBounded(lane, std::move(queued));
+    Wake(1);
     return true;
   }
 
+  void AddBatch(
+      std::span<absl::AnyInvocable<void() &&>> tasks) noexcept override {
+    AddBatchOf(tasks);
+  }
+
+  size_t TryAddBatch(
+      std::span<absl::AnyInvocable<void() &&>> tasks) noexcept override {
+    auto res = TryAddBatchOf(tasks);
+    return res;
+  }
+
+  void AddTaskBatch(std::span<ExecutorTask> tasks) noexcept override {
+    AddBatchOf(tasks);
+  }
+
+  size_t TryAddTaskBatch(std::span<ExecutorTask> tasks) noexcept override {
+    auto res = TryAddBatchOf(tasks);
+    return res;
+  }
+
   std::future<void> stop() override {
     SetStopping();
-
-    const absl::MutexLock lock(&mutex_);
-    for (size_t i = 0; i < params_.thread_count; ++i) {
-      tasks_.push(nullptr);
-    }
+    Wake(SlotCount());
 
     auto res = std::async(std::launch::async, [this]() noexcept {
-      for (auto& worker : workers_) {
-        try {
-          worker.get();
-        } catch (...) {
-          auto eptr = std::current_exception();
-          std::string message;
-          try {
-            std::rethrow_exception(eptr);
-          } catch (const std::exception& exc) {
-            message = exc.what();
+      std::vector<std::future<void>> workers;
+      {
+        // Retiring workers still add their slots to `free_slots_`, but no new
+        // worker is started anymore.
+        const absl::MutexLock lock(&pool_mutex_);
+        workers.swap(retired_);
+        for (auto& worker : workers_) {
+          if (worker.valid()) {
+            workers.push_back(std::move(worker));
           }
-
-          LOG(ERROR) << *this << "; what() = " << message;
         }
       }
 
+      for (auto& worker : workers) {
+        Join(worker);
+      }
+
       SetStopped();
     });
 
     return res;
   }
 
+  Future<void> WhenHasCapacity(const TaskOptions& options) noexcept override {
+    Promise<void> promise;
+    auto res = promise.GetFuture();
+    if (!IsBounded() && !HasMemoryBudget()) {
+      promise.SetValue();
+      return res;
+    }
+
+    {
+      const absl::MutexLock lock(&capacity_mutex_);
+      capacity_waiters_.push_back(std::move(promise));
+      capacity_waiter_count_.fetch_add(1);
+    }
+
+    // Pairs with the fence in `Release`: either it sees the waiter or we see
+    // the space it made.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (HasSpace(options)) {
+      NotifyCapacity();
+    }
+
+    return res;
+  }
+
+  CpuExecutorStats GetStats() const noexcept {
+    CpuExecutorStats res;
+    uint64_t submitted_bytes = 0;
+    for (size_t i = 0; i < 2 * SlotCount(); ++i) {
+      const auto& shard = producer_stats_[i];
+      res.submitted += shard.submitted.load(std::memory_order_relaxed);
+      submitted_bytes +=
+          shard.submitted_bytes.load(std::memory_order_relaxed);
+      res.rejected += shard.rejected.load(std::memory_order_relaxed);
+    }
+
+    uint64_t started = 0;
+    uint64_t started_bytes = 0;
+    for (size_t i = 0; i < SlotCount(); ++i) {
+      const auto& stats = *worker_stats_[i];
+      started += stats.started.load(std::memory_order_relaxed);
+      started_bytes += stats.started_bytes.load(std::memory_order_relaxed);
+      res.completed += stats.completed.load(std::memory_order_relaxed);
+      res.failed += stats.failed.load(std::memory_order_relaxed);
+      res.cancelled += stats.cancelled.load(std::memory_order_relaxed);
+      res.shed += stats.shed.load(std::memory_order_relaxed);
+      stats.queue_wait.CollectInto(res.queue_wait);
+      stats.run_time.CollectInto(res.run_time);
+      stats.labels.CollectInto(res.labels);
+    }
+    std::sort(res.labels.begin(), res.labels.end(),
+              [](const TaskLabelStats& lhs, const TaskLabelStats& rhs) {
+                return lhs.cpu_time > rhs.cpu_time;
+              });
+
+    // Counters are read one by one, so a task may be seen started but not yet
+    // submitted.
+    res.queue_depth = res.submitted > started ? res.submitted - started : 0;
+    res.queued_bytes =
+        submitted_bytes > started_bytes ? submitted_bytes - started_bytes : 0;
+    res.thread_count = live_workers_.load(std::memory_order_relaxed);
+    res.idle_thread_count = sleepers_.load(std::memory_order_relaxed);
+    res.blocked_thread_count = blocked_.load(std::memory_order_relaxed);
+    return res;
+  }
+
   std::string GetRepr() const noexcept override {
+    const auto stats = GetStats();
     return Repr::create("CpuExecutor")
         .field("name", params_.name)
         .field("thread_count", params_.thread_count)
+        .field("min_thread_count", params_.min_thread_count)
+        .field("idle_timeout", params_.idle_timeout)
+        .field("spin_time", params_.spin_time)
+        .field("pinned", params_.pinned)
+        .field("numa_aware", params_.numa_aware)
         .field("queue_capacity", params_.queue_capacity)
+        .field("queue_memory_budget", params_.queue_memory_budget)
+        .field("starvation_guard_interval", params_.starvation_guard_interval)
+        .field("max_queue_time", params_.max_queue_time)
+        .field("max_compensating_thread_count",
+               params_.max_compensating_thread_count)
+        .field("submitted", stats.submitted)
+        .field("rejected", stats.rejected)
+        .field("completed", stats.completed)
+        .field("failed", stats.failed)
+        .field("cancelled", stats.cancelled)
+        .field("shed", stats.shed)
+        .field("queue_depth", stats.queue_depth)
+        .field("queued_bytes", stats.queued_bytes)
+        .field("live_thread_count", stats.thread_count)
+        .field("idle_thread_count", stats.idle_thread_count)
+        .field("blocked_thread_count", stats.blocked_thread_count)
+        .field("queue_wait", stats.queue_wait)
+        .field("run_time", stats.run_time)
         .end();
   }
 
+  void BeginBlocking() noexcept {
+    if (params_.max_compensating_thread_count == 0) {
+      return;
+    }
+
+    blocked_.fetch_add(1);
+    // Without queued tasks there is nothing to compensate for yet, `Wake`
+    // grows the pool once somebody submits.
+    if (HasQueuedTasks()) {
+      Wake(1);
+    }
+  }
+
+  void EndBlocking() noexcept {
+    if (params_.max_compensating_thread_count == 0) {
+      return;
+    }
+
+    blocked_.fetch_sub(1);
+    // A parked surplus worker would otherwise linger until `idle_timeout`.
+    if (live_workers_.load() > TargetThreadCount()) {
+      Wake(1);
+    }
+  }
+
  private:
-  bool HasTasksToRun() const noexcept ABSL_SHARED_LOCKS_REQUIRED(mutex_) {
-    auto res = tasks_.size() > 0;
+  bool IsBounded() const noexcept {
+    auto res = bounded_ != nullptr;
+    return res;
+  }
+
+  /// Worker slots, the compensating ones included.
+  size_t SlotCount() const noexcept {
+    auto res = params_.thread_count + params_.max_compensating_thread_count;
+    return res;
+  }
+
+  /// `thread_count` plus a worker per blocked one, up to the cap.
+  size_t TargetThreadCount() const noexcept {
+    auto res = params_.thread_count +
+               std::min(blocked_.load(), params_.max_compensating_thread_count);
+    return res;
+  }
+
+  bool HasQueuedTasks() const noexcept {
+    auto res = queued_.load() > 0;
     return res;
   }
 
-  bool HasSpareCapacity() const noexcept ABSL_SHARED_LOCKS_REQUIRED(mutex_) {
-    auto res = tasks_.size() < params_.queue_capacity;
+  /// Tasks submitted by our own workers stay on the submitting worker, the
+  /// rest are spread round-robin.
+  WorkerQueue& Queue() noexcept {
+    const auto index =
+        current_worker.owner == this
+            ? current_worker.index
+            : next_queue_.fetch_add(1, std::memory_order_relaxed) %
+                  queues_.size();
+    return *queues_[index];
+  }
+
+  /// Pushes to the unbounded per-worker queues.
+  void Push(const size_t lane, QueuedTask&& queued,
+            const TaskOptions& options) noexcept {
+    queued_.fetch_add(1);
+    // Tasks with a deadline keep their place in the EDF order.
+    if (current_worker.owner == this && !options.yield.value_or(false) &&
+        !options.deadline.has_value()) {
+      queues_[current_worker.index]->PushNext(lane, std::move(queued));
+    } else if (lane == kUrgentLane) {
+      urgent_.Push(std::move(queued));
+    } else {
+      Queue().Push(lane, std::move(queued));
+    }
+    Wake(1);
+  }
+
+  /// Takes places for up to `count` tasks in the bounded queue, returns how
+  /// many it got.
+  size_t TryAdmit(const size_t count) noexcept {
+    const auto capacity = params_.queue_capacity;
+    auto queued = queued_.load();
+    size_t res = 0;
+    do {
+      if (queued >= capacity) {
+        return 0;
+      }
+
+      res = std::min(count, capacity - queued);
+    } while (!queued_.compare_exchange_weak(queued, queued + res));
+
+    return res;
+  }
+
+  /// Pushes an admitted task to the bounded queue. Normal priority tasks
+  /// without a deadline go through the ring, the rest keep their priority
+  /// and EDF order in the locked lanes.
+  void PushBounded(const size_t lane, QueuedTask&& queued) noexcept {
+    if (lane != kRingLane || queued.deadline != absl::InfiniteFuture()) {
+      bounded_lanes_[lane].Push(std::move(queued));
+      return;
+    }
+
+    // The ring has room for every admitted task: a task leaves `queued_` only
+    // after it left the ring.
+    const bool pushed = bounded_->TryPush(std::move(queued));
+    DCHECK(pushed);
+  }
+
+  template <typename T>
+  void AddBatchOf(const std::span<T> tasks) noexcept {
+    // Every task takes its own share of the budget.
+    if (HasMemoryBudget()) {
+      for (auto& task : tasks) {
+        AddTask(std::move(task), TaskOptions());
+      }
+      return;
+    }
+
+    if (!IsBounded()) {
+      auto& shard = ProducerShard();
+      shard.submitted.fetch_add(tasks.size(), std::memory_order_relaxed);
+      queued_.fetch_add(tasks.size());
+      const auto bytes =
+          Queue().PushBatch(tasks, internal_executor::NowNanos());
+      shard.submitted_bytes.fetch_add(bytes, std::memory_order_relaxed);
+      Wake(tasks.size());
+      return;
+    }
+
+    const auto accepted = TryPushBatch(tasks);
+    for (auto& task : tasks.subspan(accepted)) {
+      AddTask(std::move(task), TaskOptions());
+    }
+  }
+
+  template <typename T>
+  size_t TryAddBatchOf(const std::span<T> tasks) noexcept {
+    if (HasMemoryBudget()) {
+      size_t res = 0;
+      while (res < tasks.size() && TryAddOne(tasks[res])) {
+        ++res;
+      }
+      // The first rejected task is counted by `TryAddOne`, the ones behind it
+      // are rejected along with it.
+      if (res + 1 < tasks.size()) {
+        ProducerShard().rejected.fetch_add(tasks.size() - res - 1,
+                                           std::memory_order_relaxed);
+      }
+      return res;
+    }
+
+    if (!IsBounded()) {
+      AddBatchOf(tasks);
+      return tasks.size();
+    }
+
+    auto res = TryPushBatch(tasks);
+    if (res < tasks.size()) {
+      ProducerShard().rejected.fetch_add(tasks.size() - res,
+                                         std::memory_order_relaxed);
+    }
+
     return res;
   }
 
-  void WorkerTask() {
+  bool TryAddOne(Task& task) noexcept {
+    auto res = TryAdd(std::move(task), TaskOptions());
+    return res;
+  }
+
+  bool TryAddOne(ExecutorTask& task) noexcept {
+    auto res = TryAddTask(std::move(task), TaskOptions());
+    return res;
+  }
+
+  /// Pushes a prefix of `tasks` that fits into the bounded queue to its
+  /// ring, the rest are left intact.
+  template <typename T>
+  size_t TryPushBatch(const std::span<T> tasks) noexcept {
+    const auto res = TryAdmit(tasks.size());
+    const auto enqueued_at = internal_executor::NowNanos();
+    uint64_t bytes = 0;
+    for (auto& task : tasks.first(res)) {
+      QueuedTask queued{.task = std::move(task), .enqueued_at = enqueued_at};
+      queued.size_bytes = queued.task.GetSize();
+      bytes += queued.size_bytes;
+      PushBounded(kRingLane, std::move(queued));
+    }
+
+    auto& shard = ProducerShard();
+    shard.submitted.fetch_add(res, std::memory_order_relaxed);
+    shard.submitted_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    Wake(res);
+
+    return res;
+  }
+
+  ProducerStats& ProducerShard() noexcept {
+    if (current_worker.owner == this) {
+      return producer_stats_[current_worker.index];
+    }
+
+    thread_local const size_t hash =
+        std::hash<std::thread::id>()(std::this_thread::get_id());
+    return producer_stats_[SlotCount() + hash % SlotCount()];
+  }
+
+  /// Wakes up to `count` parked workers, the most recently parked first:
+  /// their caches are still warm, and the rest stay idle long enough to
+  /// retire. Starts new workers if there are not enough parked ones.
+  void Wake(size_t count) noexcept {
+    if (count == 0) {
+      return;
+    }
+
+    // Pairs with the fence in `Park`: either the worker sees the new task, or
+    // we see the worker in `idle_`.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load() > 0) {
+      const absl::MutexLock lock(&idle_mutex_);
+      for (; count > 0 && !idle_.empty(); --count) {
+        const auto index = idle_.back();
+        idle_.pop_back();
+        is_idle_[index] = false;
+        parkers_[index].parker.Unpark();
+      }
+      sleepers_.store(idle_.size());
+    }
+
+    if (count > 0 && live_workers_.load() < TargetThreadCount()) {
+      Grow(count);
+    }
+  }
+
+  /// Starts up to `count` workers in the free slots. Workers are started under
+  /// the lock, so that `stop` sees every one of them.
+  void Grow(size_t count) noexcept {
+    const absl::MutexLock lock(&pool_mutex_);
+    for (; count > 0 && !free_slots_.empty(); --count) {
+      if (IsStoppingOrStopped()) {
+        return;
+      }
+
+      const auto index = free_slots_.back();
+      free_slots_.pop_back();
+      live_workers_.fetch_add(1);
+      try {
+        workers_[index] = std::async(std::launch::async, &Impl::WorkerTask,
+                                     this, index, false);
+      } catch (const std::exception& exc) {
+        live_workers_.fetch_sub(1);
+        free_slots_.push_back(index);
+        LOG(ERROR) << *this << "; failed to start a worker; what() = "
+                   << exc.what();
+        return;
+      }
+    }
+  }
+
+  /// Called after a task was taken off the queue.
+  void Release(const size_t size_bytes) noexcept {
+    queued_.fetch_sub(1);
+    if (HasMemoryBudget()) {
+      ReleaseMemory(size_bytes);
+    } else if (IsBounded()) {
+      NotifySpace();
+    }
+  }
+
+  bool HasMemoryBudget() const noexcept {
+    auto res =
+        params_.queue_memory_budget != std::numeric_limits<size_t>::max();
+    return res;
+  }
+
+  /// A task larger than the whole budget only gets into an empty queue, it
+  /// would never fit otherwise.
+  bool TryReserveMemory(const size_t size_bytes) noexcept {
+    const auto budget = params_.queue_memory_budget;
+    auto queued = queued_bytes_.load();
+    do {
+      if (queued > 0 && (queued >= budget || size_bytes > budget - queued)) {
+        return false;
+      }
+    } while (!queued_bytes_.compare_exchange_weak(queued, queued + size_bytes));
+
+    return true;
+  }
+
+  void ReserveMemory(const size_t size_bytes) noexcept {
+    if (TryReserveMemory(size_bytes)) {
+      return;
+    }
+
+    blocked_producers_.fetch_add(1);
     for (;;) {
-      const absl::MutexLock lock(&mutex_);
-      mutex_.Await(absl::Condition(this, &Impl::HasTasksToRun));
+      const auto epoch = space_epoch_.load();
+      if (TryReserveMemory(size_bytes)) {
+        break;
+      }
 
-      auto task = std::move(tasks_.front());
-      tasks_.pop();
+      space_epoch_.wait(epoch);
+    }
+    blocked_producers_.fetch_sub(1);
+  }
+
+  void ReleaseMemory(const size_t size_bytes) noexcept {
+    queued_bytes_.fetch_sub(size_bytes);
+    NotifySpace();
+  }
+
+  /// Whether a task with `options` would get in right now, assuming it takes
+  /// a byte unless it declares its size.
+  bool HasSpace(const TaskOptions& options) const noexcept {
+    if (IsBounded() && queued_.load() >= params_.queue_capacity) {
+      return false;
+    }
+    if (!HasMemoryBudget()) {
+      return true;
+    }
 
-      if (ABSL_PREDICT_FALSE(!task)) {
+    const auto budget = params_.queue_memory_budget;
+    const auto queued = queued_bytes_.load();
+    auto res = queued == 0 || (queued < budget &&
+                               options.size_bytes.value_or(1) <=
+                                   budget - queued);
+    return res;
+  }
+
+  /// Wakes the producers waiting for space, in a ring or in the budget, and
+  /// completes the `WhenHasCapacity` futures.
+  void NotifySpace() noexcept {
+    // Producers wait for the queue and for the budget on the same epoch, so
+    // waking just one of them could wake somebody who still doesn't fit.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (blocked_producers_.load() > 0) {
+      space_epoch_.fetch_add(1);
+      space_epoch_.notify_all();
+    }
+    if (ABSL_PREDICT_FALSE(capacity_waiter_count_.load() > 0)) {
+      NotifyCapacity();
+    }
+  }
+
+  void NotifyCapacity() noexcept {
+    std::vector<Promise<void>> waiters;
+    {
+      const absl::MutexLock lock(&capacity_mutex_);
+      waiters.swap(capacity_waiters_);
+      capacity_waiter_count_.fetch_sub(waiters.size());
+    }
+
+    // Continuations may submit tasks, so they run without the lock held.
+    for (auto& waiter : waiters) {
+      waiter.SetValue();
+    }
+  }
+
+  bool TryPop(const size_t index, const bool lowest_first,
+              const bool prefer_next, QueuedTask& task, bool& from_next) {
+    if (IsBounded()) {
+      // Tasks with a deadline go before the ones in the ring.
+      auto res = ForEachLane(lowest_first, [&](const size_t lane) {
+        return bounded_lanes_[lane].TryPop(task) ||
+               (lane == kRingLane && bounded_->TryPop(task));
+      });
+      return res;
+    }
+
+    // The starvation guard looks at the local lanes first, the lowest one
+    // among them is what it's after.
+    if (!lowest_first && urgent_.TryPop(task)) {
+      return true;
+    }
+    if (queues_[index]->TryPop(lowest_first, prefer_next, task, from_next)) {
+      return true;
+    }
+    if (lowest_first && urgent_.TryPop(task)) {
+      return true;
+    }
+
+    std::vector<QueuedTask> stolen;
+    size_t lane = 0;
+    for (const auto victim : placements_[index].victims) {
+      lane = queues_[victim]->StealHalf(stolen);
+      if (!stolen.empty()) {
         break;
       }
+    }
+
+    if (stolen.empty()) {
+      auto res = StealNext(index, task);
+      return res;
+    }
+
+    task = std::move(stolen.front());
+    for (size_t i = 1; i < stolen.size(); ++i) {
+      queues_[index]->Push(lane, std::move(stolen[i]));
+    }
+
+    return true;
+  }
+
+  /// Takes a task from the next slot of another worker, after giving that
+  /// worker a moment to get to it.
+  bool StealNext(const size_t index, QueuedTask& task) {
+    const auto& victims = placements_[index].victims;
+    if (std::none_of(victims.begin(), victims.end(), [&](const size_t victim) {
+          return queues_[victim]->HasNext();
+        })) {
+      return false;
+    }
+
+    const auto deadline = internal_executor::NowNanos() +
+                          absl::ToInt64Nanoseconds(kNextStealDelay);
+    while (internal_executor::NowNanos() < deadline) {
+      internal_executor::CpuRelax();
+    }
+
+    for (const auto victim : victims) {
+      if (queues_[victim]->StealNext(task)) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /// Spins for a while hoping for new tasks, a burst then doesn't pay for
+  /// parking and waking up. At most half of the workers spin at once.
+  bool Spin() noexcept {
+    if (params_.spin_time <= absl::ZeroDuration()) {
+      return false;
+    }
+
+    const auto max_spinning = std::max<size_t>(live_workers_.load() / 2, 1);
+    if (spinning_.fetch_add(1) >= max_spinning) {
+      spinning_.fetch_sub(1);
+      return false;
+    }
+
+    const auto deadline = internal_executor::NowNanos() +
+                          absl::ToInt64Nanoseconds(params_.spin_time);
+    bool res = false;
+    while (!res && !IsStoppingOrStopped() &&
+           internal_executor::NowNanos() < deadline) {
+      for (int i = 0; i < 64; ++i) {
+        internal_executor::CpuRelax();
+      }
+      res = HasQueuedTasks();
+    }
+    spinning_.fetch_sub(1);
+
+    return res;
+  }
+
+  /// Returns `false` if the worker was already woken up.
+  bool RemoveIdle(const size_t index) noexcept {
+    const absl::MutexLock lock(&idle_mutex_);
+    if (!is_idle_[index]) {
+      return false;
+    }
+
+    idle_.erase(std::find(idle_.begin(), idle_.end(), index));
+    is_idle_[index] = false;
+    sleepers_.store(idle_.size());
+    return true;
+  }
+
+  bool IsIdle(const size_t index) noexcept {
+    const absl::MutexLock lock(&idle_mutex_);
+    auto res = is_idle_[index];
+    return res;
+  }
+
+  /// Leaves at least `min_thread_count` workers running.
+  bool TryRetire() noexcept {
+    auto live = live_workers_.load();
+    while (live > params_.min_thread_count) {
+      if (live_workers_.compare_exchange_weak(live, live - 1)) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /// Retires a worker once there are more of them than `TargetThreadCount()`,
+  /// i.e. after a blocking region ended.
+  bool TryRetireSurplus() noexcept {
+    auto live = live_workers_.load();
+    while (live > TargetThreadCount()) {
+      if (live_workers_.compare_exchange_weak(live, live - 1)) {
+        // Pairs with `BeginBlocking`: a task that started blocking meanwhile
+        // may have seen the old count and not started a replacement.
+        if (live - 1 < TargetThreadCount()) {
+          live_workers_.fetch_add(1);
+          return false;
+        }
+
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /// A worker can't join itself, and producers that start workers shouldn't
+  /// pay for it: the future of the retiring worker is left to the next one to
+  /// retire, or to `stop`.
+  void Retire(const size_t index) noexcept {
+    current_worker = {};
+    std::vector<std::future<void>> exited;
+    {
+      const absl::MutexLock lock(&pool_mutex_);
+      exited.swap(retired_);
+      // Taken already if the executor is stopping.
+      if (workers_[index].valid()) {
+        retired_.push_back(std::move(workers_[index]));
+      }
+      free_slots_.push_back(index);
+    }
+
+    // They have nothing left to do but to exit.
+    for (auto& worker : exited) {
+      Join(worker);
+    }
+  }
 
+  void Join(std::future<void>& worker) noexcept {
+    try {
+      worker.get();
+    } catch (...) {
+      auto eptr = std::current_exception();
+      std::string message;
       try {
-        std::move(task)();
+        std::rethrow_exception(eptr);
+      } catch (const std::exception& exc) {
+        message = exc.what();
+      }
+
+      LOG(ERROR) << *this << "; what() = " << message;
+    }
+  }
+
+  EIdleResult Park(const size_t index) {
+    {
+      const absl::MutexLock lock(&idle_mutex_);
+      idle_.push_back(index);
+      is_idle_[index] = true;
+      sleepers_.store(idle_.size());
+    }
+
+    for (;;) {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (HasQueuedTasks()) {
+        RemoveIdle(index);
+        return EIdleResult::Work;
+      }
+
+      if (IsStoppingOrStopped()) {
+        RemoveIdle(index);
+        return EIdleResult::Stop;
+      }
+
+      const auto timeout =
+          live_workers_.load() > params_.min_thread_count
+              ? params_.idle_timeout
+              : absl::InfiniteDuration();
+      if (parkers_[index].parker.Park(timeout)) {
+        // The unpark may be left over from an earlier wake-up that raced with
+        // `RemoveIdle`, then we are still in `idle_`.
+        if (!IsIdle(index)) {
+          return EIdleResult::Work;
+        }
+
+        continue;
+      }
+
+      if (RemoveIdle(index)) {
+        if (TryRetire()) {
+          return EIdleResult::Retire;
+        }
+
+        const absl::MutexLock lock(&idle_mutex_);
+        idle_.push_back(index);
+        is_idle_[index] = true;
+        sleepers_.store(idle_.size());
+      }
+    }
+  }
+
+  EIdleResult Idle(const size_t index) {
+    if (Spin()) {
+      return EIdleResult::Work;
+    }
+
+    auto res = Park(index);
+    return res;
+  }
+
+  void WorkerTask(const size_t index, const bool initial) {
+    internal_executor::SetCurrentThreadName(params_.name + ":" +
+                                            std::to_string(index));
+    auto& placement = placements_[index];
+    placement.pin_failed = !placement.cpus.empty() &&
+                           !internal_executor::PinCurrentThread(placement.cpus);
+
+    if (initial) {
+      if (!IsBounded()) {
+        queues_[index] = std::make_unique<WorkerQueue>();
+      }
+      worker_stats_[index] = std::make_unique<WorkerStats>();
+      ready_->arrive_and_wait();
+    }
+    auto& stats = *worker_stats_[index];
+    current_worker = {.owner = this, .index = index};
+    const internal_executor::ScopedCurrentExecutor current_executor(owner_);
+
+    for (size_t picks = 0, next_picks = 0;;) {
+      // Every `starvation_guard_interval`-th pick favours the lowest priority
+      // that has tasks, so a stream of urgent work can't starve the rest.
+      const bool lowest_first =
+          (picks + 1) % params_.starvation_guard_interval == 0;
+      if (ABSL_PREDICT_FALSE(live_workers_.load(std::memory_order_relaxed) >
+                             TargetThreadCount()) &&
+          TryRetireSurplus()) {
+        Retire(index);
+        return;
+      }
+
+      QueuedTask task;
+      bool from_next = false;
+      // A chain of tasks, each submitting the next one, would keep the rest
+      // of the queue waiting.
+      if (!TryPop(index, lowest_first, next_picks < kMaxNextPicks, task,
+                  from_next)) {
+        const auto idle = Idle(index);
+        if (ABSL_PREDICT_FALSE(idle == EIdleResult::Retire)) {
+          Retire(index);
+          return;
+        }
+
+        if (ABSL_PREDICT_FALSE(idle == EIdleResult::Stop)) {
+          break;
+        }
+
+        continue;
+      }
+
+      ++picks;
+      next_picks = from_next ? next_picks + 1 : 0;
+      Release(task.size_bytes);
+
+      const auto started_at = internal_executor::NowNanos();
+      internal_executor::IncrementOwned(stats.started);
+      internal_executor::IncrementOwned(stats.started_bytes, task.size_bytes);
+      const auto queue_wait =
+          started_at > task.enqueued_at ? started_at - task.enqueued_at : 0;
+      // Dropping the task fails its future, if it has one.
+      if (ABSL_PREDICT_FALSE(task.cancellation.IsCancelled())) {
+        internal_executor::IncrementOwned(stats.cancelled);
+        continue;
+      }
+      if (ABSL_PREDICT_FALSE(queue_wait > max_queue_nanos_)) {
+        internal_executor::IncrementOwned(stats.shed);
+        continue;
+      }
+
+      stats.queue_wait.Add(queue_wait);
+      // Only labelled tasks pay for reading the thread clock.
+      const auto cpu_started_at =
+          task.label.empty() ? 0 : internal_executor::ThreadCpuNanos();
+      try {
+        std::move(task.task)();
       } catch (...) {
+        internal_executor::IncrementOwned(stats.failed);
         auto eptr = std::current_exception();
         std::string message;
         try {
@@ -138,20 +1480,78 @@ class CpuExecutor::Impl final : public IExecutor,
 
         LOG(ERROR) << *this << "; what() = " << message;
       }
+      // Read inside the wall clock interval, so that a task never seems to
+      // take more CPU than time.
+      const auto cpu_time =
+          task.label.empty()
+              ? 0
+              : internal_executor::ThreadCpuNanos() - cpu_started_at;
+      const auto run_time = internal_executor::NowNanos() - started_at;
+      stats.run_time.Add(run_time);
+      if (!task.label.empty()) {
+        stats.labels.Add(task.label, run_time, cpu_time);
+      }
+      internal_executor::IncrementOwned(stats.completed);
     }
+
+    current_worker = {};
   }
 
  private:
+  // The public executor, for `IsCurrentThreadIn`.
+  const IExecutor* const owner_;
   Params params_;
+  // `max_queue_time` in the units of `internal_executor::NowNanos()`.
+  uint64_t max_queue_nanos_ = 0;
 
-  absl::Mutex mutex_;
-  std::queue<absl::AnyInvocable<void() &&>> tasks_ ABSL_GUARDED_BY(mutex_);
-  std::vector<std::future<void>> workers_;
+  // Set when the queue is bounded, `queues_` are not used in this case. Normal
+  // priority tasks without a deadline go through the ring, the rest through
+  // the locked lanes; `queued_` bounds them all together.
+  std::unique_ptr<internal_executor::BoundedMpmcQueue<QueuedTask>> bounded_;
+  std::array<SharedLane, kTaskPriorityCount> bounded_lanes_;
+  std::vector<std::unique_ptr<WorkerQueue>> queues_;
+  SharedLane urgent_;
+
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<size_t> next_queue_ = 0;
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<size_t> queued_ = 0;
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<size_t> sleepers_ = 0;
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<size_t> spinning_ = 0;
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<size_t> live_workers_ = 0;
+  // Workers inside a `ScopedBlockingRegion`.
+  std::atomic<size_t> blocked_ = 0;
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<size_t> blocked_producers_ = 0;
+  // Reserved against `queue_memory_budget`, only kept when there is one.
+  std::atomic<size_t> queued_bytes_ = 0;
+  std::atomic<uint32_t> space_epoch_ = 0;
+  // Futures returned by `WhenHasCapacity`, all of them complete whenever a
+  // task leaves a bounded ring.
+  std::atomic<size_t> capacity_waiter_count_ = 0;
+  absl::Mutex capacity_mutex_;
+  std::vector<Promise<void>> capacity_waiters_
+      ABSL_GUARDED_BY(capacity_mutex_);
+
+  std::vector<WorkerPlacement> placements_;
+  std::optional<std::latch> ready_;
+  std::vector<std::unique_ptr<WorkerStats>> worker_stats_;
+  std::unique_ptr<ProducerStats[]> producer_stats_;
+
+  std::unique_ptr<WorkerParker[]> parkers_;
+  absl::Mutex idle_mutex_;
+  // Parked workers, the most recently parked last; mirrored by `sleepers_`.
+  std::vector<size_t> idle_ ABSL_GUARDED_BY(idle_mutex_);
+  std::vector<bool> is_idle_ ABSL_GUARDED_BY(idle_mutex_);
+
+  absl::Mutex pool_mutex_;
+  // Slots without a running worker.
+  std::vector<size_t> free_slots_ ABSL_GUARDED_BY(pool_mutex_);
+  std::vector<std::future<void>> workers_ ABSL_GUARDED_BY(pool_mutex_);
+  // Workers that retired but weren't joined yet.
+  std::vector<std::future<void>> retired_ ABSL_GUARDED_BY(pool_mutex_);
 };
 
 CpuExecutor::CpuExecutor(NotPubliclyConstructible /*npc*/,
                          const CpuExecutorParams& params)
-    : i_(std::make_unique<Impl>(params)) {}
+    : i_(std::make_unique<Impl>(this, params)) {}
 
 CpuExecutor::~CpuExecutor() = default;
 
@@ -170,9 +1570,82 @@ bool CpuExecutor::TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept {
   return res;
 }
 
+void CpuExecutor::Add(absl::AnyInvocable<void() &&> task,
+                      const TaskOptions& options) noexcept {
+  i_->Add(std::move(task), options);
+}
+
+bool CpuExecutor::TryAdd(absl::AnyInvocable<void() &&>&& task,
+                         const TaskOptions& options) noexcept {
+  auto res = i_->TryAdd(std::move(task), options);
+  return res;
+}
+
+void CpuExecutor::AddTask(ExecutorTask task,
+                          const TaskOptions& options) noexcept {
+  i_->AddTask(std::move(task), options);
+}
+
+void CpuExecutor::AddBatch(
+    std::span<absl::AnyInvocable<void() &&>> tasks) noexcept {
+  i_->AddBatch(tasks);
+}
+
+size_t CpuExecutor::TryAddBatch(
+    std::span<absl::AnyInvocable<void() &&>> tasks) noexcept {
+  auto res = i_->TryAddBatch(tasks);
+  return res;
+}
+
+bool CpuExecutor::TryAddTask(ExecutorTask&& task,
+                             const TaskOptions& options) noexcept {
+  auto res = i_->TryAddTask(std::move(task), options);
+  return res;
+}
+
+void CpuExecutor::AddTaskBatch(std::span<ExecutorTask> tasks) noexcept {
+  i_->AddTaskBatch(tasks);
+}
+
+size_t CpuExecutor::TryAddTaskBatch(std::span<ExecutorTask> tasks) noexcept {
+  auto res = i_->TryAddTaskBatch(tasks);
+  return res;
+}
+
+Future<void> CpuExecutor::WhenHasCapacity(
+    const TaskOptions& options) noexcept {
+  auto res = i_->WhenHasCapacity(options);
+  return res;
+}
+
+CpuExecutorStats CpuExecutor::GetStats() const noexcept {
+  auto res = i_->GetStats();
+  return res;
+}
+
 std::future<void> CpuExecutor::stop() {
   auto res = i_->stop();
   return res;
 }
 
+ScopedBlockingRegion::ScopedBlockingRegion() noexcept {
+  if (current_worker.owner == nullptr || current_worker.blocking_depth++ > 0) {
+    return;
+  }
+
+  executor_ = static_cast<CpuExecutor::Impl*>(current_worker.owner);
+  executor_->BeginBlocking();
+}
+
+ScopedBlockingRegion::~ScopedBlockingRegion() {
+  if (current_worker.owner == nullptr) {
+    return;
+  }
+
+  --current_worker.blocking_depth;
+  if (executor_ != nullptr) {
+    executor_->EndBlocking();
+  }
+}
+
 }  // namespace handbag::executor
@@ -1,21 +1,99 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string>
+#include <vector>
 
+#include "absl/time/time.h"
 #include "lib/cpp/executor/executor.h"
+#include "lib/cpp/executor/stats.h"
 #include "lib/cpp/start_stop/start_stop.h"
 
 namespace handbag::executor {
 
 struct CpuExecutorParams {
-  std::optional<std::string> name;
-  std::optional<size_t> thread_count;
-  std::optional<size_t> queue_capacity;
+  /// Also names the worker threads ("<name>:<index>", truncated to 15
+  /// characters), so they can be told apart in perf and top.
+  std::optional<std::string> name = {};
+  /// Defaults to the number of `cpus`.
+  std::optional<size_t> thread_count = {};
+  /// Makes the executor elastic: it starts with `min_thread_count` workers
+  /// and grows up to `thread_count` while all of them are busy. Workers above
+  /// the minimum exit after being idle for `idle_timeout`.
+  std::optional<size_t> min_thread_count = {};
+  std::optional<absl::Duration> idle_timeout = {};
+  /// How long an idle worker spins before parking. Shortens the wake-up
+  /// latency for bursts of tasks at the cost of some CPU; at most half of the
+  /// workers spin at once. Zero disables spinning.
+  std::optional<absl::Duration> spin_time = {};
+  /// Workers only run on these CPUs. Defaults to the CPUs the process may run
+  /// on; workers are not pinned unless either this or `numa_aware` is set.
+  std::optional<std::vector<size_t>> cpus = {};
+  /// Builds one sub-pool per NUMA node: workers are spread over the nodes in
+  /// proportion to their share of `cpus`, pinned to their node, allocate
+  /// their queues there and steal from their own node before going remote.
+  std::optional<bool> numa_aware = {};
+  /// Bounds the number of queued tasks, of all priorities together. Normal
+  /// priority tasks without a deadline go through a lock-free ring of this
+  /// size, allocated up front; the others through locked queues that only
+  /// grow as needed, and keep their EDF order.
+  std::optional<size_t> queue_capacity = {};
+  /// Bounds the memory held by queued tasks, see `TaskOptions::size_bytes`:
+  /// `Add` blocks and `TryAdd` rejects while the budget is used up. Applies
+  /// on top of `queue_capacity`, if set. A task larger than the whole budget
+  /// is only taken into an empty queue. `WhenHasCapacity` waits for room for
+  /// the `size_bytes` it's given.
+  std::optional<size_t> queue_memory_budget = {};
+  /// Every N-th task a worker picks is taken from the lowest priority that
+  /// has tasks, so low priority work keeps making progress under a constant
+  /// stream of high priority tasks.
+  std::optional<size_t> starvation_guard_interval = {};
+  /// Load shedding: tasks that waited in the queue longer than this are
+  /// dropped instead of run, their futures fail with `TaskCancelledError`.
+  std::optional<absl::Duration> max_queue_time = {};
+  /// Extra workers started while tasks wait inside a `ScopedBlockingRegion`,
+  /// one per blocked worker, so blocking calls don't starve the queue. They
+  /// exit once the blocking is over. Zero, the default, disables it.
+  std::optional<size_t> max_compensating_thread_count = {};
 };
 
+/// Counters are cumulative since the executor was created.
+struct CpuExecutorStats {
+  /// Tasks accepted by `Add`/`TryAdd` and their batch versions.
+  uint64_t submitted = 0;
+  /// Tasks refused by `TryAdd` and `TryAddBatch`.
+  uint64_t rejected = 0;
+  /// Tasks that finished running, including the `failed` ones.
+  uint64_t completed = 0;
+  /// Tasks that exited with an exception.
+  uint64_t failed = 0;
+  /// Tasks dropped because their `TaskOptions::cancellation` was cancelled.
+  uint64_t cancelled = 0;
+  /// Tasks dropped because they waited longer than `max_queue_time`.
+  uint64_t shed = 0;
+  /// Tasks submitted but not yet picked by a worker.
+  uint64_t queue_depth = 0;
+  /// Memory held by the queued tasks, see `TaskOptions::size_bytes`.
+  uint64_t queued_bytes = 0;
+  /// Workers currently running, parked ones included.
+  size_t thread_count = 0;
+  size_t idle_thread_count = 0;
+  /// Workers inside a `ScopedBlockingRegion`.
+  size_t blocked_thread_count = 0;
+  /// Time from submission until a worker picked the task.
+  DurationHistogram queue_wait;
+  DurationHistogram run_time;
+  /// Tasks that ran with a `TaskOptions::label`, most CPU time first.
+  std::vector<TaskLabelStats> labels;
+};
+
+/// Work-stealing pool. Every worker has its own queue, except for high
+/// priority tasks: they share a queue that all workers check first, so they
+/// don't wait behind whatever the worker they were pushed to is busy with.
 class CpuExecutor final : public IExecutor, public start_stop::IStoppable {
   class NotPubliclyConstructible {};
 
@@ -30,17 +108,52 @@ class CpuExecutor final : public IExecutor, public start_stop::IStoppable {
               const CpuExecutorParams& params);
   ~CpuExecutor() override;
 
-  std::unique_ptr<CpuExecutor> create(const CpuExecutorParams& params);
+  static std::unique_ptr<CpuExecutor> create(const CpuExecutorParams& params);
 
   void Add(absl::AnyInvocable<void() &&> task) noexcept override;
   bool TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept override;
+  void Add(absl::AnyInvocable<void() &&> task,
+           const TaskOptions& options) noexcept override;
+  bool TryAdd(absl::AnyInvocable<void() &&>&& task,
+              const TaskOptions& options) noexcept override;
+  void AddTask(ExecutorTask task, const TaskOptions& options) noexcept override;
+  void AddBatch(
+      std::span<absl::AnyInvocable<void() &&>> tasks) noexcept override;
+  size_t TryAddBatch(
+      std::span<absl::AnyInvocable<void() &&>> tasks) noexcept override;
+  bool TryAddTask(ExecutorTask&& task,
+                  const TaskOptions& options) noexcept override;
+  void AddTaskBatch(std::span<ExecutorTask> tasks) noexcept override;
+  size_t TryAddTaskBatch(std::span<ExecutorTask> tasks) noexcept override;
+  Future<void> WhenHasCapacity(const TaskOptions& options) noexcept override;
+
+  /// Cheap enough to be polled: reads per-worker counters without locking.
+  CpuExecutorStats GetStats() const noexcept;
 
   std::future<void> stop() override;
 
  private:
+  friend class ScopedBlockingRegion;
+
   class Impl;
   // TODO(kostya): make it an inline impl
   std::unique_ptr<Impl> i_;
 };
 
+/// Announces that the current task is about to block, e.g. on a syscall or a
+/// lock held elsewhere. If the task runs on a `CpuExecutor` with
+/// `max_compensating_thread_count` set, the executor starts a worker in place
+/// of this one for the lifetime of the region. Does nothing elsewhere; regions
+/// may nest.
+class ScopedBlockingRegion {
+ public:
+  ScopedBlockingRegion() noexcept;
+  ScopedBlockingRegion(const ScopedBlockingRegion&) = delete;
+  ScopedBlockingRegion& operator=(const ScopedBlockingRegion&) = delete;
+  ~ScopedBlockingRegion();
+
+ private:
+  CpuExecutor::Impl* executor_ = nullptr;
+};
+
 }  // namespace handbag::executor
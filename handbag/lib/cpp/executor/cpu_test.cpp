@@ -0,0 +1,695 @@
+#include "lib/cpp/executor/cpu.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <latch>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "lib/cpp/executor/internal/topology.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace ::testing;
+
+namespace handbag::executor::tests {
+namespace {
+
+TEST(CpuExecutorTest, RunsTasks) {
+  auto executor = CpuExecutor::create({.thread_count = 4});
+
+  std::vector<Future<int>> results;
+  for (int i = 0; i < 1000; ++i) {
+    results.push_back(AddTo(*executor, [i] { return i * 2; }));
+  }
+
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_THAT(results[i].Get(), Eq(i * 2));
+  }
+
+  executor->stop().get();
+}
+
+TEST(CpuExecutorTest, TasksSubmittedFromWorkers) {
+  auto executor = CpuExecutor::create({.thread_count = 4});
+
+  constexpr int kFanOut = 100;
+  std::atomic<int> done = 0;
+  absl::Notification all_done;
+  for (int i = 0; i < kFanOut; ++i) {
+    executor->Add([&] {
+      for (int j = 0; j < kFanOut; ++j) {
+        executor->Add([&] {
+          if (done.fetch_add(1) + 1 == kFanOut * kFanOut) {
+            all_done.Notify();
+          }
+        });
+      }
+    });
+  }
+
+  all_done.WaitForNotification();
+  EXPECT_THAT(done.load(), Eq(kFanOut * kFanOut));
+
+  executor->stop().get();
+}
+
+TEST(CpuExecutorTest, TasksFromWorkersRunNext) {
+  auto executor = CpuExecutor::create({.thread_count = 1});
+  absl::Notification started;
+  absl::Notification release;
+  executor->Add([&] {
+    started.Notify();
+    release.WaitForNotification();
+  });
+  started.WaitForNotification();
+
+  // Every task of the chain submits the next one, which jumps the queue up to
+  // three times in a row. A yielding task doesn't.
+  std::string order;
+  std::function<void(char)> chain = [&](const char name) {
+    order += name;
+    if (name < 'e') {
+      executor->Add([&, name] { chain(name + 1); });
+    } else {
+      executor->Add([&] { order += 'y'; }, {.yield = true});
+    }
+  };
+  executor->Add([&] { chain('a'); });
+  executor->Add([&] { order += 'x'; });
+  executor->Add([&] { order += 'z'; });
+
+  release.Notify();
+  executor->stop().get();
+  EXPECT_THAT(order, Eq("abcdxezy"));
+}
+
+TEST(CpuExecutorTest, IsCurrentThreadIn) {
+  auto executor = CpuExecutor::create({.thread_count = 1});
+  auto other = CpuExecutor::create({.thread_count = 1});
+
+  EXPECT_FALSE(IsCurrentThreadIn(*executor));
+  EXPECT_TRUE(AddTo(*executor, [&] {
+                return IsCurrentThreadIn(*executor) &&
+                       !IsCurrentThreadIn(*other);
+              }).Get());
+
+  other->stop().get();
+  executor->stop().get();
+}
+
+TEST(CpuExecutorTest, TryAddRespectsCapacity) {
+  auto executor =
+      CpuExecutor::create({.thread_count = 1, .queue_capacity = 2});
+
+  absl::Notification started;
+  absl::Notification release;
+  executor->Add([&] {
+    started.Notify();
+    release.WaitForNotification();
+  });
+  started.WaitForNotification();
+
+  EXPECT_TRUE(executor->TryAdd([] {}));
+  EXPECT_TRUE(executor->TryAdd([] {}));
+  EXPECT_FALSE(executor->TryAdd([] {}));
+
+  release.Notify();
+  executor->stop().get();
+}
+
+TEST(CpuExecutorTest, AddBlocksUntilThereIsSpace) {
+  auto executor =
+      CpuExecutor::create({.thread_count = 1, .queue_capacity = 1});
+
+  absl::Notification started;
+  absl::Notification release;
+  executor->Add([&] {
+    started.Notify();
+    release.WaitForNotification();
+  });
+  started.WaitForNotification();
+  EXPECT_TRUE(executor->TryAdd([] {}));
+
+  std::atomic<int> done = 0;
+  auto producer = std::async(std::launch::async, [&] {
+    for (int i = 0; i < 100; ++i) {
+      executor->Add([&] { (void)done.fetch_add(1); });
+    }
+  });
+  EXPECT_THAT(producer.wait_for(std::chrono::milliseconds(10)),
+              Eq(std::future_status::timeout));
+
+  release.Notify();
+  producer.get();
+  executor->stop().get();
+  EXPECT_THAT(done.load(), Eq(100));
+}
+
+TEST(CpuExecutorTest, MemoryBudget) {
+  auto executor =
+      CpuExecutor::create({.thread_count = 1, .queue_memory_budget = 1000});
+
+  absl::Notification started;
+  absl::Notification release;
+  executor->Add([&] {
+    started.Notify();
+    release.WaitForNotification();
+  });
+  started.WaitForNotification();
+
+  EXPECT_TRUE(executor->TryAdd([] {}, {.size_bytes = 600}));
+  EXPECT_FALSE(executor->TryAdd([] {}, {.size_bytes = 600}));
+  EXPECT_TRUE(executor->TryAdd([] {}, {.size_bytes = 300}));
+  EXPECT_THAT(executor->GetStats().queued_bytes, Eq(900));
+  auto capacity = executor->WhenHasCapacity({.size_bytes = 600});
+  EXPECT_FALSE(capacity.IsReady());
+
+  // Without a declared size the closure counts.
+  std::atomic<int> done = 0;
+  auto producer = std::async(std::launch::async, [&] {
+    AddDetachedTo(*executor, [&, padding = std::array<char, 512>()] {
+      (void)padding;
+      (void)done.fetch_add(1);
+    });
+  });
+  EXPECT_THAT(producer.wait_for(std::chrono::milliseconds(10)),
+              Eq(std::future_status::timeout));
+
+  release.Notify();
+  capacity.Get();
+  producer.get();
+  executor->stop().get();
+  EXPECT_THAT(done.load(), Eq(1));
+  EXPECT_THAT(executor->GetStats().queued_bytes, Eq(0));
+}
+
+TEST(CpuExecutorTest, TaskLargerThanMemoryBudget) {
+  auto executor =
+      CpuExecutor::create({.thread_count = 1, .queue_memory_budget = 1000});
+
+  // Only gets in while nothing else is queued.
+  EXPECT_THAT(
+      AddTo(*executor, {.size_bytes = 5000}, [] { return 1; }).Get(), Eq(1));
+
+  executor->stop().get();
+}
+
+TEST(CpuExecutorTest, AddBatch) {
+  auto executor = CpuExecutor::create({.thread_count = 4});
+
+  std::vector<std::function<int()>> tasks;
+  for (int i = 0; i < 1000; ++i) {
+    tasks.push_back([i] { return i * 2; });
+  }
+
+  auto results = AddBatchTo(*executor, tasks);
+  ASSERT_THAT(results, SizeIs(1000));
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_THAT(results[i].Get(), Eq(i * 2));
+  }
+
+  executor->stop().get();
+}
+
+TEST(CpuExecutorTest, TryAddBatchAcceptsPrefix) {
+  auto executor =
+      CpuExecutor::create({.thread_count = 1, .queue_capacity = 3});
+
+  absl::Notification started;
+  absl::Notification release;
+  executor->Add([&] {
+    started.Notify();
+    release.WaitForNotification();
+  });
+  started.WaitForNotification();
+
+  std::vector<std::function<int()>> tasks;
+  for (int i = 0; i < 5; ++i) {
+    tasks.push_back([i] { return i; });
+  }
+
+  auto results = TryAddBatchTo(*executor, std::move(tasks));
+  ASSERT_THAT(results, SizeIs(3));
+
+  release.Notify();
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_THAT(results[i].Get(), Eq(i));
+  }
+
+  executor->stop().get();
+}
+
+TEST(CpuExecutorTest, RetryRejectedTaskWhenThereIsCapacity) {
+  auto executor =
+      CpuExecutor::create({.thread_count = 1, .queue_capacity = 1});
+  EXPECT_TRUE(executor->WhenHasCapacity({}).IsReady());
+
+  absl::Notification started;
+  absl::Notification release;
+  executor->Add([&] {
+    started.Notify();
+    release.WaitForNotification();
+  });
+  started.WaitForNotification();
+  EXPECT_TRUE(executor->TryAdd([] {}));
+
+  auto task = PrepareTask([](std::unique_ptr<int> value) { return *value; },
+                          std::make_unique<int>(7));
+  EXPECT_THAT(TryAddTo(*executor, task), Eq(std::nullopt));
+  EXPECT_TRUE(task.IsValid());
+
+  auto capacity = executor->WhenHasCapacity({.size_bytes = 600});
+  EXPECT_FALSE(capacity.IsReady());
+  release.Notify();
+  capacity.Get();
+
+  std::optional<Future<int>> result;
+  while (!(result = TryAddTo(*executor, task)).has_value()) {
+    executor->WhenHasCapacity({}).Get();
+  }
+  EXPECT_FALSE(task.IsValid());
+  EXPECT_THAT(result->Get(), Eq(7));
+
+  executor->stop().get();
+}
+
+TEST(CpuExecutorTest, PrioritiesAndDeadlines) {
+  for (const auto& params :
+       {CpuExecutorParams{.thread_count = 1, .starvation_guard_interval = 1000},
+        CpuExecutorParams{.thread_count = 1,
+                          .queue_capacity = 10,
+                          .starvation_guard_interval = 1000}}) {
+    auto executor = CpuExecutor::create(params);
+
+    absl::Notification started;
+    absl::Notification release;
+    executor->Add([&] {
+      started.Notify();
+      release.WaitForNotification();
+    });
+    started.WaitForNotification();
+
+    std::vector<std::string> order;
+    const auto add = [&](const TaskOptions& options, std::string name) {
+      AddDetachedTo(*executor, options, [&order, name = std::move(name)] {
+        order.push_back(name);
+      });
+    };
+    const auto now = absl::Now();
+    add({.priority = ETaskPriority::Low}, "low");
+    add({}, "normal");
+    add({.deadline = now + absl::Seconds(2)}, "later");
+    add({.priority = ETaskPriority::High}, "high");
+    add({.deadline = now + absl::Seconds(1)}, "sooner");
+
+    release.Notify();
+    executor->stop().get();
+    EXPECT_THAT(order,
+                ElementsAre("high", "sooner", "later", "normal", "low"));
+  }
+}
+
+TEST(CpuExecutorTest, QueueCapacityBoundsAllPriorities) {
+  auto executor =
+      CpuExecutor::create({.thread_count = 1, .queue_capacity = 3});
+
+  absl::Notification started;
+  absl::Notification release;
+  executor->Add([&] {
+    started.Notify();
+    release.WaitForNotification();
+  });
+  started.WaitForNotification();
+
+  EXPECT_TRUE(executor->TryAdd([] {}, {.priority = ETaskPriority::High}));
+  EXPECT_TRUE(executor->TryAdd([] {}, {.deadline = absl::Now()}));
+  EXPECT_TRUE(executor->TryAdd([] {}, {.priority = ETaskPriority::Low}));
+  for (const auto priority :
+       {ETaskPriority::High, ETaskPriority::Normal, ETaskPriority::Low}) {
+    EXPECT_FALSE(executor->TryAdd([] {}, {.priority = priority}));
+  }
+  EXPECT_FALSE(executor->WhenHasCapacity({}).IsReady());
+
+  release.Notify();
+  executor->stop().get();
+  EXPECT_THAT(executor->GetStats().completed, Eq(4));
+}
+
+TEST(CpuExecutorTest, HighPriorityDoesNotWaitForBusyWorker) {
+  auto executor = CpuExecutor::create({.thread_count = 2,
+                                       .spin_time = absl::ZeroDuration(),
+                                       .starvation_guard_interval = 1000});
+
+  // One worker is stuck on a long low priority task, the other one has a
+  // backlog of short ones.
+  absl::Notification started;
+  absl::Notification release;
+  AddDetachedTo(*executor, {.priority = ETaskPriority::Low}, [&] {
+    started.Notify();
+    release.WaitForNotification();
+  });
+  started.WaitForNotification();
+  std::atomic<int> low_done = 0;
+  for (int i = 0; i < 20; ++i) {
+    AddDetachedTo(*executor, {.priority = ETaskPriority::Low}, [&] {
+      absl::SleepFor(absl::Milliseconds(2));
+      (void)low_done.fetch_add(1);
+    });
+  }
+
+  // Round-robin puts one of them behind the stuck task.
+  std::vector<Future<int>> high;
+  for (int i = 0; i < 2; ++i) {
+    high.push_back(AddTo(*executor, {.priority = ETaskPriority::High},
+                         [&] { return low_done.load(); }));
+  }
+  for (auto& result : high) {
+    EXPECT_THAT(result.Get(), Lt(5));
+  }
+
+  release.Notify();
+  executor->stop().get();
+}
+
+TEST(CpuExecutorTest, StarvationGuard) {
+  auto executor = CpuExecutor::create(
+      {.thread_count = 1, .starvation_guard_interval = 2});
+
+  absl::Notification started;
+  absl::Notification release;
+  executor->Add([&] {
+    started.Notify();
+    release.WaitForNotification();
+  });
+  started.WaitForNotification();
+
+  std::vector<std::string> order;
+  for (int i = 0; i < 3; ++i) {
+    AddDetachedTo(*executor, {.priority = ETaskPriority::High},
+                  [&] { order.push_back("high"); });
+  }
+  AddDetachedTo(*executor, {.priority = ETaskPriority::Low},
+                [&] { order.push_back("low"); });
+
+  release.Notify();
+  executor->stop().get();
+  EXPECT_THAT(order, ElementsAre("low", "high", "high", "high"));
+}
+
+TEST(CpuExecutorTest, TryAddBatchCountsEveryRejectedTask) {
+  for (const auto& params :
+       {CpuExecutorParams{.thread_count = 1, .queue_capacity = 3},
+        CpuExecutorParams{.thread_count = 1,
+                          .queue_memory_budget = 3 * sizeof(ExecutorTask)}}) {
+    auto executor = CpuExecutor::create(params);
+
+    absl::Notification started;
+    absl::Notification release;
+    executor->Add([&] {
+      started.Notify();
+      release.WaitForNotification();
+    });
+    started.WaitForNotification();
+
+    std::vector<absl::AnyInvocable<void() &&>> tasks;
+    for (int i = 0; i < 5; ++i) {
+      tasks.emplace_back([] {});
+    }
+    EXPECT_THAT(executor->TryAddBatch(tasks), Eq(3));
+    EXPECT_THAT(executor->GetStats().rejected, Eq(2));
+
+    release.Notify();
+    executor->stop().get();
+  }
+}
+
+TEST(CpuExecutorTest, Stats) {
+  auto executor =
+      CpuExecutor::create({.thread_count = 1, .queue_capacity = 1});
+
+  absl::Notification started;
+  absl::Notification release;
+  executor->Add([&] {
+    started.Notify();
+    release.WaitForNotification();
+  });
+  started.WaitForNotification();
+  EXPECT_TRUE(executor->TryAdd([] { throw std::runtime_error("NEEDLE"); }));
+  EXPECT_FALSE(executor->TryAdd([] {}));
+
+  auto stats = executor->GetStats();
+  EXPECT_THAT(stats.submitted, Eq(2));
+  EXPECT_THAT(stats.rejected, Eq(1));
+  EXPECT_THAT(stats.queue_depth, Eq(1));
+
+  release.Notify();
+  executor->stop().get();
+
+  stats = executor->GetStats();
+  EXPECT_THAT(stats.completed, Eq(2));
+  EXPECT_THAT(stats.failed, Eq(1));
+  EXPECT_THAT(stats.queue_depth, Eq(0));
+  EXPECT_THAT(stats.queue_wait.count(), Eq(2));
+  EXPECT_THAT(stats.run_time.count(), Eq(2));
+  EXPECT_THAT(stats.run_time.sum(), Ge(absl::ZeroDuration()));
+}
+
+TEST(CpuExecutorTest, Cancellation) {
+  auto executor = CpuExecutor::create({.thread_count = 1});
+
+  absl::Notification started;
+  absl::Notification release;
+  executor->Add([&] {
+    started.Notify();
+    release.WaitForNotification();
+  });
+  started.WaitForNotification();
+
+  CancellationSource source;
+  std::atomic<bool> called = false;
+  auto cancelled = AddTo(*executor, {.cancellation = source.GetToken()},
+                         [&] { called = true; });
+  auto kept =
+      AddTo(*executor, {.cancellation = CancellationSource().GetToken()},
+            [] { return 1; });
+  source.Cancel();
+
+  release.Notify();
+  EXPECT_THROW(cancelled.Get(), TaskCancelledError);
+  EXPECT_THAT(kept.Get(), Eq(1));
+  EXPECT_FALSE(called.load());
+
+  executor->stop().get();
+  EXPECT_THAT(executor->GetStats().cancelled, Eq(1));
+}
+
+TEST(CpuExecutorTest, ShedsTasksAfterMaxQueueTime) {
+  auto executor = CpuExecutor::create(
+      {.thread_count = 1, .max_queue_time = absl::Milliseconds(10)});
+
+  absl::Notification started;
+  absl::Notification release;
+  executor->Add([&] {
+    started.Notify();
+    release.WaitForNotification();
+  });
+  started.WaitForNotification();
+
+  auto stale = AddTo(*executor, [] { return 1; });
+  absl::SleepFor(absl::Milliseconds(20));
+  release.Notify();
+  EXPECT_THROW(stale.Get(), TaskCancelledError);
+  EXPECT_THAT(AddTo(*executor, [] { return 2; }).Get(), Eq(2));
+
+  executor->stop().get();
+  EXPECT_THAT(executor->GetStats().shed, Eq(1));
+}
+
+#if defined(__linux__)
+TEST(CpuExecutorTest, PinsAndNamesWorkers) {
+  const auto cpu = internal_executor::GetAvailableCpus().back();
+  auto executor = CpuExecutor::create(
+      {.name = "pinned", .thread_count = 2, .cpus = {{cpu}}});
+
+  for (int i = 0; i < 10; ++i) {
+    auto placement = AddTo(*executor, [] {
+      char name[16] = {};
+      pthread_getname_np(pthread_self(), name, sizeof(name));
+      return std::pair(sched_getcpu(), std::string(name));
+    });
+    EXPECT_THAT(placement.Get(),
+                Pair(Eq(static_cast<int>(cpu)), StartsWith("pinned:")));
+  }
+
+  executor->stop().get();
+}
+#endif
+
+TEST(CpuExecutorTest, NumaAware) {
+  auto executor =
+      CpuExecutor::create({.thread_count = 4, .numa_aware = true});
+
+  std::vector<Future<int>> results;
+  for (int i = 0; i < 1000; ++i) {
+    results.push_back(AddTo(*executor, [i] { return i; }));
+  }
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_THAT(results[i].Get(), Eq(i));
+  }
+
+  executor->stop().get();
+}
+
+TEST(CpuExecutorTest, NumaAwareFalseDoesNotPin) {
+  auto executor =
+      CpuExecutor::create({.thread_count = 1, .numa_aware = false});
+
+  // The executor describes itself when a task fails.
+  internal::CaptureStderr();
+  executor->Add([] { throw std::runtime_error("NEEDLE"); });
+  executor->stop().get();
+  const auto log = internal::GetCapturedStderr();
+  EXPECT_THAT(log, HasSubstr("NEEDLE"));
+  EXPECT_THAT(log, HasSubstr("pinned=0"));
+}
+
+TEST(CpuExecutorTest, ElasticThreadCount) {
+  auto executor = CpuExecutor::create({.thread_count = 4,
+                                       .min_thread_count = 1,
+                                       .idle_timeout = absl::Milliseconds(20)});
+  EXPECT_THAT(executor->GetStats().thread_count, Eq(1));
+
+  // Can only finish once the executor has grown to 4 workers.
+  std::latch running(4);
+  absl::Notification release;
+  for (int i = 0; i < 4; ++i) {
+    executor->Add([&] {
+      running.count_down();
+      release.WaitForNotification();
+    });
+  }
+  running.wait();
+  EXPECT_THAT(executor->GetStats().thread_count, Eq(4));
+  release.Notify();
+
+  const auto deadline = absl::Now() + absl::Seconds(10);
+  while (executor->GetStats().thread_count > 1 && absl::Now() < deadline) {
+    absl::SleepFor(absl::Milliseconds(5));
+  }
+  EXPECT_THAT(executor->GetStats().thread_count, Eq(1));
+
+  // Retired workers are started again on demand.
+  EXPECT_THAT(AddTo(*executor, [] { return 1; }).Get(), Eq(1));
+  executor->stop().get();
+}
+
+TEST(CpuExecutorTest, CompensatesBlockedWorkers) {
+  auto executor = CpuExecutor::create(
+      {.thread_count = 1, .max_compensating_thread_count = 1});
+
+  // The only regular worker blocks on a task queued behind it.
+  absl::Notification unblock;
+  auto blocked = AddTo(*executor, [&] {
+    const ScopedBlockingRegion blocking;
+    const ScopedBlockingRegion nested;
+    AddDetachedTo(*executor, [&] { unblock.Notify(); });
+    unblock.WaitForNotification();
+  });
+  blocked.Get();
+
+  // The compensating worker exits once the region is over, idle timeout or
+  // not.
+  const auto deadline = absl::Now() + absl::Seconds(5);
+  while (executor->GetStats().thread_count > 1 && absl::Now() < deadline) {
+    absl::SleepFor(absl::Milliseconds(5));
+  }
+  const auto stats = executor->GetStats();
+  EXPECT_THAT(stats.thread_count, Eq(1));
+  EXPECT_THAT(stats.blocked_thread_count, Eq(0));
+
+  // Outside of a worker the region does nothing.
+  { const ScopedBlockingRegion blocking; }
+  EXPECT_THAT(executor->GetStats().blocked_thread_count, Eq(0));
+
+  executor->stop().get();
+}
+
+TEST(CpuExecutorTest, NoSpinning) {
+  auto executor = CpuExecutor::create(
+      {.thread_count = 2, .spin_time = absl::ZeroDuration()});
+
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_THAT(AddTo(*executor, [i] { return i; }).Get(), Eq(i));
+  }
+
+  executor->stop().get();
+}
+
+TEST(CpuExecutorTest, StopRunsQueuedTasks) {
+  auto executor = CpuExecutor::create({.thread_count = 2});
+
+  std::atomic<int> done = 0;
+  for (int i = 0; i < 1000; ++i) {
+    executor->Add([&] { (void)done.fetch_add(1); });
+  }
+
+  executor->stop().get();
+  EXPECT_THAT(done.load(), Eq(1000));
+}
+
+TEST(CpuExecutorTest, TaskLabels) {
+  auto executor = CpuExecutor::create({.thread_count = 2});
+
+  std::vector<Future<void>> results;
+  for (int i = 0; i < 10; ++i) {
+    results.push_back(AddTo(*executor, {.label = "spin"}, [] {
+      const auto deadline = absl::Now() + absl::Milliseconds(2);
+      while (absl::Now() < deadline) {
+      }
+    }));
+    results.push_back(AddTo(*executor, {.label = "sleep"}, [] {
+      absl::SleepFor(absl::Milliseconds(2));
+    }));
+    results.push_back(AddTo(*executor, [] {}));
+  }
+  for (auto& result : results) {
+    result.Get();
+  }
+  // A worker accounts for the task after its future is set.
+  executor->stop().get();
+
+  const auto stats = executor->GetStats();
+  ASSERT_THAT(stats.labels.size(), Eq(2));
+  // Most CPU time first.
+  const auto& spin = stats.labels[0];
+  EXPECT_THAT(spin.label, Eq("spin"));
+  EXPECT_THAT(spin.count, Eq(10));
+  EXPECT_THAT(spin.wall_time, Ge(absl::Milliseconds(20)));
+  EXPECT_THAT(spin.cpu_time, Gt(absl::ZeroDuration()));
+  EXPECT_THAT(spin.cpu_time, Le(spin.wall_time));
+  const auto& sleep = stats.labels[1];
+  EXPECT_THAT(sleep.label, Eq("sleep"));
+  EXPECT_THAT(sleep.count, Eq(10));
+  EXPECT_THAT(sleep.wall_time, Ge(absl::Milliseconds(20)));
+  EXPECT_THAT(sleep.cpu_time, Lt(absl::Milliseconds(10)));
+}
+
+}  // namespace
+}  // namespace handbag::executor::tests
@@ -1 +1,178 @@
 #include "lib/cpp/executor/executor.h"
+
+#include <memory>
+
+namespace handbag {
+
+namespace {
+absl::AnyInvocable<void() &&> WithCancellation(
+    absl::AnyInvocable<void() &&> task, const TaskOptions& options) {
+  if (!options.cancellation.has_value()) {
+    return task;
+  }
+
+  absl::AnyInvocable<void() &&> res =
+      [token = *options.cancellation, task = std::move(task)]() mutable {
+        if (!token.IsCancelled()) {
+          std::move(task)();
+        }
+      };
+  return res;
+}
+
+struct CancellableTask {
+  CancellationToken token;
+  absl::AnyInvocable<void() &&> task;
+};
+}  // namespace
+
+void IExecutor::Add(absl::AnyInvocable<void() &&> task,
+                    const TaskOptions& options) noexcept {
+  Add(WithCancellation(std::move(task), options));
+}
+
+bool IExecutor::TryAdd(absl::AnyInvocable<void() &&>&& task,
+                       const TaskOptions& options) noexcept {
+  if (!options.cancellation.has_value()) {
+    auto res = TryAdd(std::move(task));
+    return res;
+  }
+
+  // Owned through a pointer so that a rejected task can be taken out of the
+  // wrapper again, and a retry doesn't nest one wrapper in another.
+  auto state = std::make_unique<CancellableTask>(
+      CancellableTask{*options.cancellation, std::move(task)});
+  auto* const inner = state.get();
+  absl::AnyInvocable<void() &&> wrapped = [state = std::move(state)] {
+    if (!state->token.IsCancelled()) {
+      std::move(state->task)();
+    }
+  };
+
+  auto res = TryAdd(std::move(wrapped));
+  if (!res) {
+    task = std::move(inner->task);
+  }
+  return res;
+}
+
+void IExecutor::AddTask(ExecutorTask task,
+                        const TaskOptions& options) noexcept {
+  // Tasks that came from `Add` in the first place are unwrapped.
+  if (auto* const inner = task.target<absl::AnyInvocable<void() &&>>()) {
+    Add(std::move(*inner), options);
+    return;
+  }
+
+  Add(absl::AnyInvocable<void() &&>(std::move(task)), options);
+}
+
+bool IExecutor::TryAddTask(ExecutorTask&& task,
+                           const TaskOptions& options) noexcept {
+  // Tasks that came from `TryAdd` in the first place are unwrapped. A rejected
+  // one is left where it was.
+  if (auto* const inner = task.target<absl::AnyInvocable<void() &&>>()) {
+    auto res = TryAdd(std::move(*inner), options);
+    return res;
+  }
+
+  // Owned through a pointer so that a rejected task can be taken back without
+  // being wrapped again on the next attempt.
+  auto owned = std::make_unique<ExecutorTask>(std::move(task));
+  auto* const inner = owned.get();
+  absl::AnyInvocable<void() &&> wrapped = [owned = std::move(owned)] {
+    std::move(*owned)();
+  };
+
+  auto res = TryAdd(std::move(wrapped), options);
+  if (!res) {
+    task = std::move(*inner);
+  }
+  return res;
+}
+
+void IExecutor::AddBatch(
+    std::span<absl::AnyInvocable<void() &&>> tasks) noexcept {
+  for (auto& task : tasks) {
+    Add(std::move(task));
+  }
+}
+
+size_t IExecutor::TryAddBatch(
+    std::span<absl::AnyInvocable<void() &&>> tasks) noexcept {
+  size_t res = 0;
+  for (auto& task : tasks) {
+    if (!TryAdd(std::move(task))) {
+      break;
+    }
+
+    ++res;
+  }
+
+  return res;
+}
+
+void IExecutor::AddTaskBatch(std::span<ExecutorTask> tasks) noexcept {
+  for (auto& task : tasks) {
+    AddTask(std::move(task), TaskOptions());
+  }
+}
+
+size_t IExecutor::TryAddTaskBatch(std::span<ExecutorTask> tasks) noexcept {
+  size_t res = 0;
+  for (auto& task : tasks) {
+    if (!TryAddTask(std::move(task), TaskOptions())) {
+      break;
+    }
+
+    ++res;
+  }
+
+  return res;
+}
+
+Future<void> IExecutor::WhenHasCapacity(
+    const TaskOptions& /*options*/) noexcept {
+  Promise<void> promise;
+  auto res = promise.GetFuture();
+  promise.SetValue();
+  return res;
+}
+
+bool IsCurrentThreadIn(const IExecutor& executor) noexcept {
+  for (const auto* scope = internal_executor::ScopedCurrentExecutor::Current();
+       scope != nullptr; scope = scope->outer()) {
+    if (scope->executor() == &executor) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+namespace internal_executor {
+
+namespace {
+thread_local const ScopedCurrentExecutor* current_executor = nullptr;
+}  // namespace
+
+ScopedCurrentExecutor::ScopedCurrentExecutor(
+    const IExecutor* const executor) noexcept
+    : executor_(executor), outer_(current_executor) {
+  current_executor = this;
+}
+
+ScopedCurrentExecutor::~ScopedCurrentExecutor() { current_executor = outer_; }
+
+const ScopedCurrentExecutor* ScopedCurrentExecutor::Current() noexcept {
+  return current_executor;
+}
+
+void AddToExecutor(IExecutor& executor,
+                   absl::AnyInvocable<void() &&> task) noexcept {
+  executor.Add(std::move(task));
+}
+
+}  // namespace internal_executor
+
+}  // namespace handbag
@@ -1,56 +1,284 @@
 #pragma once
 
-#include <future>
+#include <cstddef>
 #include <optional>
+#include <ranges>
+#include <span>
+#include <string_view>
 #include <type_traits>
+#include <vector>
 
 #include "absl/functional/any_invocable.h"
+#include "absl/time/time.h"
+#include "lib/cpp/executor/cancellation.h"
+#include "lib/cpp/executor/future.h"
+#include "lib/cpp/executor/inline_task.h"
 #include "lib/cpp/executor/internal/executor.h"
 
 namespace handbag {
 
+enum class ETaskPriority { High, Normal, Low };
+
+constexpr size_t kTaskPriorityCount = 3;
+
+struct TaskOptions {
+  std::optional<ETaskPriority> priority = {};
+  /// Within a priority tasks with a deadline run earliest deadline first and
+  /// before the tasks without one.
+  std::optional<absl::Time> deadline = {};
+  /// A task cancelled before it starts is dropped without being called, its
+  /// future fails with `TaskCancelledError`.
+  std::optional<CancellationToken> cancellation = {};
+  /// A task submitted from one of the executor's own threads may run next on
+  /// that thread, ahead of the queued ones. A yielding task goes behind them,
+  /// e.g. a task that reschedules itself to let others run.
+  std::optional<bool> yield = {};
+  /// Approximate memory the task holds while queued, e.g. the buffer it
+  /// captured, for executors with a memory budget. Defaults to the size of
+  /// the closure, which misses whatever the captures own on the heap.
+  std::optional<size_t> size_bytes = {};
+  /// Kind of the task, e.g. "parse" or "compress", for executors that account
+  /// time per kind. Must outlive the executor, a string literal is the usual
+  /// choice. `CpuExecutor` workers key labels by address and size only, in 63
+  /// slots per worker: every distinct address takes a slot, even if its text
+  /// is the same as another one's, and once the slots are used up the tasks
+  /// of any new address are counted under "(other)". Labels with the same
+  /// text are merged only when the stats are collected. A label built anew
+  /// for every task fills the slots right away.
+  std::optional<std::string_view> label = {};
+};
+
+/// Inline storage of `ExecutorTask`, which makes a task a cache line: enough
+/// for a promise, a couple of `shared_ptr`s and a few ints.
+constexpr size_t kExecutorTaskInlineSize = 56;
+
+using ExecutorTask = InlineTask<kExecutorTaskInlineSize>;
+
 struct IExecutor {
   virtual ~IExecutor() = default;
 
-  virtual void Add(absl::AnyInvocable<void() &&> task) noexcept;
-  virtual bool TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept;
+  virtual void Add(absl::AnyInvocable<void() &&> task) noexcept = 0;
+  virtual bool TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept = 0;
+
+  /// Executors that don't support scheduling options ignore them, which is
+  /// what the default implementations do. Cancellation is supported by all of
+  /// them: the default implementations check the token right before calling
+  /// the task.
+  virtual void Add(absl::AnyInvocable<void() &&> task,
+                   const TaskOptions& options) noexcept;
+  virtual bool TryAdd(absl::AnyInvocable<void() &&>&& task,
+                      const TaskOptions& options) noexcept;
+
+  /// Same as `Add`, but with the closure in an `ExecutorTask`: the tasks built
+  /// by `AddTo` and `AddDetachedTo` reach executors that override it (e.g.
+  /// `CpuExecutor`) without being wrapped again, and without a malloc if they
+  /// fit the inline storage. The default implementation passes the task on to
+  /// `Add`.
+  virtual void AddTask(ExecutorTask task, const TaskOptions& options) noexcept;
+
+  /// Same as `TryAdd`, for the tasks built by `PrepareTask`. The default
+  /// implementation passes the task on to `TryAdd`.
+  virtual bool TryAddTask(ExecutorTask&& task,
+                          const TaskOptions& options) noexcept;
+
+  /// Tasks are moved from. The default implementation calls `Add` one by one.
+  virtual void AddBatch(
+      std::span<absl::AnyInvocable<void() &&>> tasks) noexcept;
+
+  /// Returns the number of accepted tasks. Accepted tasks always form a prefix
+  /// of `tasks`, the rest are left intact.
+  virtual size_t TryAddBatch(
+      std::span<absl::AnyInvocable<void() &&>> tasks) noexcept;
+
+  /// Same as `AddBatch` and `TryAddBatch`, for the tasks built by
+  /// `AddBatchTo` and `TryAddBatchTo`. The default implementations call
+  /// `AddTask` and `TryAddTask` one by one.
+  virtual void AddTaskBatch(std::span<ExecutorTask> tasks) noexcept;
+  virtual size_t TryAddTaskBatch(std::span<ExecutorTask> tasks) noexcept;
+
+  /// Backpressure signal: completes once a `TryAdd` with `options` rejected
+  /// earlier is worth retrying, i.e. once a full queue had a task taken off.
+  /// May complete spuriously, a retry can still fail. The default
+  /// implementation, for executors that never reject tasks, is ready at once.
+  virtual Future<void> WhenHasCapacity(const TaskOptions& options) noexcept;
+};
+
+/// A task and its future, built once so that a task rejected by `TryAddTo`
+/// can be offered again, as it is, without another allocation.
+template <typename T>
+class PreparedTask {
+ public:
+  PreparedTask() = default;
+  PreparedTask(PreparedTask&&) noexcept = default;
+  PreparedTask& operator=(PreparedTask&&) noexcept = default;
+
+  /// `false` once the task was accepted by an executor.
+  bool IsValid() const noexcept { return static_cast<bool>(closure_); }
+
+ private:
+  template <typename Invocable, typename... Args>
+  friend PreparedTask<internal_executor::TaskResult<Invocable, Args...>>
+  PrepareTask(Invocable&& invocable, Args&&... args);
+  template <typename U>
+  friend std::optional<Future<U>> TryAddTo(IExecutor& executor,
+                                           PreparedTask<U>& task,
+                                           const TaskOptions& options);
+
+  PreparedTask(Future<T>&& future, ExecutorTask&& closure) noexcept
+      : future_(std::move(future)), closure_(std::move(closure)) {}
+
+ private:
+  Future<T> future_;
+  ExecutorTask closure_;
 };
 
 template <typename Invocable, typename... Args>
-std::future<
-    std::invoke_result_t<std::decay_t<Invocable>, std::decay_t<Args>...>>
-AddTo(IExecutor& executor, Invocable&& invocable, Args&&... args);
+Future<internal_executor::TaskResult<Invocable, Args...>> AddTo(
+    IExecutor& executor, Invocable&& invocable, Args&&... args);
 
 template <typename Invocable, typename... Args>
-std::optional<std::future<
-    std::invoke_result_t<std::decay_t<Invocable>, std::decay_t<Args>...>>>
+std::optional<Future<internal_executor::TaskResult<Invocable, Args...>>>
 TryAddTo(IExecutor& executor, Invocable&& invocable, Args&&... args);
 
+template <typename Invocable, typename... Args>
+Future<internal_executor::TaskResult<Invocable, Args...>> AddTo(
+    IExecutor& executor, const TaskOptions& options, Invocable&& invocable,
+    Args&&... args);
+
+template <typename Invocable, typename... Args>
+std::optional<Future<internal_executor::TaskResult<Invocable, Args...>>>
+TryAddTo(IExecutor& executor, const TaskOptions& options,
+         Invocable&& invocable, Args&&... args);
+
+template <typename Invocable, typename... Args>
+PreparedTask<internal_executor::TaskResult<Invocable, Args...>> PrepareTask(
+    Invocable&& invocable, Args&&... args);
+
+/// Leaves `task` untouched if the executor rejects it.
+template <typename T>
+std::optional<Future<T>> TryAddTo(IExecutor& executor, PreparedTask<T>& task,
+                                  const TaskOptions& options = {});
+
+/// Fire-and-forget: no promise/future pair is created, exceptions are handled
+/// by the executor.
+template <typename Invocable, typename... Args>
+void AddDetachedTo(IExecutor& executor, Invocable&& invocable, Args&&... args);
+
+template <typename Invocable, typename... Args>
+void AddDetachedTo(IExecutor& executor, const TaskOptions& options,
+                   Invocable&& invocable, Args&&... args);
+
+template <std::ranges::input_range Range>
+std::vector<Future<internal_executor::BatchResult<Range>>> AddBatchTo(
+    IExecutor& executor, Range&& invocables);
+
+/// Futures are returned only for the accepted prefix of `invocables`.
+template <std::ranges::input_range Range>
+std::vector<Future<internal_executor::BatchResult<Range>>> TryAddBatchTo(
+    IExecutor& executor, Range&& invocables);
+
+/// Whether the calling thread is running a task of `executor`, so work meant
+/// for it can be done inline instead of being queued. Also true inside a
+/// strand for both the strand and the executor it runs on.
+bool IsCurrentThreadIn(const IExecutor& executor) noexcept;
+
 /// Impl
 
 template <typename Invocable, typename... Args>
-std::future<
-    std::invoke_result_t<std::decay_t<Invocable>, std::decay_t<Args>...>>
-AddTo(IExecutor& executor, Invocable&& invocable, Args&&... args) {
-  auto [res, closure] = internal_executor::CreateTask(
+Future<internal_executor::TaskResult<Invocable, Args...>> AddTo(
+    IExecutor& executor, Invocable&& invocable, Args&&... args) {
+  auto [res, closure] = internal_executor::CreateTask<ExecutorTask>(
       std::forward<Invocable>(invocable), std::forward<Args>(args)...);
-  executor.Add(std::move(closure));
-  return res;
+  executor.AddTask(std::move(closure), TaskOptions());
+  return std::move(res);
 }
 
 template <typename Invocable, typename... Args>
-std::optional<std::future<
-    std::invoke_result_t<std::decay_t<Invocable>, std::decay_t<Args>...>>>
+std::optional<Future<internal_executor::TaskResult<Invocable, Args...>>>
 TryAddTo(IExecutor& executor, Invocable&& invocable, Args&&... args) {
-  auto [res, closure] = internal_executor::CreateTask(
+  // A rejected task is destroyed here, `PrepareTask` keeps it for a retry.
+  auto task = PrepareTask(std::forward<Invocable>(invocable),
+                          std::forward<Args>(args)...);
+  auto res = TryAddTo(executor, task);
+  return res;
+}
+
+template <typename Invocable, typename... Args>
+Future<internal_executor::TaskResult<Invocable, Args...>> AddTo(
+    IExecutor& executor, const TaskOptions& options, Invocable&& invocable,
+    Args&&... args) {
+  auto [res, closure] = internal_executor::CreateTask<ExecutorTask>(
       std::forward<Invocable>(invocable), std::forward<Args>(args)...);
-  if (executor.TryAdd(std::move(closure))) {
-    return res;
-  } else {
-    // TODO(kostya): move the contents of the closure back into `args`.
+  executor.AddTask(std::move(closure), options);
+  return std::move(res);
+}
+
+template <typename Invocable, typename... Args>
+std::optional<Future<internal_executor::TaskResult<Invocable, Args...>>>
+TryAddTo(IExecutor& executor, const TaskOptions& options,
+         Invocable&& invocable, Args&&... args) {
+  auto task = PrepareTask(std::forward<Invocable>(invocable),
+                          std::forward<Args>(args)...);
+  auto res = TryAddTo(executor, task, options);
+  return res;
+}
+
+template <typename Invocable, typename... Args>
+PreparedTask<internal_executor::TaskResult<Invocable, Args...>> PrepareTask(
+    Invocable&& invocable, Args&&... args) {
+  auto [future, closure] = internal_executor::CreateTask<ExecutorTask>(
+      std::forward<Invocable>(invocable), std::forward<Args>(args)...);
+  PreparedTask<internal_executor::TaskResult<Invocable, Args...>> res(
+      std::move(future), std::move(closure));
+  return res;
+}
+
+template <typename T>
+std::optional<Future<T>> TryAddTo(IExecutor& executor, PreparedTask<T>& task,
+                                  const TaskOptions& options) {
+  if (!executor.TryAddTask(std::move(task.closure_), options)) {
+    return std::nullopt;
   }
 
-  return std::nullopt;
+  task.closure_ = ExecutorTask();
+  return std::move(task.future_);
+}
+
+template <typename Invocable, typename... Args>
+void AddDetachedTo(IExecutor& executor, Invocable&& invocable,
+                   Args&&... args) {
+  executor.AddTask(internal_executor::CreateDetachedTask<ExecutorTask>(
+                       std::forward<Invocable>(invocable),
+                       std::forward<Args>(args)...),
+                   TaskOptions());
+}
+
+template <typename Invocable, typename... Args>
+void AddDetachedTo(IExecutor& executor, const TaskOptions& options,
+                   Invocable&& invocable, Args&&... args) {
+  executor.AddTask(internal_executor::CreateDetachedTask<ExecutorTask>(
+                       std::forward<Invocable>(invocable),
+                       std::forward<Args>(args)...),
+                   options);
+}
+
+template <std::ranges::input_range Range>
+std::vector<Future<internal_executor::BatchResult<Range>>> AddBatchTo(
+    IExecutor& executor, Range&& invocables) {
+  auto [res, closures] = internal_executor::CreateTasks<ExecutorTask>(
+      std::forward<Range>(invocables));
+  executor.AddTaskBatch(closures);
+  return std::move(res);
+}
+
+template <std::ranges::input_range Range>
+std::vector<Future<internal_executor::BatchResult<Range>>> TryAddBatchTo(
+    IExecutor& executor, Range&& invocables) {
+  auto [res, closures] = internal_executor::CreateTasks<ExecutorTask>(
+      std::forward<Range>(invocables));
+  const auto accepted = executor.TryAddTaskBatch(closures);
+  res.resize(accepted);
+  return std::move(res);
 }
 
 }  // namespace handbag
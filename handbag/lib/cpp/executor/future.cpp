@@ -0,0 +1 @@
+#include "lib/cpp/executor/future.h"
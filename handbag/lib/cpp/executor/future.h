@@ -0,0 +1,367 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "absl/base/optimization.h"
+#include "absl/functional/any_invocable.h"
+
+namespace handbag {
+
+struct IExecutor;
+
+template <typename T>
+class Future;
+
+template <typename T>
+class Promise;
+
+namespace internal_executor {
+
+/// Defined in executor.cpp, lets this header avoid depending on executor.h.
+void AddToExecutor(IExecutor& executor,
+                   absl::AnyInvocable<void() &&> task) noexcept;
+
+/// State shared by a `Promise` and its `Future`. Both of them hold a reference,
+/// it's the only allocation made per promise/future pair.
+template <typename T>
+class SharedState {
+  static constexpr uint32_t kReady = 1;
+  static constexpr uint32_t kHasContinuation = 2;
+  static constexpr uint32_t kHasWaiters = 4;
+
+ public:
+  using Value = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+  void Ref() noexcept { refs_.fetch_add(1, std::memory_order_relaxed); }
+
+  void Unref() noexcept {
+    if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+
+  template <typename... Args>
+  void SetValue(Args&&... args) noexcept {
+    try {
+      value_.emplace(std::forward<Args>(args)...);
+    } catch (...) {
+      exception_ = std::current_exception();
+    }
+    Publish();
+  }
+
+  void SetException(std::exception_ptr eptr) noexcept {
+    exception_ = std::move(eptr);
+    Publish();
+  }
+
+  bool IsReady() const noexcept {
+    auto res = (state_.load(std::memory_order_acquire) & kReady) != 0;
+    return res;
+  }
+
+  void Wait() noexcept {
+    auto state = state_.load(std::memory_order_acquire);
+    while ((state & kReady) == 0) {
+      if ((state & kHasWaiters) == 0 &&
+          !state_.compare_exchange_weak(state, state | kHasWaiters,
+                                        std::memory_order_acq_rel)) {
+        continue;
+      }
+
+      state_.wait(state | kHasWaiters, std::memory_order_acquire);
+      state = state_.load(std::memory_order_acquire);
+    }
+  }
+
+  /// Must be called at most once, after the state became ready.
+  Value TakeValue() {
+    if (exception_) {
+      std::rethrow_exception(exception_);
+    }
+
+    auto res = std::move(*value_);
+    return res;
+  }
+
+  /// Runs `continuation` right away if the state is ready, otherwise it will
+  /// be run by whoever makes it ready. At most one continuation is allowed.
+  void SetContinuation(absl::AnyInvocable<void() &&> continuation) noexcept {
+    continuation_ = std::move(continuation);
+    const auto prev =
+        state_.fetch_or(kHasContinuation, std::memory_order_acq_rel);
+    if (prev & kReady) {
+      RunContinuation();
+    }
+  }
+
+ private:
+  void Publish() noexcept {
+    const auto prev = state_.fetch_or(kReady, std::memory_order_acq_rel);
+    if (ABSL_PREDICT_FALSE(prev & kHasWaiters)) {
+      state_.notify_all();
+    }
+
+    if (prev & kHasContinuation) {
+      RunContinuation();
+    }
+  }
+
+  void RunContinuation() noexcept {
+    // Continuation may own a reference to this state, so it must not outlive
+    // the call.
+    auto continuation = std::move(continuation_);
+    std::move(continuation)();
+  }
+
+ private:
+  std::atomic<uint32_t> state_ = 0;
+  std::atomic<uint32_t> refs_ = 1;
+  std::optional<Value> value_;
+  std::exception_ptr exception_;
+  absl::AnyInvocable<void() &&> continuation_;
+};
+
+/// Runs `invocable` and stores its result or exception in `promise`.
+template <typename T, typename Invocable>
+void Fulfill(Promise<T>& promise, Invocable&& invocable) noexcept {
+  try {
+    if constexpr (std::is_void_v<T>) {
+      std::invoke(std::forward<Invocable>(invocable));
+      promise.SetValue();
+    } else {
+      promise.SetValue(std::invoke(std::forward<Invocable>(invocable)));
+    }
+  } catch (...) {
+    promise.SetException(std::current_exception());
+  }
+}
+
+template <typename T>
+class FutureAwaiter;
+
+template <typename T, typename Invocable>
+struct ThenResult {
+  using type = std::invoke_result_t<std::decay_t<Invocable>, T>;
+};
+
+template <typename Invocable>
+struct ThenResult<void, Invocable> {
+  using type = std::invoke_result_t<std::decay_t<Invocable>>;
+};
+
+template <typename T, typename Invocable>
+using ThenResultT =
+    typename std::conditional_t<std::is_invocable_v<std::decay_t<Invocable>,
+                                                    Future<T>>,
+                                std::invoke_result<std::decay_t<Invocable>,
+                                                   Future<T>>,
+                                ThenResult<T, Invocable>>::type;
+
+}  // namespace internal_executor
+
+/// Move-only handle to the result of an asynchronous computation. Unlike
+/// `std::future` it costs a single allocation shared with its `Promise` and
+/// supports continuations.
+template <typename T>
+class Future {
+  using State = internal_executor::SharedState<T>;
+
+ public:
+  Future() = default;
+  Future(const Future&) = delete;
+  Future& operator=(const Future&) = delete;
+  Future(Future&& other) noexcept
+      : state_(std::exchange(other.state_, nullptr)) {}
+  Future& operator=(Future&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      state_ = std::exchange(other.state_, nullptr);
+    }
+    return *this;
+  }
+  ~Future() { Reset(); }
+
+  bool IsValid() const noexcept { return state_ != nullptr; }
+
+  bool IsReady() const noexcept {
+    auto res = state_->IsReady();
+    return res;
+  }
+
+  void Wait() const noexcept { state_->Wait(); }
+
+  /// Blocks until the result is available, rethrows the exception if the
+  /// computation failed. Invalidates the future.
+  T Get() {
+    state_->Wait();
+    const Future holder(std::exchange(state_, nullptr));
+    if constexpr (std::is_void_v<T>) {
+      holder.state_->TakeValue();
+    } else {
+      return holder.state_->TakeValue();
+    }
+  }
+
+  /// Runs `invocable` on `executor` once the result is available. `invocable`
+  /// is called either with this future (already ready) or with its value; in
+  /// the latter case an exception skips `invocable` and is passed on to the
+  /// returned future. Invalidates the future.
+  template <typename Invocable>
+  Future<internal_executor::ThenResultT<T, Invocable>> Then(
+      IExecutor& executor, Invocable&& invocable) &&;
+
+  /// Suspends the awaiting coroutine until the result is available. It is
+  /// resumed on the thread that provides the result, `co_await ScheduleOn()`
+  /// afterwards to move elsewhere. Invalidates the future.
+  internal_executor::FutureAwaiter<T> operator co_await() && noexcept;
+
+ private:
+  template <typename>
+  friend class Future;
+  template <typename>
+  friend class internal_executor::FutureAwaiter;
+  template <typename>
+  friend class Promise;
+
+  explicit Future(State* const state) noexcept : state_(state) {}
+
+  void Reset() noexcept {
+    if (state_ != nullptr) {
+      std::exchange(state_, nullptr)->Unref();
+    }
+  }
+
+ private:
+  State* state_ = nullptr;
+};
+
+template <typename T>
+class Promise {
+  using State = internal_executor::SharedState<T>;
+
+ public:
+  Promise() : state_(new State()) {}
+  Promise(const Promise&) = delete;
+  Promise& operator=(const Promise&) = delete;
+  Promise(Promise&& other) noexcept
+      : state_(std::exchange(other.state_, nullptr)) {}
+  Promise& operator=(Promise&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      state_ = std::exchange(other.state_, nullptr);
+    }
+    return *this;
+  }
+  ~Promise() { Reset(); }
+
+  bool IsValid() const noexcept { return state_ != nullptr; }
+
+  /// Must be called at most once.
+  Future<T> GetFuture() noexcept {
+    state_->Ref();
+    Future<T> res(state_);
+    return res;
+  }
+
+  template <typename... Args>
+  void SetValue(Args&&... args) noexcept {
+    auto* const state = std::exchange(state_, nullptr);
+    state->SetValue(std::forward<Args>(args)...);
+    state->Unref();
+  }
+
+  void SetException(std::exception_ptr eptr) noexcept {
+    auto* const state = std::exchange(state_, nullptr);
+    state->SetException(std::move(eptr));
+    state->Unref();
+  }
+
+ private:
+  /// A promise dropped without a result breaks its future.
+  void Reset() noexcept {
+    if (state_ != nullptr) {
+      SetException(std::make_exception_ptr(
+          std::future_error(std::future_errc::broken_promise)));
+    }
+  }
+
+ private:
+  State* state_ = nullptr;
+};
+
+/// Impl
+
+namespace internal_executor {
+
+template <typename T>
+class FutureAwaiter {
+ public:
+  explicit FutureAwaiter(Future<T>&& future) noexcept
+      : future_(std::move(future)) {}
+
+  bool await_ready() const noexcept { return future_.IsReady(); }
+
+  void await_suspend(const std::coroutine_handle<> handle) noexcept {
+    future_.state_->SetContinuation([handle] { handle.resume(); });
+  }
+
+  T await_resume() { return future_.Get(); }
+
+ private:
+  Future<T> future_;
+};
+
+}  // namespace internal_executor
+
+template <typename T>
+internal_executor::FutureAwaiter<T> Future<T>::operator co_await() &&
+    noexcept {
+  internal_executor::FutureAwaiter<T> res(std::move(*this));
+  return res;
+}
+
+template <typename T>
+template <typename Invocable>
+Future<internal_executor::ThenResultT<T, Invocable>> Future<T>::Then(
+    IExecutor& executor, Invocable&& invocable) && {
+  using Result = internal_executor::ThenResultT<T, Invocable>;
+
+  Promise<Result> promise;
+  auto res = promise.GetFuture();
+
+  // The reference held by this future is handed over to the continuation.
+  auto* const state = std::exchange(state_, nullptr);
+  state->SetContinuation(
+      [state, &executor, invocable = std::forward<Invocable>(invocable),
+       promise = std::move(promise)]() mutable {
+        internal_executor::AddToExecutor(
+            executor, [ready = Future(state), invocable = std::move(invocable),
+                       promise = std::move(promise)]() mutable {
+              internal_executor::Fulfill(promise, [&]() -> Result {
+                if constexpr (std::is_invocable_v<std::decay_t<Invocable>,
+                                                  Future<T>>) {
+                  return std::invoke(std::move(invocable), std::move(ready));
+                } else if constexpr (std::is_void_v<T>) {
+                  ready.Get();
+                  return std::invoke(std::move(invocable));
+                } else {
+                  return std::invoke(std::move(invocable), ready.Get());
+                }
+              });
+            });
+      });
+
+  return res;
+}
+
+}  // namespace handbag
@@ -0,0 +1,196 @@
+#include "lib/cpp/executor/future.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "lib/cpp/executor/cpu.h"
+#include "lib/cpp/executor/executor.h"
+
+using namespace ::testing;
+
+namespace handbag::tests {
+namespace {
+
+TEST(FutureTest, SetBeforeGet) {
+  Promise<int> promise;
+  auto future = promise.GetFuture();
+  EXPECT_FALSE(future.IsReady());
+
+  promise.SetValue(7);
+  EXPECT_TRUE(future.IsReady());
+  EXPECT_THAT(future.Get(), Eq(7));
+  EXPECT_FALSE(future.IsValid());
+}
+
+TEST(FutureTest, GetBlocksUntilSet) {
+  Promise<std::unique_ptr<int>> promise;
+  auto future = promise.GetFuture();
+
+  std::thread setter(
+      [promise = std::move(promise)]() mutable {
+        promise.SetValue(std::make_unique<int>(3));
+      });
+  EXPECT_THAT(future.Get(), Pointee(Eq(3)));
+  setter.join();
+}
+
+TEST(FutureTest, Exception) {
+  Promise<void> promise;
+  auto future = promise.GetFuture();
+  promise.SetException(std::make_exception_ptr(std::runtime_error("NEEDLE")));
+
+  EXPECT_THAT([&] { future.Get(); },
+              ThrowsMessage<std::runtime_error>(Eq("NEEDLE")));
+}
+
+TEST(FutureTest, BrokenPromise) {
+  Future<int> future;
+  {
+    Promise<int> promise;
+    future = promise.GetFuture();
+  }
+
+  EXPECT_THROW(future.Get(), std::future_error);
+}
+
+TEST(FutureTest, Then) {
+  auto executor = executor::CpuExecutor::create({.thread_count = 2});
+
+  auto future = AddTo(*executor, [] { return 20; })
+                    .Then(*executor, [](const int value) { return value + 1; })
+                    .Then(*executor, [](const int value) {
+                      return std::to_string(value * 2);
+                    });
+  EXPECT_THAT(future.Get(), Eq("42"));
+
+  executor->stop().get();
+}
+
+TEST(FutureTest, ThenSkipsInvocableOnException) {
+  auto executor = executor::CpuExecutor::create({.thread_count = 2});
+
+  std::atomic<bool> called = false;
+  auto future = AddTo(*executor, []() -> int {
+                  throw std::runtime_error("NEEDLE");
+                }).Then(*executor, [&](int) { called = true; });
+  EXPECT_THAT([&] { future.Get(); },
+              ThrowsMessage<std::runtime_error>(Eq("NEEDLE")));
+  EXPECT_FALSE(called.load());
+
+  auto recovered =
+      AddTo(*executor, []() -> int { throw std::runtime_error("NEEDLE"); })
+          .Then(*executor, [](Future<int> ready) {
+            try {
+              return ready.Get();
+            } catch (const std::runtime_error&) {
+              return -1;
+            }
+          });
+  EXPECT_THAT(recovered.Get(), Eq(-1));
+
+  executor->stop().get();
+}
+
+TEST(FutureTest, AddDetachedTo) {
+  auto executor = executor::CpuExecutor::create({.thread_count = 2});
+
+  Promise<int> promise;
+  auto future = promise.GetFuture();
+  AddDetachedTo(
+      *executor,
+      [](Promise<int>&& promise, const int value) {
+        promise.SetValue(value);
+      },
+      std::move(promise), 5);
+  EXPECT_THAT(future.Get(), Eq(5));
+
+  executor->stop().get();
+}
+
+TEST(FutureTest, CancellationOnAnyExecutor) {
+  auto executor = executor::CpuExecutor::create({.thread_count = 1});
+
+  // Only the default implementation of `Add` with options knows about the
+  // token here.
+  struct Forwarder final : IExecutor {
+    explicit Forwarder(IExecutor& target) : target(target) {}
+
+    void Add(absl::AnyInvocable<void() &&> task) noexcept override {
+      target.Add(std::move(task));
+    }
+    bool TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept override {
+      auto res = target.TryAdd(std::move(task));
+      return res;
+    }
+
+    IExecutor& target;
+  } forwarder(*executor);
+
+  CancellationSource source;
+  source.Cancel();
+  auto future = AddTo(forwarder, {.cancellation = source.GetToken()},
+                      [] { return 1; });
+  EXPECT_THROW(future.Get(), TaskCancelledError);
+
+  executor->stop().get();
+}
+
+TEST(FutureTest, RejectedTaskIsHandedBackUnwrapped) {
+  struct Rejecting final : IExecutor {
+    void Add(absl::AnyInvocable<void() &&> /*task*/) noexcept override {}
+    bool TryAdd(absl::AnyInvocable<void() &&>&& /*task*/) noexcept override {
+      return false;
+    }
+  } rejecting;
+
+  CancellationSource source;
+  source.Cancel();
+  const TaskOptions options{.cancellation = source.GetToken()};
+  size_t calls = 0;
+  absl::AnyInvocable<void() &&> task = [&calls] { ++calls; };
+  IExecutor& executor = rejecting;
+  for (size_t i = 0; i < 3; ++i) {
+    EXPECT_FALSE(executor.TryAdd(std::move(task), options));
+  }
+
+  // Not wrapped in the token check anymore.
+  std::move(task)();
+  EXPECT_THAT(calls, Eq(1));
+}
+
+TEST(FutureTest, PreparedTaskOnAnyExecutor) {
+  struct Rejecting final : IExecutor {
+    void Add(absl::AnyInvocable<void() &&> /*task*/) noexcept override {}
+    bool TryAdd(absl::AnyInvocable<void() &&>&& /*task*/) noexcept override {
+      return false;
+    }
+  } rejecting;
+  auto executor = executor::CpuExecutor::create({.thread_count = 1});
+
+  // Too large for the inline storage of `ExecutorTask`.
+  std::array<char, 100> payload{};
+  payload.back() = 'x';
+  auto task = PrepareTask([payload] { return payload.back(); });
+  for (size_t i = 0; i < 3; ++i) {
+    EXPECT_THAT(TryAddTo(rejecting, task), Eq(std::nullopt));
+    EXPECT_TRUE(task.IsValid());
+  }
+
+  auto result = TryAddTo(*executor, task);
+  ASSERT_TRUE(result.has_value());
+  EXPECT_FALSE(task.IsValid());
+  EXPECT_THAT(result->Get(), Eq('x'));
+
+  executor->stop().get();
+}
+
+}  // namespace
+}  // namespace handbag::tests
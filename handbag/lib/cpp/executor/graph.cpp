@@ -0,0 +1,180 @@
+#include "lib/cpp/executor/graph.h"
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <utility>
+
+#include "absl/log/check.h"
+
+namespace handbag::internal_executor {
+
+struct TaskGraphNode {
+  absl::AnyInvocable<void()> task = {};
+  std::vector<TaskGraph::NodeId> successors = {};
+  uint32_t dependency_count = 0;
+};
+
+namespace {
+
+using NodeId = TaskGraph::NodeId;
+
+/// Pending dependencies of every node for a single run of the graph.
+class TaskGraphRun : public std::enable_shared_from_this<TaskGraphRun> {
+ public:
+  TaskGraphRun(IExecutor& executor, std::span<TaskGraphNode> nodes)
+      : executor_(executor),
+        nodes_(nodes),
+        pending_(std::make_unique<std::atomic<uint32_t>[]>(nodes.size())),
+        unfinished_(nodes.size()) {
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      pending_[i].store(nodes_[i].dependency_count,
+                        std::memory_order_relaxed);
+    }
+  }
+
+  Future<void> Start() {
+    auto res = promise_.GetFuture();
+
+    std::vector<NodeId> ready;
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      if (nodes_[i].dependency_count == 0) {
+        ready.push_back(i);
+      }
+    }
+
+    Offload(ready, 0);
+    Drain(std::move(ready));
+    return res;
+  }
+
+ private:
+  /// Runs the nodes in `ready` and whatever they make ready, handing all but
+  /// one of the ready nodes over to the executor whenever it accepts them.
+  void Drain(std::vector<NodeId> ready) noexcept {
+    while (!ready.empty()) {
+      const auto id = ready.back();
+      ready.pop_back();
+      Execute(id);
+
+      for (const auto successor : nodes_[id].successors) {
+        if (pending_[successor].fetch_sub(1, std::memory_order_acq_rel) ==
+            1) {
+          ready.push_back(successor);
+        }
+      }
+      Finish();
+      Offload(ready, 1);
+    }
+  }
+
+  /// Offers all but the last `keep` nodes of `ready` to the executor, the
+  /// rejected ones stay.
+  void Offload(std::vector<NodeId>& ready, const size_t keep) noexcept {
+    if (ready.size() <= keep) {
+      return;
+    }
+
+    std::vector<absl::AnyInvocable<void() &&>> tasks;
+    tasks.reserve(ready.size() - keep);
+    for (size_t i = 0; i + keep < ready.size(); ++i) {
+      tasks.push_back([self = shared_from_this(), id = ready[i]] {
+        self->Drain({id});
+      });
+    }
+
+    const auto accepted = executor_.TryAddBatch(tasks);
+    ready.erase(ready.begin(),
+                ready.begin() + static_cast<std::ptrdiff_t>(accepted));
+  }
+
+  void Execute(const NodeId id) noexcept {
+    if (failed_.load(std::memory_order_relaxed)) {
+      return;
+    }
+
+    try {
+      nodes_[id].task();
+    } catch (...) {
+      if (!failed_.exchange(true, std::memory_order_relaxed)) {
+        exception_ = std::current_exception();
+      }
+    }
+  }
+
+  void Finish() noexcept {
+    if (unfinished_.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+      return;
+    }
+
+    if (exception_) {
+      promise_.SetException(exception_);
+    } else {
+      promise_.SetValue();
+    }
+  }
+
+ private:
+  IExecutor& executor_;
+  const std::span<TaskGraphNode> nodes_;
+  const std::unique_ptr<std::atomic<uint32_t>[]> pending_;
+  std::atomic<size_t> unfinished_;
+  std::atomic<bool> failed_ = false;
+  // Written by the first failing node before it finishes.
+  std::exception_ptr exception_;
+  Promise<void> promise_;
+};
+
+}  // namespace
+}  // namespace handbag::internal_executor
+
+namespace handbag {
+
+TaskGraph::TaskGraph() = default;
+TaskGraph::TaskGraph(TaskGraph&&) noexcept = default;
+TaskGraph& TaskGraph::operator=(TaskGraph&&) noexcept = default;
+TaskGraph::~TaskGraph() = default;
+
+TaskGraph::NodeId TaskGraph::Add(absl::AnyInvocable<void()> task,
+                                 const std::span<const NodeId> dependencies) {
+  const auto res = nodes_.size();
+  for (const auto dependency : dependencies) {
+    CHECK(dependency < res) << "unknown dependency " << dependency;
+    nodes_[dependency].successors.push_back(res);
+  }
+
+  nodes_.push_back({.task = std::move(task),
+                    .dependency_count =
+                        static_cast<uint32_t>(dependencies.size())});
+  return res;
+}
+
+TaskGraph::NodeId TaskGraph::Add(
+    absl::AnyInvocable<void()> task,
+    const std::initializer_list<NodeId> dependencies) {
+  auto res = Add(std::move(task),
+                 std::span<const NodeId>(dependencies.begin(),
+                                         dependencies.size()));
+  return res;
+}
+
+size_t TaskGraph::size() const noexcept {
+  auto res = nodes_.size();
+  return res;
+}
+
+Future<void> TaskGraph::Run(IExecutor& executor) {
+  if (nodes_.empty()) {
+    Promise<void> promise;
+    auto res = promise.GetFuture();
+    promise.SetValue();
+    return res;
+  }
+
+  auto res = std::make_shared<internal_executor::TaskGraphRun>(executor, nodes_)
+                 ->Start();
+  return res;
+}
+
+}  // namespace handbag
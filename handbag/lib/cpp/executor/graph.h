@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+#include <span>
+#include <vector>
+
+#include "absl/functional/any_invocable.h"
+#include "lib/cpp/executor/executor.h"
+#include "lib/cpp/executor/future.h"
+
+namespace handbag::internal_executor {
+struct TaskGraphNode;
+}  // namespace handbag::internal_executor
+
+namespace handbag {
+
+/// Tasks with dependencies between them. Every run of the graph hands a task
+/// over to the executor only once all of its dependencies are done, so no
+/// thread ever waits for another task. The graph is built once and may be run
+/// any number of times.
+///
+/// A task can only depend on tasks added before it, so the graph has no
+/// cycles by construction.
+class TaskGraph {
+ public:
+  using NodeId = size_t;
+
+  TaskGraph();
+  TaskGraph(const TaskGraph&) = delete;
+  TaskGraph& operator=(const TaskGraph&) = delete;
+  TaskGraph(TaskGraph&&) noexcept;
+  TaskGraph& operator=(TaskGraph&&) noexcept;
+  ~TaskGraph();
+
+  NodeId Add(absl::AnyInvocable<void()> task,
+             std::span<const NodeId> dependencies = {});
+  NodeId Add(absl::AnyInvocable<void()> task,
+             std::initializer_list<NodeId> dependencies);
+
+  size_t size() const noexcept;
+
+  /// Runs every task once on `executor`. Ready tasks the executor doesn't
+  /// accept right away (e.g. a bounded queue is full) are run by the thread
+  /// that made them ready, so a full executor slows a run down but never
+  /// blocks it.
+  ///
+  /// The returned future fails with the first exception thrown by a task;
+  /// tasks that haven't started by then are skipped. The graph must outlive
+  /// the run and must not be changed while it runs; tasks of overlapping runs
+  /// may be called concurrently.
+  Future<void> Run(IExecutor& executor);
+
+ private:
+  std::vector<internal_executor::TaskGraphNode> nodes_;
+};
+
+}  // namespace handbag
@@ -0,0 +1,132 @@
+#include "lib/cpp/executor/graph.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "lib/cpp/executor/cpu.h"
+
+using namespace ::testing;
+
+namespace handbag::tests {
+namespace {
+
+TEST(TaskGraphTest, Empty) {
+  auto executor = executor::CpuExecutor::create({.thread_count = 1});
+
+  TaskGraph graph;
+  graph.Run(*executor).Get();
+
+  executor->stop().get();
+}
+
+TEST(TaskGraphTest, RespectsDependencies) {
+  auto executor = executor::CpuExecutor::create({.thread_count = 4});
+
+  absl::Mutex mutex;
+  std::vector<int> order;
+  const auto record = [&](const int value) {
+    return [&, value] {
+      const absl::MutexLock lock(&mutex);
+      order.push_back(value);
+    };
+  };
+
+  // 0 -> {1, 2} -> 3
+  TaskGraph graph;
+  const auto top = graph.Add(record(0));
+  const auto left = graph.Add(record(1), {top});
+  const auto right = graph.Add(record(2), {top});
+  graph.Add(record(3), {left, right});
+
+  for (int run = 0; run < 100; ++run) {
+    order.clear();
+    graph.Run(*executor).Get();
+    ASSERT_THAT(order, SizeIs(4));
+    EXPECT_THAT(order.front(), Eq(0));
+    EXPECT_THAT(order.back(), Eq(3));
+  }
+
+  executor->stop().get();
+}
+
+TEST(TaskGraphTest, LargeGraph) {
+  auto executor = executor::CpuExecutor::create({.thread_count = 4});
+
+  // Layers of nodes, every node depends on two nodes of the previous layer.
+  constexpr size_t kWidth = 1000;
+  constexpr size_t kDepth = 100;
+  std::vector<std::atomic<int>> runs(kWidth * kDepth);
+  std::atomic<bool> early = false;
+  TaskGraph graph;
+  for (size_t layer = 0; layer < kDepth; ++layer) {
+    for (size_t i = 0; i < kWidth; ++i) {
+      const auto id = layer * kWidth + i;
+      if (layer == 0) {
+        graph.Add([&, id] { (void)runs[id].fetch_add(1); });
+        continue;
+      }
+
+      const auto first = id - kWidth;
+      const auto second = first - i + (i + 1) % kWidth;
+      graph.Add(
+          [&, id, first, second] {
+            if (runs[first] <= runs[id] || runs[second] <= runs[id]) {
+              early = true;
+            }
+            (void)runs[id].fetch_add(1);
+          },
+          {first, second});
+    }
+  }
+
+  graph.Run(*executor).Get();
+  graph.Run(*executor).Get();
+  EXPECT_FALSE(early.load());
+  EXPECT_TRUE(std::all_of(runs.begin(), runs.end(),
+                          [](const auto& count) { return count == 2; }));
+
+  executor->stop().get();
+}
+
+TEST(TaskGraphTest, FailureSkipsDependents) {
+  auto executor = executor::CpuExecutor::create({.thread_count = 2});
+
+  std::atomic<bool> dependent_ran = false;
+  TaskGraph graph;
+  const auto failing =
+      graph.Add([] { throw std::runtime_error("NEEDLE"); });
+  graph.Add([&] { dependent_ran = true; }, {failing});
+
+  EXPECT_THAT([&] { graph.Run(*executor).Get(); },
+              ThrowsMessage<std::runtime_error>(Eq("NEEDLE")));
+  EXPECT_FALSE(dependent_ran.load());
+
+  executor->stop().get();
+}
+
+TEST(TaskGraphTest, FullBoundedExecutor) {
+  // Nodes the executor rejects run on the thread that made them ready.
+  auto executor = executor::CpuExecutor::create(
+      {.thread_count = 1, .queue_capacity = 1});
+
+  std::atomic<int> done = 0;
+  TaskGraph graph;
+  const auto root = graph.Add([&] { (void)done.fetch_add(1); });
+  for (int i = 0; i < 100; ++i) {
+    graph.Add([&] { (void)done.fetch_add(1); }, {root});
+  }
+
+  graph.Run(*executor).Get();
+  EXPECT_THAT(done.load(), Eq(101));
+
+  executor->stop().get();
+}
+
+}  // namespace
+}  // namespace handbag::tests
@@ -0,0 +1 @@
+#include "lib/cpp/executor/inline_task.h"
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "lib/cpp/executor/internal/frame_pool.h"
+
+namespace handbag {
+
+/// Where `InlineTask` keeps callables that don't fit its inline storage.
+enum class ETaskOverflow {
+  Heap,
+  /// The per-thread free lists coroutine frames come from, so large tasks
+  /// don't go to malloc once the lists are warm, whether they run on the
+  /// thread that created them or on another one, see
+  /// `internal_executor::AllocateFrame`.
+  ThreadCache,
+};
+
+/// Move-only `void() &&` callable, like `absl::AnyInvocable<void() &&>`, with
+/// room for `kInlineSize` bytes of captures. Larger callables, over-aligned
+/// ones and ones that may throw when moved are stored according to
+/// `kOverflow`.
+template <size_t kInlineSize,
+          ETaskOverflow kOverflow = ETaskOverflow::ThreadCache>
+class InlineTask {
+  static_assert(kInlineSize >= sizeof(void*));
+
+  struct Ops {
+    void (*invoke)(void* storage);
+    /// Moves the callable from `from` to `to` and destroys the source.
+    void (*relocate)(void* from, void* to) noexcept;
+    void (*destroy)(void* storage) noexcept;
+    /// Size of the out-of-line callable, zero for inline ones.
+    size_t remote_size;
+  };
+
+  template <typename F>
+  static constexpr bool kFitsInline =
+      sizeof(F) <= kInlineSize && alignof(F) <= alignof(std::max_align_t) &&
+      std::is_nothrow_move_constructible_v<F>;
+
+  template <typename F>
+  struct InlineOps {
+    static F* Get(void* const storage) noexcept {
+      return std::launder(reinterpret_cast<F*>(storage));
+    }
+
+    static void Invoke(void* const storage) { std::move(*Get(storage))(); }
+
+    static void Relocate(void* const from, void* const to) noexcept {
+      auto* const callable = Get(from);
+      ::new (to) F(std::move(*callable));
+      callable->~F();
+    }
+
+    static void Destroy(void* const storage) noexcept { Get(storage)->~F(); }
+
+    static constexpr Ops kOps = {&Invoke, &Relocate, &Destroy, 0};
+  };
+
+  /// The inline storage holds a pointer to the callable.
+  template <typename F>
+  struct RemoteOps {
+    static F*& Get(void* const storage) noexcept {
+      return *std::launder(reinterpret_cast<F**>(storage));
+    }
+
+    static F* Allocate() {
+      if constexpr (alignof(F) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+        return static_cast<F*>(
+            ::operator new(sizeof(F), std::align_val_t(alignof(F))));
+      } else if constexpr (kOverflow == ETaskOverflow::ThreadCache) {
+        return static_cast<F*>(internal_executor::AllocateFrame(sizeof(F)));
+      } else {
+        return static_cast<F*>(::operator new(sizeof(F)));
+      }
+    }
+
+    static void Deallocate(F* const callable) noexcept {
+      if constexpr (alignof(F) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+        ::operator delete(callable, std::align_val_t(alignof(F)));
+      } else if constexpr (kOverflow == ETaskOverflow::ThreadCache) {
+        internal_executor::DeallocateFrame(callable, sizeof(F));
+      } else {
+        ::operator delete(callable);
+      }
+    }
+
+    static void Invoke(void* const storage) { std::move(*Get(storage))(); }
+
+    static void Relocate(void* const from, void* const to) noexcept {
+      ::new (to) F*(Get(from));
+    }
+
+    static void Destroy(void* const storage) noexcept {
+      auto* const callable = Get(storage);
+      callable->~F();
+      Deallocate(callable);
+    }
+
+    static constexpr Ops kOps = {&Invoke, &Relocate, &Destroy, sizeof(F)};
+  };
+
+ public:
+  InlineTask() = default;
+
+  template <typename Invocable,
+            typename F = std::decay_t<Invocable>,
+            typename = std::enable_if_t<!std::is_same_v<F, InlineTask> &&
+                                        std::is_invocable_r_v<void, F&&>>>
+  InlineTask(Invocable&& invocable) {  // NOLINT(google-explicit-constructor)
+    if constexpr (kFitsInline<F>) {
+      ::new (storage_) F(std::forward<Invocable>(invocable));
+      ops_ = &InlineOps<F>::kOps;
+    } else {
+      auto* const callable = RemoteOps<F>::Allocate();
+      try {
+        ::new (callable) F(std::forward<Invocable>(invocable));
+      } catch (...) {
+        RemoteOps<F>::Deallocate(callable);
+        throw;
+      }
+      ::new (storage_) F*(callable);
+      ops_ = &RemoteOps<F>::kOps;
+    }
+  }
+
+  InlineTask(const InlineTask&) = delete;
+  InlineTask& operator=(const InlineTask&) = delete;
+
+  InlineTask(InlineTask&& other) noexcept : ops_(other.ops_) {
+    if (ops_ != nullptr) {
+      ops_->relocate(other.storage_, storage_);
+      other.ops_ = nullptr;
+    }
+  }
+
+  InlineTask& operator=(InlineTask&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      if (other.ops_ != nullptr) {
+        other.ops_->relocate(other.storage_, storage_);
+        ops_ = std::exchange(other.ops_, nullptr);
+      }
+    }
+    return *this;
+  }
+
+  ~InlineTask() { Reset(); }
+
+  explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+  void operator()() && { ops_->invoke(storage_); }
+
+  /// Approximate memory held by the task: the task itself and the callable
+  /// if it's stored out of line, but not what the callable owns in turn.
+  size_t GetSize() const noexcept {
+    auto res = sizeof(InlineTask) + (ops_ != nullptr ? ops_->remote_size : 0);
+    return res;
+  }
+
+  /// The stored callable if it's an `F`, `nullptr` otherwise. Lets a wrapped
+  /// callable be handed back without another allocation.
+  template <typename F>
+  F* target() noexcept {
+    if constexpr (std::is_invocable_r_v<void, F&&>) {
+      if (ops_ == &InlineOps<F>::kOps) {
+        return InlineOps<F>::Get(storage_);
+      }
+      if (ops_ == &RemoteOps<F>::kOps) {
+        return RemoteOps<F>::Get(storage_);
+      }
+    }
+    return nullptr;
+  }
+
+ private:
+  void Reset() noexcept {
+    if (ops_ != nullptr) {
+      std::exchange(ops_, nullptr)->destroy(storage_);
+    }
+  }
+
+ private:
+  alignas(std::max_align_t) std::byte storage_[kInlineSize];
+  const Ops* ops_ = nullptr;
+};
+
+}  // namespace handbag
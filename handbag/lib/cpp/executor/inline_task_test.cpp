@@ -0,0 +1,113 @@
+#include "lib/cpp/executor/inline_task.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <memory>
+#include <utility>
+
+#include "absl/functional/any_invocable.h"
+
+using namespace ::testing;
+
+namespace handbag::tests {
+namespace {
+
+using SmallTask = InlineTask<16>;
+
+/// Counts the instances alive, not counting moved from ones, and the calls.
+struct Tracked {
+  explicit Tracked(int* const alive, int* const calls)
+      : alive(alive), calls(calls) {
+    ++*alive;
+  }
+  Tracked(Tracked&& other) noexcept
+      : alive(std::exchange(other.alive, nullptr)), calls(other.calls) {}
+  ~Tracked() {
+    if (alive != nullptr) {
+      --*alive;
+    }
+  }
+
+  void operator()() && { ++*calls; }
+
+  int* alive;
+  int* calls;
+};
+
+TEST(InlineTaskTest, Inline) {
+  int alive = 0;
+  int calls = 0;
+  {
+    SmallTask task = Tracked(&alive, &calls);
+    EXPECT_TRUE(static_cast<bool>(task));
+    EXPECT_THAT(task.target<Tracked>(), NotNull());
+    EXPECT_THAT(task.target<int>(), IsNull());
+
+    auto moved = std::move(task);
+    EXPECT_FALSE(static_cast<bool>(task));  // NOLINT(bugprone-use-after-move)
+    EXPECT_THAT(alive, Eq(1));
+    std::move(moved)();
+  }
+
+  EXPECT_THAT(alive, Eq(0));
+  EXPECT_THAT(calls, Eq(1));
+}
+
+TEST(InlineTaskTest, Overflow) {
+  int alive = 0;
+  int calls = 0;
+  const auto check = [&](auto task) {
+    auto moved = std::move(task);
+    EXPECT_THAT(alive, Eq(1));
+    std::move(moved)();
+  };
+
+  // Doesn't fit 16 bytes.
+  const std::array<char, 64> padding = {};
+  check(SmallTask([tracked = Tracked(&alive, &calls), padding]() mutable {
+    (void)padding;
+    std::move(tracked)();
+  }));
+  check(InlineTask<16, ETaskOverflow::Heap>(
+      [tracked = Tracked(&alive, &calls), padding]() mutable {
+        (void)padding;
+        std::move(tracked)();
+      }));
+  EXPECT_THAT(alive, Eq(0));
+  EXPECT_THAT(calls, Eq(2));
+}
+
+TEST(InlineTaskTest, Size) {
+  EXPECT_THAT(SmallTask().GetSize(), Eq(sizeof(SmallTask)));
+  EXPECT_THAT(SmallTask([] {}).GetSize(), Eq(sizeof(SmallTask)));
+
+  const std::array<char, 64> padding = {};
+  const auto large = [padding] { (void)padding; };
+  EXPECT_THAT(SmallTask(large).GetSize(),
+              Eq(sizeof(SmallTask) + sizeof(large)));
+}
+
+TEST(InlineTaskTest, MoveOnlyAndAssignment) {
+  int result = 0;
+  SmallTask task = [value = std::make_unique<int>(1), &result] {
+    result += *value;
+  };
+  SmallTask other = [&result] { result += 10; };
+  other = std::move(task);
+  std::move(other)();
+  EXPECT_THAT(result, Eq(1));
+}
+
+TEST(InlineTaskTest, UnwrapsAnyInvocable) {
+  int calls = 0;
+  SmallTask task = absl::AnyInvocable<void() &&>([&] { ++calls; });
+  auto* const inner = task.target<absl::AnyInvocable<void() &&>>();
+  ASSERT_THAT(inner, NotNull());
+  std::move(*inner)();
+  EXPECT_THAT(calls, Eq(1));
+}
+
+}  // namespace
+}  // namespace handbag::tests
@@ -2,50 +2,138 @@
 
 #include <exception>
 #include <functional>
-#include <future>
+#include <ranges>
 #include <tuple>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "absl/functional/any_invocable.h"
+#include "lib/cpp/executor/cancellation.h"
+#include "lib/cpp/executor/future.h"
 
 namespace handbag::internal_executor {
 
 template <typename Invocable, typename... Args>
-std::pair<std::future<std::invoke_result_t<std::decay_t<Invocable>,
-                                           std::decay_t<Args>...>>,
-          absl::AnyInvocable<void() &&>>
-CreateTask(Invocable&& invocable, Args&&... args) {
-  using Result =
-      std::invoke_result_t<std::decay_t<Invocable>, std::decay_t<Args>...>;
-
-  std::promise<Result> promise;
-  auto future = promise.get_future();
-  auto res = std::make_pair<std::future<Result>, absl::AnyInvocable<void() &&>>(
+using TaskResult =
+    std::invoke_result_t<std::decay_t<Invocable>, std::decay_t<Args>...>;
+
+/// Marks the calling thread as running tasks of `executor` for the lifetime
+/// of the scope, see `IsCurrentThreadIn`. Scopes nest, e.g. a strand drains
+/// inside a worker of its target.
+class ScopedCurrentExecutor {
+ public:
+  explicit ScopedCurrentExecutor(const IExecutor* executor) noexcept;
+  ScopedCurrentExecutor(const ScopedCurrentExecutor&) = delete;
+  ScopedCurrentExecutor& operator=(const ScopedCurrentExecutor&) = delete;
+  ~ScopedCurrentExecutor();
+
+  /// Innermost scope of the calling thread, `nullptr` if there is none.
+  static const ScopedCurrentExecutor* Current() noexcept;
+
+  const IExecutor* executor() const noexcept { return executor_; }
+
+  const ScopedCurrentExecutor* outer() const noexcept { return outer_; }
+
+ private:
+  const IExecutor* executor_;
+  const ScopedCurrentExecutor* outer_;
+};
+
+/// Fails its future with `TaskCancelledError` if the task owning it gets
+/// dropped without being run, instead of breaking the promise.
+template <typename T>
+class CancelOnDropPromise {
+ public:
+  explicit CancelOnDropPromise(Promise<T>&& promise) noexcept
+      : promise_(std::move(promise)) {}
+  CancelOnDropPromise(CancelOnDropPromise&&) noexcept = default;
+  CancelOnDropPromise& operator=(CancelOnDropPromise&&) noexcept = default;
+  ~CancelOnDropPromise() {
+    if (promise_.IsValid()) {
+      promise_.SetException(std::make_exception_ptr(TaskCancelledError()));
+    }
+  }
+
+  Promise<T>& get() noexcept { return promise_; }
+
+ private:
+  Promise<T> promise_;
+};
+
+/// `Closure` is the callable type the task is wrapped into.
+template <typename Closure = absl::AnyInvocable<void() &&>,
+          typename Invocable, typename... Args>
+std::pair<Future<TaskResult<Invocable, Args...>>, Closure> CreateTask(
+    Invocable&& invocable, Args&&... args) {
+  using Result = TaskResult<Invocable, Args...>;
+
+  Promise<Result> promise;
+  auto future = promise.GetFuture();
+  auto res = std::make_pair<Future<Result>, Closure>(
       std::move(future),
-      [closure = std::make_tuple(std::move(promise),
+      [closure = std::make_tuple(CancelOnDropPromise(std::move(promise)),
                                  std::forward<Invocable>(invocable),
                                  std::forward<Args>(args)...)]() mutable {
         std::apply(
-            [](std::promise<Result>&& promise, Invocable&& invocable,
-               Args&&... args) {
-              try {
-                if constexpr (std::is_same_v<Result, void>) {
-                  std::invoke(std::forward<Invocable>(invocable),
-                              std::forward<Args>(args)...);
-                  promise.set_value();
-                } else {
-                  auto res = std::invoke(std::forward<Invocable>(invocable),
-                                         std::forward<Args>(args)...);
-                  promise.set_value(std::move(res));
-                }
-              } catch (...) {
-                auto eptr = std::current_exception();
-                promise.set_exception(std::move(eptr));
-              }
+            [](CancelOnDropPromise<Result>& promise,
+               std::decay_t<Invocable>& invocable,
+               std::decay_t<Args>&... args) {
+              Fulfill(promise.get(), [&]() -> Result {
+                return std::invoke(std::move(invocable), std::move(args)...);
+              });
             },
-            std::move(closure));
+            closure);
       });
   return res;
 }
 
+/// Same as `CreateTask` but without a way to observe the result.
+template <typename Closure = absl::AnyInvocable<void() &&>,
+          typename Invocable, typename... Args>
+Closure CreateDetachedTask(Invocable&& invocable, Args&&... args) {
+  Closure res =
+      [closure = std::make_tuple(std::forward<Invocable>(invocable),
+                                 std::forward<Args>(args)...)]() mutable {
+        std::apply(
+            [](std::decay_t<Invocable>& invocable,
+               std::decay_t<Args>&... args) {
+              std::invoke(std::move(invocable), std::move(args)...);
+            },
+            closure);
+      };
+  return res;
+}
+
+template <typename Range>
+using BatchResult =
+    TaskResult<std::decay_t<std::ranges::range_reference_t<Range>>>;
+
+template <typename Closure = absl::AnyInvocable<void() &&>, typename Range>
+std::pair<std::vector<Future<BatchResult<Range>>>, std::vector<Closure>>
+CreateTasks(Range&& invocables) {
+  std::vector<Future<BatchResult<Range>>> futures;
+  std::vector<Closure> closures;
+  if constexpr (std::ranges::sized_range<Range>) {
+    futures.reserve(std::ranges::size(invocables));
+    closures.reserve(std::ranges::size(invocables));
+  }
+
+  for (auto&& invocable : invocables) {
+    // Elements of an rvalue range are moved from, of an lvalue range copied.
+    auto [future, closure] = [&] {
+      if constexpr (std::is_lvalue_reference_v<Range>) {
+        return CreateTask<Closure>(invocable);
+      } else {
+        return CreateTask<Closure>(std::move(invocable));
+      }
+    }();
+    futures.push_back(std::move(future));
+    closures.push_back(std::move(closure));
+  }
+
+  auto res = std::make_pair(std::move(futures), std::move(closures));
+  return res;
+}
+
 }  // namespace handbag::internal_executor
@@ -0,0 +1,199 @@
+#include "lib/cpp/executor/internal/frame_pool.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace handbag::internal_executor {
+
+namespace {
+constexpr size_t kGranularity = 64;
+constexpr size_t kClassCount = 16;
+// Bounds the memory a thread can hoard after a burst of coroutines.
+constexpr size_t kMaxCachedPerClass = 256;
+
+class RemoteFrees;
+
+/// Precedes every pooled block, keeps the payload aligned as `operator new`
+/// would.
+struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) BlockHeader {
+  // Of the thread that allocated the block from malloc, it always returns
+  // there.
+  RemoteFrees* owner = nullptr;
+  // Next block in a list of `RemoteFrees`.
+  BlockHeader* next = nullptr;
+};
+
+// Marks the lists of a thread that exited.
+BlockHeader orphaned;
+
+size_t ClassOf(const size_t size) noexcept {
+  auto res = (size + sizeof(BlockHeader) + kGranularity - 1) / kGranularity;
+  return res;
+}
+
+/// Blocks freed by other threads, one lock-free stack per size class, taken
+/// over whole by the owning thread. Outlives the owning thread until all of
+/// its blocks came back.
+class RemoteFrees {
+ public:
+  void Push(BlockHeader* const block, const size_t size_class) noexcept {
+    auto& head = heads_[size_class - 1];
+    auto* top = head.load(std::memory_order_relaxed);
+    do {
+      if (top == &orphaned) {
+        ::operator delete(block);
+        Unref(1);
+        return;
+      }
+
+      block->next = top;
+    } while (!head.compare_exchange_weak(top, block, std::memory_order_release,
+                                         std::memory_order_relaxed));
+  }
+
+  /// Owner only.
+  BlockHeader* TakeAll(const size_t size_class) noexcept {
+    auto& head = heads_[size_class - 1];
+    if (head.load(std::memory_order_relaxed) == nullptr) {
+      return nullptr;
+    }
+
+    auto* const res = head.exchange(nullptr, std::memory_order_acquire);
+    return res;
+  }
+
+  /// Owner only, on exit. Blocks pushed later are freed by whoever pushes
+  /// them.
+  BlockHeader* Orphan(const size_t size_class) noexcept {
+    auto* const res =
+        heads_[size_class - 1].exchange(&orphaned, std::memory_order_acquire);
+    return res;
+  }
+
+  /// Counts `count` blocks of an exited owner as freed. The owner adds the
+  /// blocks it still has out with a negative `count` when it exits, blocks
+  /// freed meanwhile may get here first. Whoever brings the count to zero
+  /// deletes the lists.
+  void Unref(const int64_t count) noexcept {
+    if (refs_.fetch_sub(count, std::memory_order_acq_rel) == count) {
+      delete this;
+    }
+  }
+
+ private:
+  std::array<std::atomic<BlockHeader*>, kClassCount> heads_{};
+  // Blocks of the exited owner still in use elsewhere.
+  std::atomic<int64_t> refs_ = 0;
+};
+
+class FrameCache {
+ public:
+  FrameCache() : remote_(new RemoteFrees()) {}
+  FrameCache(const FrameCache&) = delete;
+  FrameCache& operator=(const FrameCache&) = delete;
+
+  ~FrameCache() {
+    for (size_t size_class = 1; size_class <= kClassCount; ++size_class) {
+      for (auto* block = remote_->Orphan(size_class); block != nullptr;) {
+        auto* const next = block->next;
+        ::operator delete(block);
+        --outstanding_;
+        block = next;
+      }
+    }
+    for (auto& blocks : free_) {
+      for (auto* const block : blocks) {
+        ::operator delete(block);
+      }
+    }
+
+    remote_->Unref(-static_cast<int64_t>(outstanding_));
+  }
+
+  void* Allocate(const size_t size_class) {
+    auto& blocks = free_[size_class - 1];
+    if (blocks.empty()) {
+      TakeBackRemote(size_class);
+    }
+
+    BlockHeader* block = nullptr;
+    if (blocks.empty()) {
+      block = ::new (::operator new(size_class * kGranularity)) BlockHeader();
+      block->owner = remote_;
+    } else {
+      block = blocks.back();
+      blocks.pop_back();
+    }
+
+    ++outstanding_;
+    return block + 1;
+  }
+
+  void Deallocate(void* const ptr, const size_t size_class) noexcept {
+    auto* const block = static_cast<BlockHeader*>(ptr) - 1;
+    if (block->owner != remote_) {
+      block->owner->Push(block, size_class);
+      return;
+    }
+
+    --outstanding_;
+    Recycle(block, size_class);
+  }
+
+ private:
+  void TakeBackRemote(const size_t size_class) noexcept {
+    for (auto* block = remote_->TakeAll(size_class); block != nullptr;) {
+      auto* const next = block->next;
+      --outstanding_;
+      Recycle(block, size_class);
+      block = next;
+    }
+  }
+
+  void Recycle(BlockHeader* const block, const size_t size_class) noexcept {
+    auto& blocks = free_[size_class - 1];
+    if (blocks.size() < kMaxCachedPerClass) {
+      try {
+        blocks.push_back(block);
+        return;
+      } catch (const std::bad_alloc&) {
+      }
+    }
+
+    ::operator delete(block);
+  }
+
+ private:
+  std::array<std::vector<BlockHeader*>, kClassCount> free_;
+  RemoteFrees* const remote_;
+  // Blocks of this thread in use, here or elsewhere.
+  size_t outstanding_ = 0;
+};
+
+thread_local FrameCache cache;
+}  // namespace
+
+void* AllocateFrame(const size_t size) {
+  const auto size_class = ClassOf(size);
+  if (size_class > kClassCount) {
+    return ::operator new(size);
+  }
+
+  auto* const res = cache.Allocate(size_class);
+  return res;
+}
+
+void DeallocateFrame(void* const ptr, const size_t size) noexcept {
+  const auto size_class = ClassOf(size);
+  if (size_class > kClassCount) {
+    ::operator delete(ptr);
+    return;
+  }
+
+  cache.Deallocate(ptr, size_class);
+}
+
+}  // namespace handbag::internal_executor
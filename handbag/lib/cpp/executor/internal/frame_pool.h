@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+
+namespace handbag::internal_executor {
+
+/// Allocator for coroutine frames and for task closures too large to be
+/// stored inline. Small blocks are recycled through per-thread free lists
+/// bucketed by size, so a coroutine started and finished over and over on
+/// one thread doesn't go to malloc. A block always returns to the thread
+/// that allocated it: one freed on another thread is pushed to a lock-free
+/// list of its owner, which takes the list over once its own runs empty. A
+/// producer handing tasks to workers thus reuses the blocks they ran in.
+void* AllocateFrame(size_t size);
+
+void DeallocateFrame(void* ptr, size_t size) noexcept;
+
+}  // namespace handbag::internal_executor
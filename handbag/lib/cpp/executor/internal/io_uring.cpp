@@ -0,0 +1,123 @@
+#include "lib/cpp/executor/internal/io_uring.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace handbag::internal_executor {
+
+namespace {
+void* Map(const int fd, const size_t size, const off_t offset) noexcept {
+  auto* const res = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, fd, offset);
+  return res == MAP_FAILED ? nullptr : res;
+}
+
+template <typename T>
+T* At(void* const base, const uint32_t offset) noexcept {
+  auto* const res =
+      reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+  return res;
+}
+}  // namespace
+
+IoUring::~IoUring() {
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+bool IoUring::Init(const uint32_t entries) noexcept {
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+  if (fd_ < 0) {
+    return false;
+  }
+
+  constexpr uint32_t kRequired = IORING_FEAT_NODROP | IORING_FEAT_RW_CUR_POS;
+  if ((params.features & kRequired) != kRequired) {
+    errno = ENOSYS;
+    return false;
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  cq_ring_size_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+
+  sq_ring_ = Map(fd_, sq_ring_size_, IORING_OFF_SQ_RING);
+  if (sq_ring_ == nullptr) {
+    return false;
+  }
+  cq_ring_ =
+      single_mmap ? sq_ring_ : Map(fd_, cq_ring_size_, IORING_OFF_CQ_RING);
+  if (cq_ring_ == nullptr) {
+    return false;
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  sqes_ = static_cast<io_uring_sqe*>(Map(fd_, sqes_size_, IORING_OFF_SQES));
+  if (sqes_ == nullptr) {
+    return false;
+  }
+
+  sq_head_ = At<uint32_t>(sq_ring_, params.sq_off.head);
+  sq_tail_ = At<uint32_t>(sq_ring_, params.sq_off.tail);
+  sq_mask_ = *At<uint32_t>(sq_ring_, params.sq_off.ring_mask);
+  sq_entries_ = params.sq_entries;
+  sqe_tail_ = *sq_tail_;
+  // Entries are used in ring order, so the indirection array is the identity.
+  auto* const array = At<uint32_t>(sq_ring_, params.sq_off.array);
+  for (uint32_t i = 0; i < sq_entries_; ++i) {
+    array[i] = i;
+  }
+
+  cq_head_ = At<uint32_t>(cq_ring_, params.cq_off.head);
+  cq_tail_ = At<uint32_t>(cq_ring_, params.cq_off.tail);
+  cq_mask_ = *At<uint32_t>(cq_ring_, params.cq_off.ring_mask);
+  cqes_ = At<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+
+  return true;
+}
+
+io_uring_sqe* IoUring::GetSqe() noexcept {
+  if (sqe_tail_ - LoadAcquire(sq_head_) >= sq_entries_) {
+    return nullptr;
+  }
+
+  auto* const res = &sqes_[sqe_tail_ & sq_mask_];
+  ++sqe_tail_;
+  std::memset(res, 0, sizeof(*res));
+  return res;
+}
+
+int IoUring::Enter(const bool wait) noexcept {
+  const auto to_submit = sqe_tail_ - LoadAcquire(sq_head_);
+  StoreRelease(sq_tail_, sqe_tail_);
+  if (to_submit == 0 && !wait) {
+    return 0;
+  }
+
+  const auto res = static_cast<int>(
+      syscall(__NR_io_uring_enter, fd_, to_submit, wait ? 1 : 0,
+              wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0));
+  return res < 0 ? -errno : res;
+}
+
+}  // namespace handbag::internal_executor
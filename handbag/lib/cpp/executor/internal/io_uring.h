@@ -0,0 +1,87 @@
+#pragma once
+
+#include <linux/io_uring.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace handbag::internal_executor {
+
+/// Bare io_uring on top of the raw syscalls, liburing is not needed: the
+/// submission and completion rings are mapped into the process and driven by
+/// a single thread.
+class IoUring {
+ public:
+  IoUring() = default;
+  IoUring(const IoUring&) = delete;
+  IoUring& operator=(const IoUring&) = delete;
+  ~IoUring();
+
+  /// Returns `false` and sets `errno` if the kernel has no usable io_uring;
+  /// reads and writes at the current file position need Linux 5.6.
+  bool Init(uint32_t entries) noexcept;
+
+  /// Returns `nullptr` if the submission ring is full, `Enter` makes room.
+  /// The entry is zeroed.
+  io_uring_sqe* GetSqe() noexcept;
+
+  /// Hands the prepared entries over to the kernel and, if `wait` is set,
+  /// blocks until there is at least one completion. Returns `-errno` on
+  /// failure.
+  int Enter(bool wait) noexcept;
+
+  /// Consumes the available completions, returns their number.
+  template <typename Invocable>
+  size_t ForEachCqe(Invocable&& invocable);
+
+ private:
+  uint32_t LoadAcquire(const uint32_t* ptr) const noexcept {
+    auto res = __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+    return res;
+  }
+
+  void StoreRelease(uint32_t* const ptr, const uint32_t value) noexcept {
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+  }
+
+ private:
+  int fd_ = -1;
+
+  void* sq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  void* cq_ring_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  io_uring_sqe* sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+
+  uint32_t* sq_head_ = nullptr;
+  uint32_t* sq_tail_ = nullptr;
+  uint32_t sq_mask_ = 0;
+  uint32_t sq_entries_ = 0;
+  // Tail of the entries handed out by `GetSqe`, published by `Enter`.
+  uint32_t sqe_tail_ = 0;
+
+  uint32_t* cq_head_ = nullptr;
+  uint32_t* cq_tail_ = nullptr;
+  uint32_t cq_mask_ = 0;
+  io_uring_cqe* cqes_ = nullptr;
+};
+
+/// Impl
+
+template <typename Invocable>
+size_t IoUring::ForEachCqe(Invocable&& invocable) {
+  auto head = *cq_head_;
+  const auto tail = LoadAcquire(cq_tail_);
+  const auto res = static_cast<size_t>(tail - head);
+  for (; head != tail; ++head) {
+    const auto cqe = cqes_[head & cq_mask_];
+    // Released before the callback, which may submit and wait again.
+    StoreRelease(cq_head_, head + 1);
+    invocable(cqe);
+  }
+
+  return res;
+}
+
+}  // namespace handbag::internal_executor
@@ -0,0 +1 @@
+#include "lib/cpp/executor/internal/mpmc_queue.h"
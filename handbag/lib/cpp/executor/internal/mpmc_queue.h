@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "absl/base/optimization.h"
+
+namespace handbag::internal_executor {
+
+/// Bounded lock-free multi-producer multi-consumer FIFO.
+///
+/// Every slot carries a "turn" counter: producers wait for an even turn and
+/// consumers for an odd one, so unlike power-of-two ring buffers any capacity
+/// (including 1) is exact. Slots are cache-line aligned to keep producers and
+/// consumers working on neighbouring slots from false sharing.
+template <typename T>
+class BoundedMpmcQueue {
+  static_assert(std::is_nothrow_move_constructible_v<T>);
+
+  struct alignas(ABSL_CACHELINE_SIZE) Slot {
+    std::atomic<size_t> turn = 0;
+    alignas(T) std::byte storage[sizeof(T)];
+
+    T* get() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+  };
+
+ public:
+  explicit BoundedMpmcQueue(const size_t capacity)
+      : capacity_(capacity), slots_(std::make_unique<Slot[]>(capacity)) {}
+
+  BoundedMpmcQueue(const BoundedMpmcQueue&) = delete;
+  BoundedMpmcQueue& operator=(const BoundedMpmcQueue&) = delete;
+  BoundedMpmcQueue(BoundedMpmcQueue&&) = delete;
+  BoundedMpmcQueue& operator=(BoundedMpmcQueue&&) = delete;
+
+  ~BoundedMpmcQueue() {
+    for (size_t i = 0; i < capacity_; ++i) {
+      if (slots_[i].turn.load(std::memory_order_relaxed) % 2 == 1) {
+        std::destroy_at(slots_[i].get());
+      }
+    }
+  }
+
+  /// `value` is moved from only if the push succeeds.
+  bool TryPush(T&& value) noexcept {
+    auto head = head_.load(std::memory_order_acquire);
+    for (;;) {
+      auto& slot = slots_[head % capacity_];
+      if (slot.turn.load(std::memory_order_acquire) == 2 * Turn(head)) {
+        if (head_.compare_exchange_strong(head, head + 1)) {
+          ::new (slot.storage) T(std::move(value));
+          slot.turn.store(2 * Turn(head) + 1, std::memory_order_release);
+          return true;
+        }
+      } else {
+        const auto prev_head = head;
+        head = head_.load(std::memory_order_acquire);
+        if (head == prev_head) {
+          return false;
+        }
+      }
+    }
+  }
+
+  bool TryPop(T& value) noexcept {
+    auto tail = tail_.load(std::memory_order_acquire);
+    for (;;) {
+      auto& slot = slots_[tail % capacity_];
+      if (slot.turn.load(std::memory_order_acquire) == 2 * Turn(tail) + 1) {
+        if (tail_.compare_exchange_strong(tail, tail + 1)) {
+          value = std::move(*slot.get());
+          std::destroy_at(slot.get());
+          slot.turn.store(2 * Turn(tail) + 2, std::memory_order_release);
+          return true;
+        }
+      } else {
+        const auto prev_tail = tail;
+        tail = tail_.load(std::memory_order_acquire);
+        if (tail == prev_tail) {
+          return false;
+        }
+      }
+    }
+  }
+
+  /// Approximate: a push or a pop may be in flight.
+  bool IsEmpty() const noexcept {
+    auto res = head_.load() == tail_.load();
+    return res;
+  }
+
+  /// Approximate, same as `IsEmpty`.
+  bool IsFull() const noexcept {
+    // Tail first: it never overtakes the head read after it.
+    const auto tail = tail_.load();
+    auto res = head_.load() - tail >= capacity_;
+    return res;
+  }
+
+  size_t capacity() const noexcept { return capacity_; }
+
+ private:
+  size_t Turn(const size_t position) const noexcept {
+    auto res = position / capacity_;
+    return res;
+  }
+
+ private:
+  const size_t capacity_;
+  const std::unique_ptr<Slot[]> slots_;
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<size_t> head_ = 0;
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<size_t> tail_ = 0;
+};
+
+}  // namespace handbag::internal_executor
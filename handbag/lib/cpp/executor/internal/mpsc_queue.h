@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+#include "absl/base/optimization.h"
+
+namespace handbag::internal_executor {
+
+/// Unbounded lock-free multi-producer single-consumer FIFO (Vyukov's).
+///
+/// A push is a single exchange plus a store and never waits for other
+/// producers. A producer preempted between the two leaves the queue looking
+/// empty from its node on, until it finishes the push, so `TryPop` may fail
+/// even though a push has already begun.
+template <typename T>
+class MpscQueue {
+  struct Node {
+    std::atomic<Node*> next = nullptr;
+    T value;
+  };
+
+ public:
+  MpscQueue() : head_(new Node()), tail_(head_.load()) {}
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+  MpscQueue(MpscQueue&&) = delete;
+  MpscQueue& operator=(MpscQueue&&) = delete;
+
+  ~MpscQueue() {
+    for (auto* node = tail_; node != nullptr;) {
+      delete std::exchange(node, node->next.load(std::memory_order_relaxed));
+    }
+  }
+
+  void Push(T value) {
+    auto* const node = new Node{.value = std::move(value)};
+    auto* const prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  /// Must only be called by one thread at a time.
+  bool TryPop(T& value) noexcept {
+    auto* const next = tail_->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      return false;
+    }
+
+    // `next` becomes the new stub, its value has been handed out.
+    value = std::move(next->value);
+    delete std::exchange(tail_, next);
+    return true;
+  }
+
+ private:
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<Node*> head_;
+  alignas(ABSL_CACHELINE_SIZE) Node* tail_;
+};
+
+}  // namespace handbag::internal_executor
@@ -0,0 +1,78 @@
+#include "lib/cpp/executor/internal/parking.h"
+
+#include "absl/time/clock.h"
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace handbag::internal_executor {
+
+bool Parker::Park(const absl::Duration timeout) noexcept {
+  // kNotified -> kEmpty consumes a pending unpark, kEmpty -> kParked parks.
+  if (state_.fetch_sub(1, std::memory_order_acquire) == kNotified) {
+    return true;
+  }
+
+  const auto deadline = absl::Now() + timeout;
+  for (;;) {
+    Wait(deadline);
+
+    auto expected = kNotified;
+    if (state_.compare_exchange_strong(expected, kEmpty,
+                                       std::memory_order_acquire)) {
+      return true;
+    }
+
+    if (absl::Now() >= deadline) {
+      auto res = state_.exchange(kEmpty, std::memory_order_acquire) ==
+                 kNotified;
+      return res;
+    }
+  }
+}
+
+void Parker::Unpark() noexcept {
+  if (state_.exchange(kNotified, std::memory_order_release) == kParked) {
+    Wake();
+  }
+}
+
+#if defined(__linux__)
+static_assert(sizeof(std::atomic<int32_t>) == sizeof(int32_t));
+
+void Parker::Wait(const absl::Time deadline) noexcept {
+  timespec timeout;
+  timespec* timeout_ptr = nullptr;
+  if (deadline != absl::InfiniteFuture()) {
+    timeout = absl::ToTimespec(
+        std::max(deadline - absl::Now(), absl::ZeroDuration()));
+    timeout_ptr = &timeout;
+  }
+
+  (void)syscall(SYS_futex, reinterpret_cast<int32_t*>(&state_),
+                FUTEX_WAIT_PRIVATE, kParked, timeout_ptr, nullptr, 0);
+}
+
+void Parker::Wake() noexcept {
+  (void)syscall(SYS_futex, reinterpret_cast<int32_t*>(&state_),
+                FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+}
+#else
+void Parker::Wait(const absl::Time deadline) noexcept {
+  const absl::MutexLock lock(&mutex_);
+  if (state_.load(std::memory_order_relaxed) == kParked) {
+    cond_var_.WaitWithDeadline(&mutex_, deadline);
+  }
+}
+
+void Parker::Wake() noexcept {
+  const absl::MutexLock lock(&mutex_);
+  cond_var_.Signal();
+}
+#endif
+
+}  // namespace handbag::internal_executor
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace handbag::internal_executor {
+
+/// Hints the CPU that the caller is busy-waiting.
+inline void CpuRelax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+/// Parks a single thread until somebody unparks it, futex-based on Linux.
+///
+/// Works like a binary semaphore: an `Unpark` that comes before `Park` makes
+/// the next `Park` return right away, so unparking never gets lost.
+class Parker {
+ public:
+  /// Returns `false` if `timeout` expired without an `Unpark`.
+  bool Park(absl::Duration timeout) noexcept;
+
+  void Unpark() noexcept;
+
+ private:
+  static constexpr int32_t kParked = -1;
+  static constexpr int32_t kEmpty = 0;
+  static constexpr int32_t kNotified = 1;
+
+  /// Blocks while the state is `kParked`, may return spuriously.
+  void Wait(absl::Time deadline) noexcept;
+  void Wake() noexcept;
+
+ private:
+  std::atomic<int32_t> state_ = kEmpty;
+#if !defined(__linux__)
+  absl::Mutex mutex_;
+  absl::CondVar cond_var_;
+#endif
+};
+
+}  // namespace handbag::internal_executor
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "absl/base/optimization.h"
+
+namespace handbag::internal_executor {
+
+/// Bounded lock-free single-producer single-consumer FIFO, the capacity is
+/// rounded up to a power of two.
+///
+/// Each side keeps a cached copy of the other side's index and only reloads it
+/// when the queue looks full (or empty), so in the steady state a push or a
+/// pop touches no cache line the other side writes.
+template <typename T>
+class SpscQueue {
+  static_assert(std::is_nothrow_move_constructible_v<T>);
+
+  struct Slot {
+    alignas(T) std::byte storage[sizeof(T)];
+
+    T* get() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+  };
+
+ public:
+  explicit SpscQueue(const size_t capacity)
+      : mask_(std::bit_ceil(std::max<size_t>(capacity, 1)) - 1),
+        slots_(std::make_unique<Slot[]>(mask_ + 1)) {}
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+  SpscQueue(SpscQueue&&) = delete;
+  SpscQueue& operator=(SpscQueue&&) = delete;
+
+  ~SpscQueue() {
+    const auto head = head_.load(std::memory_order_relaxed);
+    for (auto i = tail_.load(std::memory_order_relaxed); i != head; ++i) {
+      std::destroy_at(slots_[i & mask_].get());
+    }
+  }
+
+  /// Producer only. `value` is moved from only if the push succeeds.
+  bool TryPush(T&& value) noexcept {
+    const auto head = head_.load(std::memory_order_relaxed);
+    if (head - cached_tail_ > mask_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head - cached_tail_ > mask_) {
+        return false;
+      }
+    }
+
+    ::new (slots_[head & mask_].storage) T(std::move(value));
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Consumer only.
+  bool TryPop(T& value) noexcept {
+    const auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail == cached_head_) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail == cached_head_) {
+        return false;
+      }
+    }
+
+    auto* const slot = slots_[tail & mask_].get();
+    value = std::move(*slot);
+    std::destroy_at(slot);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t capacity() const noexcept { return mask_ + 1; }
+
+ private:
+  const size_t mask_;
+  const std::unique_ptr<Slot[]> slots_;
+  // Written by the producer.
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<size_t> head_ = 0;
+  size_t cached_tail_ = 0;
+  // Written by the consumer.
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<size_t> tail_ = 0;
+  size_t cached_head_ = 0;
+};
+
+}  // namespace handbag::internal_executor
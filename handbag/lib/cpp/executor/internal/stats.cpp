@@ -0,0 +1,91 @@
+#include "lib/cpp/executor/internal/stats.h"
+
+#include <functional>
+#include <string>
+
+#include "absl/time/time.h"
+
+#if defined(__linux__)
+#include <time.h>
+#endif
+
+namespace handbag::internal_executor {
+
+uint64_t ThreadCpuNanos() noexcept {
+#if defined(__linux__)
+  timespec now{};
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) != 0) {
+    return 0;
+  }
+
+  auto res = static_cast<uint64_t>(now.tv_sec) * 1'000'000'000 +
+             static_cast<uint64_t>(now.tv_nsec);
+  return res;
+#else
+  return 0;
+#endif
+}
+
+OwnedLabelTable::Entry& OwnedLabelTable::Find(
+    const std::string_view label) noexcept {
+  // The last entry is for the overflow.
+  constexpr size_t kSlotCount = kCapacity - 1;
+  auto index = std::hash<const void*>()(label.data()) % kSlotCount;
+  for (size_t i = 0; i < kSlotCount; ++i, index = (index + 1) % kSlotCount) {
+    auto& entry = entries_[index];
+    const auto* const data = entry.data.load(std::memory_order_relaxed);
+    if (data == nullptr) {
+      entry.size.store(label.size(), std::memory_order_relaxed);
+      entry.data.store(label.data(), std::memory_order_release);
+      return entry;
+    }
+    if (data == label.data() &&
+        entry.size.load(std::memory_order_relaxed) == label.size()) {
+      return entry;
+    }
+  }
+
+  auto& res = entries_[kSlotCount];
+  if (res.data.load(std::memory_order_relaxed) == nullptr) {
+    res.size.store(kOtherLabel.size(), std::memory_order_relaxed);
+    res.data.store(kOtherLabel.data(), std::memory_order_release);
+  }
+  return res;
+}
+
+void OwnedLabelTable::Add(const std::string_view label,
+                          const uint64_t wall_nanos,
+                          const uint64_t cpu_nanos) noexcept {
+  auto& entry = Find(label);
+  IncrementOwned(entry.count);
+  IncrementOwned(entry.wall_nanos, wall_nanos);
+  IncrementOwned(entry.cpu_nanos, cpu_nanos);
+}
+
+void OwnedLabelTable::CollectInto(
+    std::vector<executor::TaskLabelStats>& dst) const {
+  for (const auto& entry : entries_) {
+    const auto* const data = entry.data.load(std::memory_order_acquire);
+    if (data == nullptr) {
+      continue;
+    }
+
+    const std::string_view label(data,
+                                 entry.size.load(std::memory_order_relaxed));
+    auto it = dst.begin();
+    while (it != dst.end() && it->label != label) {
+      ++it;
+    }
+    if (it == dst.end()) {
+      it = dst.insert(it,
+                      executor::TaskLabelStats{.label = std::string(label)});
+    }
+    it->count += entry.count.load(std::memory_order_relaxed);
+    it->wall_time +=
+        absl::Nanoseconds(entry.wall_nanos.load(std::memory_order_relaxed));
+    it->cpu_time +=
+        absl::Nanoseconds(entry.cpu_nanos.load(std::memory_order_relaxed));
+  }
+}
+
+}  // namespace handbag::internal_executor
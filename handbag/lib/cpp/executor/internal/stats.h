@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "lib/cpp/executor/stats.h"
+
+namespace handbag::internal_executor {
+
+inline uint64_t NowNanos() noexcept {
+  const auto now = std::chrono::steady_clock::now().time_since_epoch();
+  auto res = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+  return res;
+}
+
+/// CPU time consumed by the calling thread, zero where there is no per-thread
+/// clock.
+uint64_t ThreadCpuNanos() noexcept;
+
+/// Increment for counters that have a single writer: avoids a locked
+/// read-modify-write, readers still see a consistent value.
+inline void IncrementOwned(std::atomic<uint64_t>& counter,
+                           const uint64_t delta = 1) noexcept {
+  counter.store(counter.load(std::memory_order_relaxed) + delta,
+                std::memory_order_relaxed);
+}
+
+/// Lock-free counterpart of `executor::DurationHistogram` for a single writer
+/// and any number of readers.
+class OwnedDurationHistogram {
+  using Histogram = executor::DurationHistogram;
+
+ public:
+  void Add(const uint64_t nanos) noexcept {
+    IncrementOwned(buckets_[Histogram::BucketIndex(nanos)]);
+    IncrementOwned(sum_nanos_, nanos);
+  }
+
+  void CollectInto(Histogram& dst) const noexcept {
+    std::array<uint64_t, Histogram::kBucketCount> buckets;
+    for (size_t i = 0; i < Histogram::kBucketCount; ++i) {
+      buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    }
+    dst.Merge(Histogram(buckets, sum_nanos_.load(std::memory_order_relaxed)));
+  }
+
+ private:
+  std::array<std::atomic<uint64_t>, Histogram::kBucketCount> buckets_ = {};
+  std::atomic<uint64_t> sum_nanos_ = 0;
+};
+
+/// Per-label task counters for a single writer and any number of readers.
+/// Labels are looked up by address in a fixed open-addressing table; past
+/// `kCapacity - 1` distinct addresses the tasks are counted under
+/// `kOtherLabel`.
+class OwnedLabelTable {
+ public:
+  static constexpr size_t kCapacity = 64;
+  static constexpr std::string_view kOtherLabel = "(other)";
+
+  void Add(std::string_view label, uint64_t wall_nanos,
+           uint64_t cpu_nanos) noexcept;
+
+  /// Adds the counters to the entries of `dst` with the same label text,
+  /// appends the missing ones.
+  void CollectInto(std::vector<executor::TaskLabelStats>& dst) const;
+
+ private:
+  struct Entry {
+    // Published last, with release: readers skip entries without it.
+    std::atomic<const char*> data = nullptr;
+    std::atomic<size_t> size = 0;
+    std::atomic<uint64_t> count = 0;
+    std::atomic<uint64_t> wall_nanos = 0;
+    std::atomic<uint64_t> cpu_nanos = 0;
+  };
+
+  Entry& Find(std::string_view label) noexcept;
+
+ private:
+  std::array<Entry, kCapacity> entries_;
+};
+
+}  // namespace handbag::internal_executor
@@ -0,0 +1,166 @@
+#include "lib/cpp/executor/internal/timing_wheel.h"
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+namespace handbag::internal_executor {
+
+namespace {
+constexpr size_t kBits = TimingWheel::kLevelBits;
+constexpr size_t kOverflow = TimingWheel::kLevelCount;
+
+size_t SlotOf(const uint64_t tick, const size_t level) noexcept {
+  if (level == kOverflow) {
+    return 0;
+  }
+
+  auto res = static_cast<size_t>((tick >> (kBits * level)) &
+                                 (TimingWheel::kSlotCount - 1));
+  return res;
+}
+
+/// Lowest level at which `expiry` and `now` share all higher digits.
+size_t LevelOf(const uint64_t expiry, const uint64_t now) noexcept {
+  const auto level =
+      static_cast<size_t>(std::bit_width(expiry ^ now) - 1) / kBits;
+  auto res = std::min(level, kOverflow);
+  return res;
+}
+
+/// Ticks covered by a single slot of `level`; a slot of the overflow list
+/// covers all the levels below it.
+uint64_t SlotSpan(const size_t level) noexcept {
+  auto res = uint64_t{1} << (kBits * level);
+  return res;
+}
+}  // namespace
+
+bool TimingWheel::Insert(TimingWheelNode* const node,
+                         const uint64_t expiry) noexcept {
+  if (expiry <= now_) {
+    return false;
+  }
+
+  node->expiry = expiry;
+  Link(node);
+  return true;
+}
+
+void TimingWheel::Remove(TimingWheelNode* const node) noexcept {
+  auto& level = levels_[node->level];
+  if (node->prev != nullptr) {
+    node->prev->next = node->next;
+  } else {
+    level.slots[node->slot] = node->next;
+    if (node->next == nullptr) {
+      level.occupied &= ~(uint64_t{1} << node->slot);
+    }
+  }
+  if (node->next != nullptr) {
+    node->next->prev = node->prev;
+  }
+
+  node->prev = nullptr;
+  node->next = nullptr;
+  node->linked = false;
+  --size_;
+}
+
+void TimingWheel::Advance(const uint64_t now,
+                          std::vector<TimingWheelNode*>& expired) {
+  while (now_ < now) {
+    const auto next = NextEvent();
+    if (!next || *next > now) {
+      now_ = now;
+      return;
+    }
+
+    now_ = *next;
+    // Higher levels go first, their nodes may land in the current slot of a
+    // lower one.
+    for (size_t level = kOverflow; level > 0; --level) {
+      const auto slot = SlotOf(now_, level);
+      if (now_ % SlotSpan(level) != 0 ||
+          (levels_[level].occupied & (uint64_t{1} << slot)) == 0) {
+        continue;
+      }
+
+      for (auto* node = TakeSlot(level, slot); node != nullptr;) {
+        auto* const next_node = std::exchange(node->next, nullptr);
+        if (node->expiry == now_) {
+          expired.push_back(node);
+        } else {
+          Link(node);
+        }
+        node = next_node;
+      }
+    }
+
+    for (auto* node = TakeSlot(0, SlotOf(now_, 0)); node != nullptr;) {
+      auto* const next_node = std::exchange(node->next, nullptr);
+      expired.push_back(node);
+      node = next_node;
+    }
+  }
+}
+
+std::optional<uint64_t> TimingWheel::NextEvent() const noexcept {
+  std::optional<uint64_t> res;
+  if (levels_[kOverflow].occupied != 0) {
+    res = (now_ / SlotSpan(kOverflow) + 1) * SlotSpan(kOverflow);
+  }
+
+  for (size_t level = 0; level < kLevelCount; ++level) {
+    // Nodes are always in a slot past the current digit of their level.
+    const auto digit = SlotOf(now_, level);
+    const auto ahead =
+        digit + 1 < kSlotCount
+            ? levels_[level].occupied & (~uint64_t{0} << (digit + 1))
+            : 0;
+    if (ahead == 0) {
+      continue;
+    }
+
+    const auto block = SlotSpan(level + 1);
+    const auto tick =
+        now_ / block * block +
+        static_cast<uint64_t>(std::countr_zero(ahead)) * SlotSpan(level);
+    if (!res || tick < *res) {
+      res = tick;
+    }
+  }
+
+  return res;
+}
+
+void TimingWheel::Link(TimingWheelNode* const node) noexcept {
+  const auto level = LevelOf(node->expiry, now_);
+  const auto slot = SlotOf(node->expiry, level);
+  auto& head = levels_[level].slots[slot];
+  node->prev = nullptr;
+  node->next = head;
+  if (head != nullptr) {
+    head->prev = node;
+  }
+  head = node;
+  node->level = static_cast<uint32_t>(level);
+  node->slot = static_cast<uint32_t>(slot);
+  node->linked = true;
+  levels_[level].occupied |= uint64_t{1} << slot;
+  ++size_;
+}
+
+TimingWheelNode* TimingWheel::TakeSlot(const size_t level,
+                                       const size_t slot) noexcept {
+  auto* const res = std::exchange(levels_[level].slots[slot], nullptr);
+  levels_[level].occupied &= ~(uint64_t{1} << slot);
+  for (auto* node = res; node != nullptr; node = node->next) {
+    node->prev = nullptr;
+    node->linked = false;
+    --size_;
+  }
+  return res;
+}
+
+}  // namespace handbag::internal_executor
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace handbag::internal_executor {
+
+/// Intrusive part of a timer kept in a `TimingWheel`.
+struct TimingWheelNode {
+  TimingWheelNode* prev = nullptr;
+  TimingWheelNode* next = nullptr;
+  uint64_t expiry = 0;
+  uint32_t level = 0;
+  uint32_t slot = 0;
+  bool linked = false;
+};
+
+/// Hierarchical timing wheel over abstract ticks.
+///
+/// Level `l` has 64 slots of 64^l ticks each. A node lands on the lowest level
+/// where its expiry shares all higher digits with the current tick, and moves
+/// one level down whenever the wheel reaches its slot, so inserting and
+/// removing are O(1) and every node is moved at most once per level. Nodes
+/// beyond the last level wait in an overflow list. Advancing skips empty
+/// slots using per-level occupancy bitmaps.
+class TimingWheel {
+ public:
+  static constexpr size_t kLevelBits = 6;
+  static constexpr size_t kSlotCount = size_t{1} << kLevelBits;
+  static constexpr size_t kLevelCount = 7;
+
+  explicit TimingWheel(uint64_t now) noexcept : now_(now) {}
+
+  TimingWheel(const TimingWheel&) = delete;
+  TimingWheel& operator=(const TimingWheel&) = delete;
+
+  uint64_t now() const noexcept { return now_; }
+  size_t size() const noexcept { return size_; }
+
+  /// Returns `false` and leaves `node` alone if `expiry` is not in the future.
+  bool Insert(TimingWheelNode* node, uint64_t expiry) noexcept;
+
+  void Remove(TimingWheelNode* node) noexcept;
+
+  /// Moves the wheel to `now`, appending the expired nodes to `expired`.
+  void Advance(uint64_t now, std::vector<TimingWheelNode*>& expired);
+
+  /// Earliest tick at which `Advance` may have something to do. May be earlier
+  /// than the nearest expiry, but never later.
+  std::optional<uint64_t> NextEvent() const noexcept;
+
+ private:
+  struct Level {
+    std::array<TimingWheelNode*, kSlotCount> slots = {};
+    uint64_t occupied = 0;
+  };
+
+  void Link(TimingWheelNode* node) noexcept;
+  TimingWheelNode* TakeSlot(size_t level, size_t slot) noexcept;
+
+ private:
+  uint64_t now_;
+  size_t size_ = 0;
+  // The last one is the overflow list, it only uses slot 0.
+  std::array<Level, kLevelCount + 1> levels_;
+};
+
+}  // namespace handbag::internal_executor
@@ -0,0 +1,153 @@
+#include "lib/cpp/executor/internal/topology.h"
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace handbag::internal_executor {
+
+namespace {
+std::optional<size_t> ParseNumber(const std::string_view text) {
+  size_t res = 0;
+  const auto [end, ec] =
+      std::from_chars(text.data(), text.data() + text.size(), res);
+  if (ec != std::errc() || end != text.data() + text.size()) {
+    return std::nullopt;
+  }
+
+  return res;
+}
+}  // namespace
+
+std::optional<std::vector<size_t>> ParseCpuList(std::string_view text) {
+  while (!text.empty() && (text.back() == '\n' || text.back() == ' ')) {
+    text.remove_suffix(1);
+  }
+
+  std::vector<size_t> res;
+  while (!text.empty()) {
+    const auto comma = text.find(',');
+    const auto range = text.substr(0, comma);
+    text = comma == std::string_view::npos ? std::string_view()
+                                           : text.substr(comma + 1);
+
+    const auto dash = range.find('-');
+    const auto first = ParseNumber(range.substr(0, dash));
+    const auto last = dash == std::string_view::npos
+                          ? first
+                          : ParseNumber(range.substr(dash + 1));
+    if (!first || !last || *first > *last) {
+      return std::nullopt;
+    }
+
+    for (auto cpu = *first; cpu <= *last; ++cpu) {
+      res.push_back(cpu);
+    }
+  }
+
+  return res;
+}
+
+std::vector<size_t> GetAvailableCpus() {
+  std::vector<size_t> res;
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) {
+        res.push_back(cpu);
+      }
+    }
+  }
+#endif
+
+  if (res.empty()) {
+    res.resize(std::max(std::thread::hardware_concurrency(), 1u));
+    for (size_t i = 0; i < res.size(); ++i) {
+      res[i] = i;
+    }
+  }
+
+  return res;
+}
+
+std::vector<NumaNode> GetNumaNodes() {
+  const auto available = GetAvailableCpus();
+
+  std::vector<NumaNode> res;
+  std::error_code ec;
+  for (const auto& entry : std::filesystem::directory_iterator(
+           "/sys/devices/system/node", ec)) {
+    const auto name = entry.path().filename().string();
+    const auto id = name.starts_with("node")
+                        ? ParseNumber(std::string_view(name).substr(4))
+                        : std::nullopt;
+    if (!id) {
+      continue;
+    }
+
+    std::ifstream in(entry.path() / "cpulist");
+    std::string line;
+    std::getline(in, line);
+    auto cpus = ParseCpuList(line);
+    if (!cpus) {
+      continue;
+    }
+
+    std::erase_if(*cpus, [&](const size_t cpu) {
+      return !std::binary_search(available.begin(), available.end(), cpu);
+    });
+    if (!cpus->empty()) {
+      res.push_back({.id = *id, .cpus = std::move(*cpus)});
+    }
+  }
+
+  if (res.empty()) {
+    res.push_back({.id = 0, .cpus = available});
+  }
+
+  std::sort(res.begin(), res.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs.id < rhs.id;
+  });
+  return res;
+}
+
+bool PinCurrentThread(const std::span<const size_t> cpus) noexcept {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (const auto cpu : cpus) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+
+  auto res = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+  return res;
+#else
+  (void)cpus;
+  return false;
+#endif
+}
+
+void SetCurrentThreadName(const std::string_view name) noexcept {
+#if defined(__linux__)
+  char buffer[16] = {};
+  name.copy(buffer, sizeof(buffer) - 1);
+  (void)pthread_setname_np(pthread_self(), buffer);
+#else
+  (void)name;
+#endif
+}
+
+}  // namespace handbag::internal_executor
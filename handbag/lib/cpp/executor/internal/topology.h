@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace handbag::internal_executor {
+
+/// Parses the kernel's CPU list format, e.g. "0-3,8,10-11".
+std::optional<std::vector<size_t>> ParseCpuList(std::string_view text);
+
+struct NumaNode {
+  size_t id = 0;
+  std::vector<size_t> cpus;
+};
+
+/// Nodes that have CPUs the process may run on, read from
+/// /sys/devices/system/node. Falls back to a single node when the topology is
+/// not available.
+std::vector<NumaNode> GetNumaNodes();
+
+/// CPUs the process may run on.
+std::vector<size_t> GetAvailableCpus();
+
+/// Restricts the calling thread to `cpus`, returns false on failure.
+bool PinCurrentThread(std::span<const size_t> cpus) noexcept;
+
+/// Truncated to what the OS allows (15 characters on Linux).
+void SetCurrentThreadName(std::string_view name) noexcept;
+
+}  // namespace handbag::internal_executor
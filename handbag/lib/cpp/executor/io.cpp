@@ -0,0 +1,865 @@
+#include "lib/cpp/executor/io.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/log/log.h"
+#include "absl/synchronization/mutex.h"
+#include "lib/cpp/executor/internal/io_uring.h"
+#include "lib/cpp/executor/internal/topology.h"
+#include "lib/cpp/repr/repr.h"
+#include "lib/cpp/start_stop/state.h"
+
+namespace handbag::executor {
+
+namespace {
+using Task = absl::AnyInvocable<void() &&>;
+
+constexpr size_t kDefaultThreadCount = 1;
+constexpr uint32_t kDefaultQueueDepth = 256;
+// Offset that makes reads and writes use the current file position.
+constexpr uint64_t kCurrentPosition = std::numeric_limits<uint64_t>::max();
+
+struct Params {
+  std::string name;
+  size_t thread_count = 0;
+  EIoBackend backend = EIoBackend::IoUring;
+  uint32_t queue_depth = 0;
+};
+
+const char* BackendName(const EIoBackend backend) noexcept {
+  switch (backend) {
+    case EIoBackend::IoUring:
+      return "io_uring";
+    case EIoBackend::Epoll:
+      return "epoll";
+  }
+
+  return "unknown";
+}
+
+enum class EIoOp {
+  Read,
+  Write,
+  Accept,
+};
+
+struct IoOperation {
+  EIoOp op = EIoOp::Read;
+  int fd = -1;
+  void* data = nullptr;
+  size_t size = 0;
+  uint64_t offset = kCurrentPosition;
+  // Called with the result of the syscall or `-errno`.
+  absl::AnyInvocable<void(int64_t) &&> complete;
+  // io_uring only: the operation would have blocked, it waits for the
+  // descriptor to become ready and is then submitted again.
+  bool polling = false;
+};
+
+using OperationPtr = std::unique_ptr<IoOperation>;
+
+void Complete(OperationPtr op, const int64_t result) noexcept {
+  std::move(op->complete)(result);
+}
+
+template <typename T>
+absl::AnyInvocable<void(int64_t) &&> Completion(Promise<T> promise,
+                                                 const char* const what) {
+  auto res = [promise = std::move(promise),
+              what](const int64_t result) mutable {
+    if (result < 0) {
+      promise.SetException(std::make_exception_ptr(std::system_error(
+          static_cast<int>(-result), std::generic_category(), what)));
+      return;
+    }
+
+    promise.SetValue(static_cast<T>(result));
+  };
+  return res;
+}
+
+/// Runs the operation right away, returns the result or `-errno`.
+int64_t Perform(const IoOperation& op) noexcept {
+  for (;;) {
+    ssize_t res = 0;
+    switch (op.op) {
+      case EIoOp::Read:
+        res = op.offset == kCurrentPosition
+                  ? read(op.fd, op.data, op.size)
+                  : pread(op.fd, op.data, op.size,
+                          static_cast<off_t>(op.offset));
+        break;
+      case EIoOp::Write:
+        res = op.offset == kCurrentPosition
+                  ? write(op.fd, op.data, op.size)
+                  : pwrite(op.fd, op.data, op.size,
+                           static_cast<off_t>(op.offset));
+        break;
+      case EIoOp::Accept:
+        res = accept4(op.fd, nullptr, nullptr, SOCK_CLOEXEC);
+        break;
+    }
+
+    if (res >= 0) {
+      return res;
+    }
+    if (errno != EINTR) {
+      return -errno;
+    }
+  }
+}
+
+void LogException(const IRepr& owner, std::exception_ptr eptr) noexcept {
+  std::string message;
+  try {
+    std::rethrow_exception(std::move(eptr));
+  } catch (const std::exception& exc) {
+    message = exc.what();
+  } catch (...) {
+  }
+
+  LOG(ERROR) << owner << "; what() = " << message;
+}
+
+class IoLoop;
+
+thread_local IoLoop* current_loop = nullptr;
+
+/// Event loop of a single thread. Tasks are posted from any thread and wake
+/// the loop through an eventfd; I/O operations are started by tasks, so all
+/// the backend state is only touched by the loop thread.
+class IoLoop {
+ public:
+  IoLoop(const IRepr& owner, const start_stop::StoppableState& state) noexcept
+      : owner_(owner), state_(state) {}
+  IoLoop(const IoLoop&) = delete;
+  IoLoop& operator=(const IoLoop&) = delete;
+  virtual ~IoLoop() {
+    if (wake_fd_ >= 0) {
+      close(wake_fd_);
+    }
+  }
+
+  bool IsOwnedBy(const IRepr& owner) const noexcept {
+    auto res = &owner_ == &owner;
+    return res;
+  }
+
+  void Post(Task task) noexcept {
+    bool was_empty = false;
+    {
+      const absl::MutexLock lock(&mutex_);
+      was_empty = tasks_.empty();
+      tasks_.push_back(std::move(task));
+    }
+
+    // The loop itself drains the tasks before it waits again.
+    if (was_empty && current_loop != this) {
+      Wake();
+    }
+  }
+
+  void Wake() noexcept {
+    const uint64_t one = 1;
+    [[maybe_unused]] const auto written = write(wake_fd_, &one, sizeof(one));
+  }
+
+  /// Returns once the executor is stopping and all the operations are over.
+  void Run() noexcept {
+    current_loop = this;
+    while (state_.IsNotStoppingOrStopped()) {
+      RunTasks();
+      Poll(!HasTasks());
+    }
+
+    Shutdown();
+    // Operations started here fail right away.
+    RunTasks();
+    current_loop = nullptr;
+  }
+
+  void Start(OperationPtr op) noexcept {
+    if (state_.IsStoppingOrStopped()) {
+      Complete(std::move(op), -ECANCELED);
+      return;
+    }
+
+    StartOperation(std::move(op));
+  }
+
+ protected:
+  bool InitWake(const int flags) noexcept {
+    wake_fd_ = eventfd(0, EFD_CLOEXEC | flags);
+    auto res = wake_fd_ >= 0;
+    return res;
+  }
+
+  bool IsStopping() const noexcept {
+    auto res = state_.IsStoppingOrStopped();
+    return res;
+  }
+
+  virtual void StartOperation(OperationPtr op) noexcept = 0;
+
+  /// Handles the ready events, blocks until there are some if `wait` is set.
+  virtual void Poll(bool wait) noexcept = 0;
+
+  /// Fails the pending operations, returns once the kernel has let go of
+  /// their buffers.
+  virtual void Shutdown() noexcept = 0;
+
+ protected:
+  const IRepr& owner_;
+  int wake_fd_ = -1;
+
+ private:
+  bool HasTasks() noexcept {
+    const absl::MutexLock lock(&mutex_);
+    auto res = !tasks_.empty();
+    return res;
+  }
+
+  void RunTasks() noexcept {
+    std::vector<Task> tasks;
+    {
+      const absl::MutexLock lock(&mutex_);
+      tasks.swap(tasks_);
+    }
+
+    for (auto& task : tasks) {
+      try {
+        std::move(task)();
+      } catch (...) {
+        LogException(owner_, std::current_exception());
+      }
+    }
+  }
+
+ private:
+  const start_stop::StoppableState& state_;
+  absl::Mutex mutex_;
+  std::vector<Task> tasks_ ABSL_GUARDED_BY(mutex_);
+};
+
+class UringLoop final : public IoLoop {
+  // `user_data` of the completions that are not operations.
+  static constexpr uint64_t kWakeTag = 0;
+  static constexpr uint64_t kCancelTag = 1;
+
+ public:
+  using IoLoop::IoLoop;
+
+  bool Init(const uint32_t queue_depth) noexcept {
+    // A non-blocking eventfd would make the read complete with `EAGAIN`.
+    if (!ring_.Init(queue_depth) || !InitWake(0)) {
+      return false;
+    }
+
+    ArmWake();
+    return true;
+  }
+
+ protected:
+  void StartOperation(OperationPtr op) noexcept override {
+    Submit(op.release());
+  }
+
+  void Poll(const bool wait) noexcept override {
+    const auto res = ring_.Enter(wait);
+    if (res < 0 && res != -EINTR && res != -EBUSY && res != -EAGAIN) {
+      LOG(ERROR) << owner_ << "; io_uring_enter failed; what() = "
+                 << std::strerror(-res);
+    }
+
+    Reap();
+  }
+
+  void Shutdown() noexcept override {
+    // Completions reaped while submitting may free some of the operations,
+    // cancelling those is a harmless miss.
+    const std::vector<IoOperation*> pending(in_flight_.begin(),
+                                            in_flight_.end());
+    for (auto* const op : pending) {
+      Cancel(reinterpret_cast<uint64_t>(op));
+    }
+    if (wake_armed_) {
+      Cancel(kWakeTag);
+    }
+
+    while (!in_flight_.empty() || wake_armed_) {
+      ring_.Enter(true);
+      Reap();
+    }
+  }
+
+ private:
+  /// Makes room by submitting, and reaping if the completion ring is full.
+  io_uring_sqe* GetSqe() noexcept {
+    for (;;) {
+      if (auto* const res = ring_.GetSqe()) {
+        return res;
+      }
+
+      if (ring_.Enter(false) < 0) {
+        Reap();
+      }
+    }
+  }
+
+  void ArmWake() noexcept {
+    auto* const sqe = GetSqe();
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = wake_fd_;
+    sqe->addr = reinterpret_cast<uint64_t>(&wake_value_);
+    sqe->len = sizeof(wake_value_);
+    sqe->off = kCurrentPosition;
+    sqe->user_data = kWakeTag;
+    wake_armed_ = true;
+  }
+
+  void Cancel(const uint64_t user_data) noexcept {
+    auto* const sqe = GetSqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = user_data;
+    sqe->user_data = kCancelTag;
+  }
+
+  void Submit(IoOperation* const op) noexcept {
+    auto* const sqe = GetSqe();
+    sqe->fd = op->fd;
+    sqe->user_data = reinterpret_cast<uint64_t>(op);
+    if (op->polling) {
+      sqe->opcode = IORING_OP_POLL_ADD;
+      sqe->poll32_events = op->op == EIoOp::Write ? POLLOUT : POLLIN;
+    } else {
+      switch (op->op) {
+        case EIoOp::Read:
+        case EIoOp::Write:
+          sqe->opcode =
+              op->op == EIoOp::Read ? IORING_OP_READ : IORING_OP_WRITE;
+          sqe->addr = reinterpret_cast<uint64_t>(op->data);
+          // Longer operations are short ones.
+          sqe->len = static_cast<uint32_t>(std::min<size_t>(
+              op->size, std::numeric_limits<uint32_t>::max()));
+          sqe->off = op->offset;
+          break;
+        case EIoOp::Accept:
+          sqe->opcode = IORING_OP_ACCEPT;
+          sqe->accept_flags = SOCK_CLOEXEC;
+          break;
+      }
+    }
+    in_flight_.insert(op);
+  }
+
+  void Reap() noexcept {
+    ring_.ForEachCqe([this](const io_uring_cqe& cqe) {
+      OnCompletion(cqe.user_data, cqe.res);
+    });
+  }
+
+  void OnCompletion(const uint64_t user_data, int64_t result) noexcept {
+    if (user_data == kCancelTag) {
+      return;
+    }
+
+    if (user_data == kWakeTag) {
+      wake_armed_ = false;
+      if (!IsStopping()) {
+        ArmWake();
+      }
+      return;
+    }
+
+    auto* const op = reinterpret_cast<IoOperation*>(user_data);
+    if (op->polling) {
+      op->polling = false;
+      if (result >= 0) {
+        if (!IsStopping()) {
+          Submit(op);
+          return;
+        }
+        result = -ECANCELED;
+      }
+    } else if (result == -EAGAIN && !IsStopping()) {
+      // io_uring honours `O_NONBLOCK`, such descriptors are polled first.
+      op->polling = true;
+      Submit(op);
+      return;
+    }
+
+    in_flight_.erase(op);
+    Complete(OperationPtr(op), result);
+  }
+
+ private:
+  internal_executor::IoUring ring_;
+  // Owned by the loop while submitted.
+  std::unordered_set<IoOperation*> in_flight_;
+  uint64_t wake_value_ = 0;
+  bool wake_armed_ = false;
+};
+
+class EpollLoop final : public IoLoop {
+  struct Waiters {
+    std::deque<OperationPtr> readers;
+    std::deque<OperationPtr> writers;
+    // Registered with epoll.
+    uint32_t events = 0;
+  };
+
+ public:
+  using IoLoop::IoLoop;
+
+  ~EpollLoop() override {
+    if (epoll_fd_ >= 0) {
+      close(epoll_fd_);
+    }
+  }
+
+  bool Init() noexcept {
+    if (!InitWake(EFD_NONBLOCK)) {
+      return false;
+    }
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event{.events = EPOLLIN, .data = {.fd = wake_fd_}};
+    auto res = epoll_fd_ >= 0 &&
+               epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event) == 0;
+    return res;
+  }
+
+ protected:
+  void StartOperation(OperationPtr op) noexcept override {
+    const auto fd = op->fd;
+    auto& waiters = fds_[fd];
+    if (waiters.events == 0) {
+      // Readiness doesn't guarantee that a blocking call won't block.
+      const auto flags = fcntl(fd, F_GETFL);
+      if (flags >= 0 && (flags & O_NONBLOCK) == 0) {
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+      }
+    }
+
+    (op->op == EIoOp::Write ? waiters.writers : waiters.readers)
+        .push_back(std::move(op));
+    Update(fd);
+  }
+
+  void Poll(const bool wait) noexcept override {
+    std::array<epoll_event, 64> events;
+    const auto count = epoll_wait(epoll_fd_, events.data(),
+                                  static_cast<int>(events.size()),
+                                  wait ? -1 : 0);
+    if (count < 0) {
+      if (errno != EINTR) {
+        LOG(ERROR) << owner_ << "; epoll_wait failed; what() = "
+                   << std::strerror(errno);
+      }
+      return;
+    }
+
+    for (int i = 0; i < count; ++i) {
+      const auto fd = events[i].data.fd;
+      if (fd == wake_fd_) {
+        uint64_t value = 0;
+        [[maybe_unused]] const auto read_size =
+            read(wake_fd_, &value, sizeof(value));
+        continue;
+      }
+
+      OnReady(fd, events[i].events);
+    }
+  }
+
+  void Shutdown() noexcept override {
+    std::vector<OperationPtr> pending;
+    for (auto& [fd, waiters] : fds_) {
+      if (waiters.events != 0) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+      }
+      for (auto* const ops : {&waiters.readers, &waiters.writers}) {
+        for (auto& op : *ops) {
+          pending.push_back(std::move(op));
+        }
+      }
+    }
+    fds_.clear();
+
+    for (auto& op : pending) {
+      Complete(std::move(op), -ECANCELED);
+    }
+  }
+
+ private:
+  void OnReady(const int fd, const uint32_t events) noexcept {
+    const auto it = fds_.find(fd);
+    if (it == fds_.end()) {
+      return;
+    }
+
+    std::vector<std::pair<OperationPtr, int64_t>> done;
+    if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+      RunReady(it->second.readers, done);
+    }
+    if (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+      RunReady(it->second.writers, done);
+    }
+    // The caller may close the descriptor as soon as the operation completes,
+    // so it leaves epoll first.
+    Update(fd);
+
+    for (auto& [op, res] : done) {
+      Complete(std::move(op), res);
+    }
+  }
+
+  /// Runs the waiting operations in order until one would block.
+  void RunReady(std::deque<OperationPtr>& ops,
+                std::vector<std::pair<OperationPtr, int64_t>>& done) noexcept {
+    while (!ops.empty()) {
+      const auto res = Perform(*ops.front());
+      if (res == -EAGAIN || res == -EWOULDBLOCK) {
+        return;
+      }
+
+      done.emplace_back(std::move(ops.front()), res);
+      ops.pop_front();
+    }
+  }
+
+  /// Brings the registration of `fd` in line with its waiters.
+  void Update(const int fd) noexcept {
+    const auto it = fds_.find(fd);
+    auto& waiters = it->second;
+    uint32_t events = 0;
+    if (!waiters.readers.empty()) {
+      events |= EPOLLIN;
+    }
+    if (!waiters.writers.empty()) {
+      events |= EPOLLOUT;
+    }
+    if (events == waiters.events) {
+      if (events == 0) {
+        fds_.erase(it);
+      }
+      return;
+    }
+
+    if (events == 0) {
+      // Fails if the descriptor is already closed, it's gone from epoll then.
+      epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+      fds_.erase(it);
+      return;
+    }
+
+    epoll_event event{.events = events, .data = {.fd = fd}};
+    const auto op = waiters.events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+    if (epoll_ctl(epoll_fd_, op, fd, &event) == 0) {
+      waiters.events = events;
+      return;
+    }
+
+    // Regular files can't be polled, they are always ready.
+    const auto error = errno;
+    if (waiters.events != 0) {
+      epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    }
+    auto readers = std::move(waiters.readers);
+    auto writers = std::move(waiters.writers);
+    fds_.erase(it);
+    for (auto* const ops : {&readers, &writers}) {
+      for (auto& op : *ops) {
+        const auto res = error == EPERM ? Perform(*op) : -error;
+        Complete(std::move(op), res);
+      }
+    }
+  }
+
+ private:
+  int epoll_fd_ = -1;
+  std::unordered_map<int, Waiters> fds_;
+};
+}  // namespace
+
+class IoExecutor::Impl final : public IExecutor,
+                               public start_stop::IStartableStoppable,
+                               public IRepr,
+                               public start_stop::StoppableState {
+ public:
+  Impl(const IExecutor* const owner, const IoExecutorParams& params)
+      : owner_(owner),
+        params_{
+            .name = params.name.has_value() ? params.name.value() : "IoExec",
+            .thread_count = params.thread_count > 0
+                                ? params.thread_count.value()
+                                : kDefaultThreadCount,
+            .backend = params.backend.value_or(EIoBackend::IoUring),
+            .queue_depth = params.queue_depth > 0 ? params.queue_depth.value()
+                                                  : kDefaultQueueDepth},
+        loops_(CreateLoops()) {}
+
+  void Add(absl::AnyInvocable<void() &&> task) noexcept override {
+    if (IsNotStoppingOrStopped()) {
+      Loop().Post(std::move(task));
+    }
+  }
+
+  bool TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept override {
+    if (IsStoppingOrStopped()) {
+      return false;
+    }
+
+    Loop().Post(std::move(task));
+    return true;
+  }
+
+  Future<size_t> Read(const int fd, const std::span<std::byte> buffer,
+                      const std::optional<uint64_t> offset) noexcept {
+    Promise<size_t> promise;
+    auto res = promise.GetFuture();
+    Submit(IoOperation{.op = EIoOp::Read,
+                       .fd = fd,
+                       .data = buffer.data(),
+                       .size = buffer.size(),
+                       .offset = offset.value_or(kCurrentPosition),
+                       .complete = Completion(std::move(promise), "read")});
+    return res;
+  }
+
+  Future<size_t> Write(const int fd, const std::span<const std::byte> buffer,
+                       const std::optional<uint64_t> offset) noexcept {
+    Promise<size_t> promise;
+    auto res = promise.GetFuture();
+    Submit(IoOperation{.op = EIoOp::Write,
+                       .fd = fd,
+                       .data = const_cast<std::byte*>(buffer.data()),
+                       .size = buffer.size(),
+                       .offset = offset.value_or(kCurrentPosition),
+                       .complete = Completion(std::move(promise), "write")});
+    return res;
+  }
+
+  Future<int> Accept(const int fd) noexcept {
+    Promise<int> promise;
+    auto res = promise.GetFuture();
+    Submit(IoOperation{.op = EIoOp::Accept,
+                       .fd = fd,
+                       .complete = Completion(std::move(promise), "accept")});
+    return res;
+  }
+
+  EIoBackend GetBackend() const noexcept { return params_.backend; }
+
+  std::future<void> start() override {
+    const absl::MutexLock lock(&threads_mutex_);
+    if (threads_.empty() && IsNotStoppingOrStopped()) {
+      for (size_t i = 0; i < loops_.size(); ++i) {
+        threads_.push_back(std::async(std::launch::async, [this, i] {
+          internal_executor::SetCurrentThreadName(params_.name + ":" +
+                                                  std::to_string(i));
+          const internal_executor::ScopedCurrentExecutor current_executor(
+              owner_);
+          loops_[i]->Run();
+        }));
+      }
+    }
+
+    std::promise<void> started;
+    started.set_value();
+    auto res = started.get_future();
+    return res;
+  }
+
+  std::future<void> stop() override {
+    SetStopping();
+    for (auto& loop : loops_) {
+      loop->Wake();
+    }
+
+    auto res = std::async(std::launch::async, [this]() noexcept {
+      std::vector<std::future<void>> threads;
+      {
+        const absl::MutexLock lock(&threads_mutex_);
+        threads.swap(threads_);
+      }
+
+      // Never started: the loops still fail what was submitted meanwhile.
+      if (threads.empty()) {
+        for (auto& loop : loops_) {
+          loop->Run();
+        }
+      }
+
+      for (auto& thread : threads) {
+        try {
+          thread.get();
+        } catch (...) {
+          LogException(*this, std::current_exception());
+        }
+      }
+
+      SetStopped();
+    });
+
+    return res;
+  }
+
+  std::string GetRepr() const noexcept override {
+    return Repr::create("IoExecutor")
+        .field("name", params_.name)
+        .field("thread_count", params_.thread_count)
+        .field("backend", BackendName(params_.backend))
+        .field("queue_depth", params_.queue_depth)
+        .end();
+  }
+
+ private:
+  /// All loops use the same backend: if any io_uring loop can't be set up,
+  /// e.g. once the locked memory limit is reached, they all use epoll.
+  std::vector<std::unique_ptr<IoLoop>> CreateLoops() {
+    std::vector<std::unique_ptr<IoLoop>> res;
+    if (params_.backend == EIoBackend::IoUring) {
+      for (size_t i = 0; i < params_.thread_count; ++i) {
+        auto loop = std::make_unique<UringLoop>(*this, *this);
+        if (!loop->Init(params_.queue_depth)) {
+          LOG(WARNING) << *this << "; io_uring is not available, using epoll; "
+                       << "what() = " << std::strerror(errno);
+          params_.backend = EIoBackend::Epoll;
+          res.clear();
+          break;
+        }
+
+        res.push_back(std::move(loop));
+      }
+
+      if (params_.backend == EIoBackend::IoUring) {
+        return res;
+      }
+    }
+
+    for (size_t i = 0; i < params_.thread_count; ++i) {
+      auto loop = std::make_unique<EpollLoop>(*this, *this);
+      if (!loop->Init()) {
+        throw std::system_error(errno, std::generic_category(),
+                                "failed to create an epoll loop");
+      }
+
+      res.push_back(std::move(loop));
+    }
+
+    return res;
+  }
+
+  /// Operations and tasks issued on a loop thread stay there, the rest are
+  /// spread round-robin.
+  IoLoop& Loop() noexcept {
+    if (current_loop != nullptr && current_loop->IsOwnedBy(*this)) {
+      return *current_loop;
+    }
+
+    const auto index =
+        next_loop_.fetch_add(1, std::memory_order_relaxed) % loops_.size();
+    return *loops_[index];
+  }
+
+  void Submit(IoOperation&& operation) noexcept {
+    auto op = std::make_unique<IoOperation>(std::move(operation));
+    if (IsStoppingOrStopped()) {
+      Complete(std::move(op), -ECANCELED);
+      return;
+    }
+
+    auto& loop = Loop();
+    loop.Post([&loop, op = std::move(op)]() mutable {
+      loop.Start(std::move(op));
+    });
+  }
+
+ private:
+  // The public executor, for `IsCurrentThreadIn`.
+  const IExecutor* const owner_;
+  Params params_;
+  std::vector<std::unique_ptr<IoLoop>> loops_;
+  std::atomic<size_t> next_loop_ = 0;
+
+  absl::Mutex threads_mutex_;
+  std::vector<std::future<void>> threads_ ABSL_GUARDED_BY(threads_mutex_);
+};
+
+IoExecutor::IoExecutor(NotPubliclyConstructible /*npc*/,
+                       const IoExecutorParams& params)
+    : i_(std::make_unique<Impl>(this, params)) {}
+
+IoExecutor::~IoExecutor() = default;
+
+std::unique_ptr<IoExecutor> IoExecutor::create(
+    const IoExecutorParams& params) {
+  auto res = std::make_unique<IoExecutor>(NotPubliclyConstructible(), params);
+  return res;
+}
+
+void IoExecutor::Add(absl::AnyInvocable<void() &&> task) noexcept {
+  i_->Add(std::move(task));
+}
+
+bool IoExecutor::TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept {
+  auto res = i_->TryAdd(std::move(task));
+  return res;
+}
+
+Future<size_t> IoExecutor::Read(const int fd, const std::span<std::byte> buffer,
+                                const std::optional<uint64_t> offset) noexcept {
+  auto res = i_->Read(fd, buffer, offset);
+  return res;
+}
+
+Future<size_t> IoExecutor::Write(
+    const int fd, const std::span<const std::byte> buffer,
+    const std::optional<uint64_t> offset) noexcept {
+  auto res = i_->Write(fd, buffer, offset);
+  return res;
+}
+
+Future<int> IoExecutor::Accept(const int fd) noexcept {
+  auto res = i_->Accept(fd);
+  return res;
+}
+
+EIoBackend IoExecutor::GetBackend() const noexcept {
+  auto res = i_->GetBackend();
+  return res;
+}
+
+std::future<void> IoExecutor::start() {
+  auto res = i_->start();
+  return res;
+}
+
+std::future<void> IoExecutor::stop() {
+  auto res = i_->stop();
+  return res;
+}
+
+}  // namespace handbag::executor
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+
+#include "absl/functional/any_invocable.h"
+#include "lib/cpp/executor/executor.h"
+#include "lib/cpp/executor/future.h"
+#include "lib/cpp/start_stop/start_stop.h"
+
+namespace handbag::executor {
+
+enum class EIoBackend {
+  IoUring,
+  Epoll,
+};
+
+struct IoExecutorParams {
+  std::optional<std::string> name = {};
+  /// Event loops, each on its own thread. Defaults to 1.
+  std::optional<size_t> thread_count = {};
+  /// Defaults to io_uring, falls back to epoll if the kernel doesn't support
+  /// it (Linux < 5.6, or io_uring disabled by seccomp or sysctl).
+  std::optional<EIoBackend> backend = {};
+  /// Size of every io_uring submission ring. Defaults to 256.
+  std::optional<uint32_t> queue_depth = {};
+};
+
+/// Event loop executor for I/O, Linux only. Tasks and operations are spread
+/// round-robin over the loops; ones issued from a loop thread stay on it.
+///
+/// Operations complete their futures on the loop thread, so a coroutine that
+/// awaits one is resumed there and shouldn't do heavy work before moving to a
+/// CPU executor. Failures are reported as `std::system_error`, operations
+/// still pending when the executor stops fail with `ECANCELED`. Buffers must
+/// outlive the operation.
+///
+/// With the epoll backend descriptors are switched to non-blocking mode, and
+/// operations on regular files run synchronously on the loop thread.
+class IoExecutor final : public IExecutor,
+                         public start_stop::IStartableStoppable {
+  class NotPubliclyConstructible {};
+
+ public:
+  IoExecutor() = delete;
+  IoExecutor(const IoExecutor&) = delete;
+  IoExecutor(IoExecutor&&) = delete;
+  IoExecutor& operator=(const IoExecutor&) = delete;
+  IoExecutor& operator=(IoExecutor&&) = delete;
+
+  IoExecutor(NotPubliclyConstructible /*npc*/, const IoExecutorParams& params);
+  ~IoExecutor() override;
+
+  static std::unique_ptr<IoExecutor> create(const IoExecutorParams& params);
+
+  /// Tasks added before `start` run once the loops are started, ones added
+  /// after `stop` are dropped.
+  void Add(absl::AnyInvocable<void() &&> task) noexcept override;
+  bool TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept override;
+
+  /// Reads up to `buffer.size()` bytes, zero means end of file. Without
+  /// `offset` reads at the current file position.
+  Future<size_t> Read(int fd, std::span<std::byte> buffer,
+                      std::optional<uint64_t> offset = std::nullopt) noexcept;
+
+  /// May write less than `buffer.size()` bytes.
+  Future<size_t> Write(int fd, std::span<const std::byte> buffer,
+                       std::optional<uint64_t> offset = std::nullopt) noexcept;
+
+  /// Accepts a connection on a listening socket, returns its descriptor (with
+  /// `SOCK_CLOEXEC` set), which the caller owns.
+  Future<int> Accept(int fd) noexcept;
+
+  /// The backend actually in use.
+  EIoBackend GetBackend() const noexcept;
+
+  std::future<void> start() override;
+
+  std::future<void> stop() override;
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> i_;
+};
+
+}  // namespace handbag::executor
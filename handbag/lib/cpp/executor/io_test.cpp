@@ -0,0 +1,215 @@
+#include "lib/cpp/executor/io.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "lib/cpp/executor/coro.h"
+
+using namespace ::testing;
+
+namespace handbag::executor::tests {
+namespace {
+
+constexpr std::array<EIoBackend, 2> kBackends = {EIoBackend::IoUring,
+                                                 EIoBackend::Epoll};
+
+std::span<const std::byte> AsBytes(const std::string_view text) {
+  auto res = std::as_bytes(std::span(text.data(), text.size()));
+  return res;
+}
+
+std::string ToString(const std::span<const std::byte> bytes) {
+  std::string res(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+  return res;
+}
+
+std::unique_ptr<IoExecutor> Start(const EIoBackend backend) {
+  auto res = IoExecutor::create({.thread_count = 2, .backend = backend});
+  res->start().get();
+  return res;
+}
+
+Task<std::string> Echo(IoExecutor& executor, const int in, const int out) {
+  std::array<std::byte, 16> buffer;
+  const auto size = co_await executor.Read(in, buffer);
+  co_await executor.Write(out, std::span(buffer).first(size));
+  co_return ToString(std::span(buffer).first(size));
+}
+
+TEST(IoExecutorTest, RunsTasks) {
+  for (const auto backend : kBackends) {
+    auto executor = IoExecutor::create({.backend = backend});
+    // Waits for `start`.
+    auto early = AddTo(*executor, [] { return 1; });
+    executor->start().get();
+    EXPECT_THAT(early.Get(), Eq(1));
+    EXPECT_THAT(AddTo(*executor, [] { return 2; }).Get(), Eq(2));
+    executor->stop().get();
+
+    EXPECT_FALSE(executor->TryAdd([] {}));
+  }
+}
+
+TEST(IoExecutorTest, Pipe) {
+  for (const auto backend : kBackends) {
+    auto executor = Start(backend);
+    int fds[2];
+    ASSERT_THAT(pipe(fds), Eq(0));
+
+    // The read is pending until there is something to read.
+    std::array<std::byte, 16> buffer;
+    auto read = executor->Read(fds[0], buffer);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_FALSE(read.IsReady());
+
+    EXPECT_THAT(executor->Write(fds[1], AsBytes("hello")).Get(), Eq(5));
+    const auto size = read.Get();
+    EXPECT_THAT(ToString(std::span(buffer).first(size)), Eq("hello"));
+
+    close(fds[1]);
+    EXPECT_THAT(executor->Read(fds[0], buffer).Get(), Eq(0));
+    close(fds[0]);
+    executor->stop().get();
+  }
+}
+
+TEST(IoExecutorTest, FileAtOffset) {
+  for (const auto backend : kBackends) {
+    auto executor = Start(backend);
+    std::string path = ::testing::TempDir() + "io_test_XXXXXX";
+    const auto fd = mkstemp(path.data());
+    ASSERT_THAT(fd, Ge(0));
+    unlink(path.c_str());
+
+    EXPECT_THAT(executor->Write(fd, AsBytes("0123456789")).Get(), Eq(10));
+    EXPECT_THAT(executor->Write(fd, AsBytes("ab"), 4).Get(), Eq(2));
+    std::array<std::byte, 8> buffer;
+    const auto size = executor->Read(fd, buffer, 2).Get();
+    EXPECT_THAT(ToString(std::span(buffer).first(size)), Eq("23ab6789"));
+
+    close(fd);
+    executor->stop().get();
+  }
+}
+
+TEST(IoExecutorTest, Accept) {
+  for (const auto backend : kBackends) {
+    auto executor = Start(backend);
+    // An abstract unix socket needs neither a file nor the loopback device.
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    const std::string name = "handbag_io_test_" + std::to_string(getpid());
+    std::memcpy(address.sun_path + 1, name.data(), name.size());
+    const auto address_size =
+        static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 +
+                               name.size());
+    const auto listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_THAT(listener, Ge(0));
+    ASSERT_THAT(bind(listener, reinterpret_cast<const sockaddr*>(&address),
+                     address_size),
+                Eq(0));
+    ASSERT_THAT(listen(listener, 1), Eq(0));
+
+    auto accepted = executor->Accept(listener);
+    const auto client = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_THAT(connect(client, reinterpret_cast<const sockaddr*>(&address),
+                        address_size),
+                Eq(0));
+    const auto server = accepted.Get();
+    ASSERT_THAT(server, Ge(0));
+
+    EXPECT_THAT(executor->Write(client, AsBytes("ping")).Get(), Eq(4));
+    std::array<std::byte, 8> buffer;
+    const auto size = executor->Read(server, buffer).Get();
+    EXPECT_THAT(ToString(std::span(buffer).first(size)), Eq("ping"));
+
+    close(server);
+    close(client);
+    close(listener);
+    executor->stop().get();
+  }
+}
+
+TEST(IoExecutorTest, Coroutine) {
+  for (const auto backend : kBackends) {
+    auto executor = Start(backend);
+    int in[2];
+    int out[2];
+    ASSERT_THAT(socketpair(AF_UNIX, SOCK_STREAM, 0, in), Eq(0));
+    ASSERT_THAT(socketpair(AF_UNIX, SOCK_STREAM, 0, out), Eq(0));
+
+    auto echoed = StartOn(*executor, Echo(*executor, in[1], out[1]));
+    ASSERT_THAT(write(in[0], "abc", 3), Eq(3));
+    EXPECT_THAT(echoed.Get(), Eq("abc"));
+    std::array<char, 8> buffer;
+    EXPECT_THAT(read(out[0], buffer.data(), buffer.size()), Eq(3));
+    EXPECT_THAT(std::string_view(buffer.data(), 3), Eq("abc"));
+
+    for (const auto fd : {in[0], in[1], out[0], out[1]}) {
+      close(fd);
+    }
+    executor->stop().get();
+  }
+}
+
+TEST(IoExecutorTest, Errors) {
+  for (const auto backend : kBackends) {
+    auto executor = Start(backend);
+    std::array<std::byte, 8> buffer;
+    try {
+      executor->Read(-1, buffer).Get();
+      FAIL() << "unreachable";
+    } catch (const std::system_error& exc) {
+      EXPECT_THAT(exc.code().value(), Eq(EBADF));
+    }
+    executor->stop().get();
+  }
+}
+
+TEST(IoExecutorTest, StopCancelsPendingOperations) {
+  for (const auto backend : kBackends) {
+    auto executor = Start(backend);
+    int fds[2];
+    ASSERT_THAT(pipe(fds), Eq(0));
+
+    std::array<std::byte, 8> buffer;
+    auto read = executor->Read(fds[0], buffer);
+    executor->stop().get();
+    try {
+      read.Get();
+      FAIL() << "unreachable";
+    } catch (const std::system_error& exc) {
+      EXPECT_THAT(exc.code().value(), Eq(ECANCELED));
+    }
+
+    try {
+      executor->Read(fds[0], buffer).Get();
+      FAIL() << "unreachable";
+    } catch (const std::system_error& exc) {
+      EXPECT_THAT(exc.code().value(), Eq(ECANCELED));
+    }
+
+    close(fds[0]);
+    close(fds[1]);
+  }
+}
+
+}  // namespace
+}  // namespace handbag::executor::tests
@@ -0,0 +1,154 @@
+#include "lib/cpp/executor/parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <exception>
+#include <memory>
+#include <thread>
+
+#include "absl/base/optimization.h"
+
+namespace handbag::internal_executor {
+
+namespace {
+// Smaller runs are not worth a task of their own.
+constexpr size_t kMinSortPartSize = 4096;
+
+size_t Parallelism(const ParallelOptions& options) noexcept {
+  const auto res =
+      options.max_parallelism.value_or(std::thread::hardware_concurrency());
+  return std::max<size_t>(res, 1);
+}
+
+/// Shared by the caller and the helper tasks, which may start after the work
+/// is done and then must not touch `body`.
+class ChunkState {
+ public:
+  ChunkState(const size_t begin, const size_t end, const size_t grain,
+             const size_t parallelism,
+             const absl::FunctionRef<void(size_t, size_t)> body) noexcept
+      : next_(begin),
+        end_(end),
+        grain_(grain),
+        parallelism_(parallelism),
+        pending_(end - begin),
+        body_(body) {}
+
+  void Work() noexcept {
+    size_t chunk_begin = 0;
+    size_t chunk_end = 0;
+    while (Claim(chunk_begin, chunk_end)) {
+      try {
+        body_(chunk_begin, chunk_end);
+      } catch (...) {
+        Fail(std::current_exception());
+      }
+      Finish(chunk_end - chunk_begin);
+    }
+  }
+
+  /// Waits for the chunks started by others, rethrows the first exception.
+  void Wait() {
+    for (auto pending = pending_.load(std::memory_order_acquire); pending > 0;
+         pending = pending_.load(std::memory_order_acquire)) {
+      pending_.wait(pending, std::memory_order_acquire);
+    }
+
+    if (exception_) {
+      std::rethrow_exception(exception_);
+    }
+  }
+
+ private:
+  /// Chunks shrink with the remaining work, so early chunks are cheap to hand
+  /// out and late ones still balance the load.
+  bool Claim(size_t& chunk_begin, size_t& chunk_end) noexcept {
+    auto next = next_.load(std::memory_order_relaxed);
+    for (;;) {
+      if (next >= end_) {
+        return false;
+      }
+
+      const auto remaining = end_ - next;
+      const auto size = std::min(
+          remaining, std::max(grain_, remaining / (2 * parallelism_)));
+      if (next_.compare_exchange_weak(next, next + size,
+                                      std::memory_order_relaxed)) {
+        chunk_begin = next;
+        chunk_end = next + size;
+        return true;
+      }
+    }
+  }
+
+  void Finish(const size_t count) noexcept {
+    if (pending_.fetch_sub(count, std::memory_order_acq_rel) == count) {
+      pending_.notify_all();
+    }
+  }
+
+  void Fail(std::exception_ptr eptr) noexcept {
+    if (failed_.exchange(true)) {
+      return;
+    }
+
+    exception_ = std::move(eptr);
+    const auto skipped_from = next_.exchange(end_);
+    if (skipped_from < end_) {
+      Finish(end_ - skipped_from);
+    }
+  }
+
+ private:
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<size_t> next_;
+  const size_t end_;
+  const size_t grain_;
+  const size_t parallelism_;
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<size_t> pending_;
+  std::atomic<bool> failed_ = false;
+  // Written by the first failing chunk before it finishes.
+  std::exception_ptr exception_;
+  const absl::FunctionRef<void(size_t, size_t)> body_;
+};
+}  // namespace
+
+void ParallelForChunks(IExecutor& executor, const size_t begin,
+                       const size_t end, const ParallelOptions& options,
+                       const absl::FunctionRef<void(size_t, size_t)> body) {
+  if (begin >= end) {
+    return;
+  }
+
+  const auto grain = std::max<size_t>(options.grain_size.value_or(1), 1);
+  const auto parallelism = Parallelism(options);
+  const auto chunks = (end - begin + grain - 1) / grain;
+  const auto helpers = std::min(parallelism, chunks) - 1;
+  if (helpers == 0) {
+    body(begin, end);
+    return;
+  }
+
+  const auto state =
+      std::make_shared<ChunkState>(begin, end, grain, parallelism, body);
+  for (size_t i = 0; i < helpers; ++i) {
+    // A full executor just leaves more work to the caller.
+    if (!executor.TryAdd([state] { state->Work(); })) {
+      break;
+    }
+  }
+
+  state->Work();
+  state->Wait();
+}
+
+size_t SortPartCount(const size_t size,
+                     const ParallelOptions& options) noexcept {
+  const auto min_part =
+      std::max(options.grain_size.value_or(1), kMinSortPartSize);
+  const auto parts = std::min(Parallelism(options), size / min_part);
+  auto res = parts == 0 ? size_t{1} : std::bit_floor(parts);
+  return res;
+}
+
+}  // namespace handbag::internal_executor
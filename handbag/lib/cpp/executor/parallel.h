@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/functional/function_ref.h"
+#include "absl/synchronization/mutex.h"
+#include "lib/cpp/executor/executor.h"
+
+namespace handbag {
+
+struct ParallelOptions {
+  /// Fewest indices handed out at once. Chunks start large and shrink as the
+  /// work runs out, down to this size. Defaults to 1.
+  std::optional<size_t> grain_size = {};
+  /// Most tasks working at once, the calling thread included. Defaults to the
+  /// number of hardware threads.
+  std::optional<size_t> max_parallelism = {};
+};
+
+namespace internal_executor {
+
+/// Calls `body` on disjoint chunks covering [begin, end). The calling thread
+/// takes part and only waits for the chunks somebody already started, so it
+/// doesn't deadlock even if `executor` never runs the helper tasks (e.g. when
+/// called from its only worker). The first exception thrown by `body` stops
+/// handing out new chunks and is rethrown.
+void ParallelForChunks(IExecutor& executor, size_t begin, size_t end,
+                       const ParallelOptions& options,
+                       absl::FunctionRef<void(size_t, size_t)> body);
+
+/// Number of sorted runs `ParallelSort` splits `size` elements into, a power
+/// of two.
+size_t SortPartCount(size_t size, const ParallelOptions& options) noexcept;
+
+}  // namespace internal_executor
+
+/// Calls `body(i)` for every i in [begin, end), or `body(chunk_begin,
+/// chunk_end)` for disjoint chunks covering it if `body` takes two indices.
+template <typename Body>
+void ParallelFor(IExecutor& executor, const size_t begin, const size_t end,
+                 Body&& body, const ParallelOptions& options = {}) {
+  if constexpr (std::is_invocable_v<Body&, size_t, size_t>) {
+    internal_executor::ParallelForChunks(executor, begin, end, options, body);
+  } else {
+    internal_executor::ParallelForChunks(
+        executor, begin, end, options,
+        [&body](const size_t chunk_begin, const size_t chunk_end) {
+          for (auto i = chunk_begin; i < chunk_end; ++i) {
+            body(i);
+          }
+        });
+  }
+}
+
+/// Writes `transform(x)` for every element of `input` to `output`.
+template <std::ranges::random_access_range Input,
+          std::random_access_iterator Output, typename Transform>
+void ParallelTransform(IExecutor& executor, Input&& input, Output output,
+                       Transform&& transform,
+                       const ParallelOptions& options = {}) {
+  const auto first = std::ranges::begin(input);
+  ParallelFor(
+      executor, 0, static_cast<size_t>(std::ranges::size(input)),
+      [&](const size_t chunk_begin, const size_t chunk_end) {
+        for (auto i = chunk_begin; i < chunk_end; ++i) {
+          const auto offset = static_cast<std::ptrdiff_t>(i);
+          output[offset] = std::invoke(transform, first[offset]);
+        }
+      },
+      options);
+}
+
+/// Folds `input` into `init` with `reduce`, which must be associative but
+/// doesn't have to be commutative: partial results are combined in order.
+template <std::ranges::random_access_range Input, typename T,
+          typename Reduce = std::plus<>>
+T ParallelReduce(IExecutor& executor, Input&& input, T init,
+                 Reduce&& reduce = {}, const ParallelOptions& options = {}) {
+  const auto first = std::ranges::begin(input);
+  absl::Mutex mutex;
+  std::vector<std::pair<size_t, T>> partials;
+  ParallelFor(
+      executor, 0, static_cast<size_t>(std::ranges::size(input)),
+      [&](const size_t chunk_begin, const size_t chunk_end) {
+        T partial = first[static_cast<std::ptrdiff_t>(chunk_begin)];
+        for (auto i = chunk_begin + 1; i < chunk_end; ++i) {
+          partial = std::invoke(reduce, std::move(partial),
+                                first[static_cast<std::ptrdiff_t>(i)]);
+        }
+
+        const absl::MutexLock lock(&mutex);
+        partials.emplace_back(chunk_begin, std::move(partial));
+      },
+      options);
+
+  std::sort(partials.begin(), partials.end(),
+            [](const auto& lhs, const auto& rhs) {
+              return lhs.first < rhs.first;
+            });
+  auto res = std::move(init);
+  for (auto& [_, partial] : partials) {
+    res = std::invoke(reduce, std::move(res), std::move(partial));
+  }
+  return res;
+}
+
+/// Sorts runs of the range in parallel and merges them pairwise, the merges
+/// of every round in parallel too. Not stable.
+template <std::random_access_iterator Iterator, typename Compare = std::less<>>
+void ParallelSort(IExecutor& executor, const Iterator first,
+                  const Iterator last, Compare comp = {},
+                  const ParallelOptions& options = {}) {
+  const auto size = static_cast<size_t>(last - first);
+  const auto parts = internal_executor::SortPartCount(size, options);
+  if (parts <= 1) {
+    std::sort(first, last, comp);
+    return;
+  }
+
+  const auto bound = [&](const size_t part) {
+    return first + static_cast<std::ptrdiff_t>(size * part / parts);
+  };
+  const ParallelOptions part_options = {
+      .grain_size = 1, .max_parallelism = options.max_parallelism};
+  ParallelFor(
+      executor, 0, parts,
+      [&](const size_t part) {
+        std::sort(bound(part), bound(part + 1), comp);
+      },
+      part_options);
+
+  for (size_t width = 1; width < parts; width *= 2) {
+    ParallelFor(
+        executor, 0, parts / (2 * width),
+        [&](const size_t pair) {
+          const auto lo = 2 * pair * width;
+          std::inplace_merge(bound(lo), bound(lo + width),
+                             bound(lo + 2 * width), comp);
+        },
+        part_options);
+  }
+}
+
+template <std::ranges::random_access_range Range,
+          typename Compare = std::less<>>
+void ParallelSort(IExecutor& executor, Range&& range, Compare comp = {},
+                  const ParallelOptions& options = {}) {
+  ParallelSort(executor, std::ranges::begin(range), std::ranges::end(range),
+               std::move(comp), options);
+}
+
+}  // namespace handbag
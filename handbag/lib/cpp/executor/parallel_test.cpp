@@ -0,0 +1,127 @@
+#include "lib/cpp/executor/parallel.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "lib/cpp/executor/cpu.h"
+
+using namespace ::testing;
+
+namespace handbag::tests {
+namespace {
+
+class ParallelTest : public Test {
+ protected:
+  void TearDown() override { executor_->stop().get(); }
+
+  std::unique_ptr<executor::CpuExecutor> executor_ =
+      executor::CpuExecutor::create({.thread_count = 4});
+};
+
+TEST_F(ParallelTest, ForVisitsEveryIndexOnce) {
+  std::vector<std::atomic<int>> visits(10000);
+  ParallelFor(*executor_, 0, visits.size(),
+              [&](const size_t i) { (void)visits[i].fetch_add(1); });
+  EXPECT_TRUE(std::all_of(visits.begin(), visits.end(),
+                          [](const auto& count) { return count == 1; }));
+}
+
+TEST_F(ParallelTest, ForChunksRespectGrainSize) {
+  std::atomic<size_t> covered = 0;
+  std::atomic<bool> too_small = false;
+  ParallelFor(
+      *executor_, 0, 1000,
+      [&](const size_t begin, const size_t end) {
+        if (end - begin < 100 && end != 1000) {
+          too_small = true;
+        }
+        (void)covered.fetch_add(end - begin);
+      },
+      {.grain_size = 100, .max_parallelism = 8});
+  EXPECT_THAT(covered.load(), Eq(1000));
+  EXPECT_FALSE(too_small.load());
+}
+
+TEST_F(ParallelTest, ForFromInsideWorkers) {
+  // Every worker is busy in an outer loop, so the inner loops can only finish
+  // if their callers do all the work themselves.
+  auto single = executor::CpuExecutor::create({.thread_count = 1});
+  auto result = AddTo(*single, [&] {
+    std::atomic<int> sum = 0;
+    ParallelFor(*single, 0, 100, [&](const size_t i) {
+      ParallelFor(*single, 0, 100,
+                  [&](const size_t j) { (void)sum.fetch_add(i * j); });
+    });
+    return sum.load();
+  });
+  EXPECT_THAT(result.Get(), Eq(4950 * 4950));
+  single->stop().get();
+}
+
+TEST_F(ParallelTest, ForRethrowsAndStops) {
+  std::atomic<int> calls = 0;
+  EXPECT_THAT(
+      [&] {
+        ParallelFor(
+            *executor_, 0, 1000000,
+            [&](const size_t i) {
+              (void)calls.fetch_add(1);
+              if (i == 10) {
+                throw std::runtime_error("NEEDLE");
+              }
+            },
+            {.grain_size = 1});
+      },
+      ThrowsMessage<std::runtime_error>(Eq("NEEDLE")));
+  EXPECT_THAT(calls.load(), Lt(1000000));
+}
+
+TEST_F(ParallelTest, Transform) {
+  std::vector<int> input(10000);
+  std::iota(input.begin(), input.end(), 0);
+  std::vector<std::string> output(input.size());
+  ParallelTransform(*executor_, input, output.begin(),
+                    [](const int x) { return std::to_string(x * 2); });
+  for (size_t i = 0; i < input.size(); ++i) {
+    EXPECT_THAT(output[i], Eq(std::to_string(i * 2)));
+  }
+}
+
+TEST_F(ParallelTest, ReduceKeepsOrder) {
+  std::vector<std::string> input;
+  std::string expected = "> ";
+  for (int i = 0; i < 1000; ++i) {
+    input.push_back(std::to_string(i));
+    expected += input.back();
+  }
+
+  EXPECT_THAT(ParallelReduce(*executor_, input, std::string("> ")),
+              Eq(expected));
+  EXPECT_THAT(ParallelReduce(*executor_, std::vector<int>(), 7), Eq(7));
+}
+
+TEST_F(ParallelTest, Sort) {
+  std::mt19937 rng(42);
+  for (const size_t size : {0, 1, 100, 4096 * 3 + 7, 100000}) {
+    std::vector<uint32_t> values(size);
+    std::generate(values.begin(), values.end(), rng);
+    auto expected = values;
+    std::sort(expected.begin(), expected.end(), std::greater<>());
+
+    ParallelSort(*executor_, values, std::greater<>(),
+                 {.max_parallelism = 8});
+    EXPECT_THAT(values, ContainerEq(expected));
+  }
+}
+
+}  // namespace
+}  // namespace handbag::tests
@@ -0,0 +1,41 @@
+#include "lib/cpp/executor/internal/parking.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+using namespace ::testing;
+
+namespace handbag::internal_executor::tests {
+namespace {
+
+TEST(ParkerTest, UnparkBeforePark) {
+  Parker parker;
+  parker.Unpark();
+  parker.Unpark();
+  EXPECT_TRUE(parker.Park(absl::InfiniteDuration()));
+  EXPECT_FALSE(parker.Park(absl::ZeroDuration()));
+}
+
+TEST(ParkerTest, Timeout) {
+  Parker parker;
+  const auto start = absl::Now();
+  EXPECT_FALSE(parker.Park(absl::Milliseconds(20)));
+  EXPECT_THAT(absl::Now() - start, Ge(absl::Milliseconds(20)));
+}
+
+TEST(ParkerTest, UnparkFromAnotherThread) {
+  Parker parker;
+  for (int i = 0; i < 100; ++i) {
+    std::thread unparker([&] { parker.Unpark(); });
+    EXPECT_TRUE(parker.Park(absl::InfiniteDuration()));
+    unparker.join();
+  }
+}
+
+}  // namespace
+}  // namespace handbag::internal_executor::tests
@@ -0,0 +1,144 @@
+#include "lib/cpp/executor/sequenced.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <string>
+#include <utility>
+
+#include "absl/base/optimization.h"
+#include "absl/log/log.h"
+#include "lib/cpp/executor/internal/mpsc_queue.h"
+#include "lib/cpp/repr/repr.h"
+
+namespace handbag::executor {
+
+namespace {
+
+constexpr size_t kDefaultBatchSize = 64;
+}  // namespace
+
+class SequencedExecutor::Impl final
+    : public IRepr,
+      public std::enable_shared_from_this<Impl> {
+ public:
+  Impl(const IExecutor* const owner, IExecutor& target,
+       const SequencedExecutorParams& params)
+      : owner_(owner),
+        target_(target),
+        batch_size_(std::max<size_t>(
+            params.batch_size.value_or(kDefaultBatchSize), 1)) {}
+
+  void Add(ExecutorTask task) noexcept {
+    queue_.Push(std::move(task));
+    // Whoever makes the strand non-empty schedules it, everybody else just
+    // leaves the task to the running drain.
+    if (pending_.fetch_add(1, std::memory_order_acq_rel) == 0) {
+      Schedule(false);
+    }
+  }
+
+  std::string GetRepr() const noexcept override {
+    return Repr::create("SequencedExecutor")
+        .field("batch_size", batch_size_)
+        .field("pending", pending_.load(std::memory_order_relaxed))
+        .end();
+  }
+
+ private:
+  /// A drain that ran out of budget yields: it goes behind the tasks queued
+  /// on the target meanwhile instead of running next on the same thread.
+  void Schedule(const bool yield) noexcept {
+    target_.Add([self = shared_from_this()] { self->Drain(); },
+                TaskOptions{.yield = yield});
+  }
+
+  /// Only one drain runs at a time: the next one is scheduled either by the
+  /// drain itself or by the push that found the strand empty, after this one
+  /// has seen `pending_` drop to zero.
+  void Drain() noexcept {
+    // The strand may already be destroyed, its address is only compared.
+    const internal_executor::ScopedCurrentExecutor current_executor(owner_);
+    auto budget = batch_size_;
+    for (;;) {
+      size_t done = 0;
+      ExecutorTask task;
+      while (done < budget && queue_.TryPop(task)) {
+        Run(std::move(task));
+        ++done;
+      }
+
+      if (pending_.fetch_sub(done, std::memory_order_acq_rel) == done) {
+        return;
+      }
+
+      budget -= done;
+      // Nothing to pop while tasks are pending means a producer got preempted
+      // in the middle of a push: the drain goes behind it on the target
+      // instead of spinning until it's back.
+      if (budget == 0 || done == 0) {
+        Schedule(true);
+        return;
+      }
+    }
+  }
+
+  void Run(ExecutorTask task) noexcept {
+    try {
+      std::move(task)();
+    } catch (...) {
+      auto eptr = std::current_exception();
+      std::string message;
+      try {
+        std::rethrow_exception(eptr);
+      } catch (const std::exception& exc) {
+        message = exc.what();
+      }
+
+      LOG(ERROR) << *this << "; what() = " << message;
+    }
+  }
+
+ private:
+  const IExecutor* const owner_;
+  IExecutor& target_;
+  const size_t batch_size_;
+  internal_executor::MpscQueue<ExecutorTask> queue_;
+  // Tasks pushed and not run yet.
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<size_t> pending_ = 0;
+};
+
+SequencedExecutor::SequencedExecutor(NotPubliclyConstructible /*npc*/,
+                                     IExecutor& target,
+                                     const SequencedExecutorParams& params)
+    : i_(std::make_shared<Impl>(this, target, params)) {}
+
+SequencedExecutor::~SequencedExecutor() = default;
+
+std::unique_ptr<SequencedExecutor> SequencedExecutor::create(
+    IExecutor& target, const SequencedExecutorParams& params) {
+  auto res = std::make_unique<SequencedExecutor>(NotPubliclyConstructible(),
+                                                 target, params);
+  return res;
+}
+
+void SequencedExecutor::Add(absl::AnyInvocable<void() &&> task) noexcept {
+  i_->Add(std::move(task));
+}
+
+bool SequencedExecutor::TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept {
+  i_->Add(std::move(task));
+  return true;
+}
+
+void SequencedExecutor::AddTask(ExecutorTask task,
+                                const TaskOptions& options) noexcept {
+  if (options.cancellation.has_value()) {
+    IExecutor::AddTask(std::move(task), options);
+    return;
+  }
+
+  i_->Add(std::move(task));
+}
+
+}  // namespace handbag::executor
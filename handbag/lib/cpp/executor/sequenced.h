@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+
+#include "absl/functional/any_invocable.h"
+#include "lib/cpp/executor/executor.h"
+
+namespace handbag::executor {
+
+struct SequencedExecutorParams {
+  /// Most tasks run in a row before the strand yields the target's thread to
+  /// other work and queues itself again. Defaults to 64.
+  std::optional<size_t> batch_size;
+};
+
+/// Strand: runs the tasks added to it one at a time and in order, on the
+/// threads of the target executor but never concurrently, so they can share
+/// state without locking. Doesn't own a thread, an idle strand costs nothing
+/// but its memory.
+///
+/// Tasks are queued in a lock-free list, which is unbounded: `TryAdd` always
+/// succeeds and task options are ignored. Tasks added but not run yet keep the
+/// strand's state alive, so it's fine to destroy the strand right after adding
+/// tasks; the target executor must run them though, or they leak.
+class SequencedExecutor final : public IExecutor {
+  class NotPubliclyConstructible {};
+
+ public:
+  SequencedExecutor() = delete;
+  SequencedExecutor(const SequencedExecutor&) = delete;
+  SequencedExecutor(SequencedExecutor&&) = delete;
+  SequencedExecutor& operator=(const SequencedExecutor&) = delete;
+  SequencedExecutor& operator=(SequencedExecutor&&) = delete;
+
+  SequencedExecutor(NotPubliclyConstructible /*npc*/, IExecutor& target,
+                    const SequencedExecutorParams& params);
+  ~SequencedExecutor() override;
+
+  static std::unique_ptr<SequencedExecutor> create(
+      IExecutor& target, const SequencedExecutorParams& params = {});
+
+  void Add(absl::AnyInvocable<void() &&> task) noexcept override;
+  bool TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept override;
+  void AddTask(ExecutorTask task, const TaskOptions& options) noexcept override;
+
+ private:
+  class Impl;
+  std::shared_ptr<Impl> i_;
+};
+
+}  // namespace handbag::executor
@@ -0,0 +1,128 @@
+#include "lib/cpp/executor/sequenced.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "absl/synchronization/notification.h"
+#include "lib/cpp/executor/cpu.h"
+
+using namespace ::testing;
+
+namespace handbag::executor::tests {
+namespace {
+
+TEST(SequencedExecutorTest, RunsTasksInOrderOneAtATime) {
+  auto target = CpuExecutor::create({.thread_count = 4});
+  auto strand = SequencedExecutor::create(*target);
+
+  constexpr int kProducers = 4;
+  constexpr int kTasks = 10000;
+  std::atomic<bool> running = false;
+  std::atomic<bool> overlapped = false;
+  // Not synchronized: the strand is supposed to do it.
+  std::vector<int> last(kProducers, -1);
+  bool out_of_order = false;
+  int done = 0;
+  absl::Notification all_done;
+
+  std::vector<std::future<void>> producers;
+  for (int producer = 0; producer < kProducers; ++producer) {
+    producers.push_back(std::async(std::launch::async, [&, producer] {
+      for (int i = 0; i < kTasks; ++i) {
+        strand->Add([&, producer, i] {
+          if (running.exchange(true)) {
+            overlapped = true;
+          }
+          out_of_order |= last[producer] + 1 != i;
+          last[producer] = i;
+          if (++done == kProducers * kTasks) {
+            all_done.Notify();
+          }
+          running = false;
+        });
+      }
+    }));
+  }
+  for (auto& producer : producers) {
+    producer.get();
+  }
+
+  all_done.WaitForNotification();
+  EXPECT_FALSE(overlapped.load());
+  EXPECT_FALSE(out_of_order);
+
+  target->stop().get();
+}
+
+TEST(SequencedExecutorTest, YieldsAfterBatch) {
+  auto target = CpuExecutor::create({.thread_count = 1});
+  auto first = SequencedExecutor::create(*target, {.batch_size = 2});
+  auto second = SequencedExecutor::create(*target, {.batch_size = 2});
+
+  absl::Notification started;
+  absl::Notification release;
+  target->Add([&] {
+    started.Notify();
+    release.WaitForNotification();
+  });
+  started.WaitForNotification();
+
+  std::string order;
+  for (int i = 0; i < 4; ++i) {
+    first->Add([&] { order += 'a'; });
+    second->Add([&] { order += 'b'; });
+  }
+
+  release.Notify();
+  target->stop().get();
+  EXPECT_THAT(order, Eq("aabbaabb"));
+}
+
+TEST(SequencedExecutorTest, IsCurrentThreadIn) {
+  auto target = CpuExecutor::create({.thread_count = 1});
+  auto strand = SequencedExecutor::create(*target);
+
+  EXPECT_TRUE(AddTo(*strand, [&] {
+                return IsCurrentThreadIn(*strand) &&
+                       IsCurrentThreadIn(*target);
+              }).Get());
+  EXPECT_FALSE(AddTo(*target, [&] {
+                 return IsCurrentThreadIn(*strand);
+               }).Get());
+
+  target->stop().get();
+}
+
+TEST(SequencedExecutorTest, OutlivedByItsTasks) {
+  auto target = CpuExecutor::create({.thread_count = 2});
+
+  std::atomic<int> done = 0;
+  {
+    auto strand = SequencedExecutor::create(*target);
+    for (int i = 0; i < 1000; ++i) {
+      strand->Add([&] { (void)done.fetch_add(1); });
+    }
+  }
+
+  target->stop().get();
+  EXPECT_THAT(done.load(), Eq(1000));
+}
+
+TEST(SequencedExecutorTest, ExceptionsDontStopTheStrand) {
+  auto target = CpuExecutor::create({.thread_count = 2});
+  auto strand = SequencedExecutor::create(*target);
+
+  strand->Add([] { throw std::runtime_error("NEEDLE"); });
+  EXPECT_THAT(AddTo(*strand, [] { return 1; }).Get(), Eq(1));
+
+  target->stop().get();
+}
+
+}  // namespace
+}  // namespace handbag::executor::tests
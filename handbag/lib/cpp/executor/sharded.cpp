@@ -0,0 +1,463 @@
+#include "lib/cpp/executor/sharded.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <future>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/optimization.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/log/log.h"
+#include "absl/synchronization/mutex.h"
+#include "lib/cpp/executor/internal/stats.h"
+#include "lib/cpp/executor/internal/topology.h"
+#include "lib/cpp/repr/repr.h"
+#include "lib/cpp/start_stop/state.h"
+
+namespace handbag::executor {
+
+namespace {
+constexpr size_t kDefaultThreadsPerShard = 1;
+
+struct QueuedTask {
+  ExecutorTask task;
+  // `internal_executor::NowNanos()` at submission.
+  uint64_t enqueued_at = 0;
+};
+
+struct WorkerContext {
+  const void* owner = nullptr;
+  size_t shard = 0;
+};
+
+thread_local WorkerContext current_worker;
+}  // namespace
+
+class ShardedExecutor::Impl final : public IExecutor,
+                                    public start_stop::IStoppable,
+                                    public IRepr,
+                                    public start_stop::StoppableState {
+  /// What `GetShard` returns.
+  class ShardExecutor final : public IExecutor {
+   public:
+    ShardExecutor(Impl& impl, const size_t index) noexcept
+        : impl_(impl), index_(index) {}
+
+    void Add(absl::AnyInvocable<void() &&> task) noexcept override {
+      impl_.Push(index_, std::move(task));
+    }
+
+    bool TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept override {
+      impl_.Push(index_, std::move(task));
+      return true;
+    }
+
+    void AddTask(ExecutorTask task,
+                 const TaskOptions& options) noexcept override {
+      if (options.cancellation.has_value()) {
+        IExecutor::AddTask(std::move(task), options);
+        return;
+      }
+
+      impl_.Push(index_, std::move(task));
+    }
+
+   private:
+    Impl& impl_;
+    const size_t index_;
+  };
+
+  struct alignas(ABSL_CACHELINE_SIZE) Shard {
+    Shard(Impl& impl, const size_t index) noexcept : executor(impl, index) {}
+
+    ShardExecutor executor;
+    absl::Mutex mutex;
+    absl::CondVar cond_var;
+    std::deque<QueuedTask> tasks ABSL_GUARDED_BY(mutex);
+    // Set by a producer whose shard got hot, so an idle worker of this shard
+    // goes stealing.
+    bool steal_requested ABSL_GUARDED_BY(mutex) = false;
+    uint64_t submitted ABSL_GUARDED_BY(mutex) = 0;
+    uint64_t stolen ABSL_GUARDED_BY(mutex) = 0;
+    DurationHistogram queue_wait ABSL_GUARDED_BY(mutex);
+    // Mirror `tasks.size()` and the number of waiting workers for the other
+    // shards, which read them without the lock.
+    std::atomic<size_t> depth = 0;
+    std::atomic<size_t> idle = 0;
+    std::atomic<uint64_t> completed = 0;
+    std::atomic<uint64_t> failed = 0;
+  };
+
+ public:
+  Impl(const IExecutor* const owner, const ShardedExecutorParams& params)
+      : owner_(owner),
+        name_(params.name.has_value() ? params.name.value() : "ShardExec"),
+        threads_per_shard_(
+            std::max<size_t>(params.threads_per_shard.value_or(
+                                 kDefaultThreadsPerShard),
+                             1)),
+        cpus_(params.cpus.value_or(std::vector<size_t>())),
+        steal_threshold_(params.steal_threshold.has_value()
+                             ? std::max<size_t>(params.steal_threshold.value(),
+                                                1)
+                             : std::numeric_limits<size_t>::max()) {
+    const auto shard_count = std::max<size_t>(
+        params.shard_count > 0 ? params.shard_count.value()
+                               : internal_executor::GetAvailableCpus().size(),
+        1);
+    shards_.reserve(shard_count);
+    for (size_t i = 0; i < shard_count; ++i) {
+      shards_.push_back(std::make_unique<Shard>(*this, i));
+    }
+
+    workers_.reserve(shards_.size() * threads_per_shard_);
+    for (size_t i = 0; i < shards_.size(); ++i) {
+      for (size_t j = 0; j < threads_per_shard_; ++j) {
+        workers_.push_back(
+            std::async(std::launch::async, &Impl::WorkerTask, this, i, j));
+      }
+    }
+  }
+
+  void Add(absl::AnyInvocable<void() &&> task) noexcept override {
+    Push(DefaultShard(), std::move(task));
+  }
+
+  bool TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept override {
+    Push(DefaultShard(), std::move(task));
+    return true;
+  }
+
+  void AddTask(ExecutorTask task,
+               const TaskOptions& options) noexcept override {
+    shards_[DefaultShard()]->executor.AddTask(std::move(task), options);
+  }
+
+  size_t GetShardCount() const noexcept { return shards_.size(); }
+
+  IExecutor& GetShard(const size_t index) noexcept {
+    auto& res = shards_[index]->executor;
+    return res;
+  }
+
+  std::vector<ShardStats> GetStats() const noexcept {
+    std::vector<ShardStats> res(shards_.size());
+    for (size_t i = 0; i < shards_.size(); ++i) {
+      auto& shard = *shards_[i];
+      auto& stats = res[i];
+      {
+        const absl::MutexLock lock(&shard.mutex);
+        stats.submitted = shard.submitted;
+        stats.stolen = shard.stolen;
+        stats.queue_depth = shard.tasks.size();
+        stats.queue_wait = shard.queue_wait;
+      }
+      stats.completed = shard.completed.load(std::memory_order_relaxed);
+      stats.failed = shard.failed.load(std::memory_order_relaxed);
+      stats.idle_thread_count = shard.idle.load(std::memory_order_relaxed);
+    }
+
+    return res;
+  }
+
+  std::future<void> stop() override {
+    SetStopping();
+    // Under the lock, so that a worker either sees the flag or is already
+    // waiting when signalled.
+    for (auto& shard : shards_) {
+      const absl::MutexLock lock(&shard->mutex);
+      shard->cond_var.SignalAll();
+    }
+
+    auto res = std::async(std::launch::async, [this]() noexcept {
+      for (auto& worker : workers_) {
+        try {
+          worker.get();
+        } catch (...) {
+          auto eptr = std::current_exception();
+          std::string message;
+          try {
+            std::rethrow_exception(eptr);
+          } catch (const std::exception& exc) {
+            message = exc.what();
+          }
+
+          LOG(ERROR) << *this << "; what() = " << message;
+        }
+      }
+
+      SetStopped();
+    });
+
+    return res;
+  }
+
+  std::string GetRepr() const noexcept override {
+    return Repr::create("ShardedExecutor")
+        .field("name", name_)
+        .field("shard_count", shards_.size())
+        .field("threads_per_shard", threads_per_shard_)
+        .field("pinned", !cpus_.empty())
+        .field("steal_threshold", steal_threshold_)
+        .end();
+  }
+
+ private:
+  bool IsStealing() const noexcept {
+    auto res = steal_threshold_ != std::numeric_limits<size_t>::max();
+    return res;
+  }
+
+  /// Workers keep the tasks they submit on their own shard.
+  size_t DefaultShard() noexcept {
+    if (current_worker.owner == this) {
+      return current_worker.shard;
+    }
+
+    auto res =
+        next_shard_.fetch_add(1, std::memory_order_relaxed) % shards_.size();
+    return res;
+  }
+
+  void Push(const size_t index, ExecutorTask task) noexcept {
+    auto& shard = *shards_[index];
+    size_t depth = 0;
+    {
+      const absl::MutexLock lock(&shard.mutex);
+      shard.tasks.push_back(QueuedTask{
+          .task = std::move(task),
+          .enqueued_at = internal_executor::NowNanos()});
+      ++shard.submitted;
+      depth = shard.tasks.size();
+      shard.depth.store(depth);
+      shard.cond_var.Signal();
+    }
+
+    if (ABSL_PREDICT_FALSE(depth >= steal_threshold_)) {
+      RequestThief(index);
+    }
+  }
+
+  /// Wakes an idle worker of another shard to take some of the load of
+  /// `index`. Pairs with `Wait`: the depth is stored before `idle` is read
+  /// here and the other way round there, so either we see the idle worker or
+  /// it sees the depth.
+  void RequestThief(const size_t index) noexcept {
+    for (size_t i = 1; i < shards_.size(); ++i) {
+      auto& shard = *shards_[(index + i) % shards_.size()];
+      if (shard.idle.load() > 0) {
+        const absl::MutexLock lock(&shard.mutex);
+        shard.steal_requested = true;
+        shard.cond_var.Signal();
+        return;
+      }
+    }
+  }
+
+  /// A thief only takes a task if the shard is still over the threshold.
+  bool TryPop(const size_t index, const bool steal, QueuedTask& task) {
+    auto& shard = *shards_[index];
+    const absl::MutexLock lock(&shard.mutex);
+    if (shard.tasks.size() < (steal ? steal_threshold_ : 1)) {
+      return false;
+    }
+
+    task = std::move(shard.tasks.front());
+    shard.tasks.pop_front();
+    shard.depth.store(shard.tasks.size());
+    const auto now = internal_executor::NowNanos();
+    shard.queue_wait.Add(now > task.enqueued_at ? now - task.enqueued_at : 0);
+    if (steal) {
+      ++shard.stolen;
+    }
+
+    return true;
+  }
+
+  /// Returns the shard the task was taken from.
+  std::optional<size_t> TrySteal(const size_t index, QueuedTask& task) {
+    if (!IsStealing()) {
+      return std::nullopt;
+    }
+
+    for (size_t i = 1; i < shards_.size(); ++i) {
+      const auto victim = (index + i) % shards_.size();
+      if (shards_[victim]->depth.load() >= steal_threshold_ &&
+          TryPop(victim, true, task)) {
+        return victim;
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  bool HasStealable(const size_t index) const noexcept {
+    if (!IsStealing()) {
+      return false;
+    }
+
+    for (size_t i = 1; i < shards_.size(); ++i) {
+      if (shards_[(index + i) % shards_.size()]->depth.load() >=
+          steal_threshold_) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /// Returns `false` once the executor stops and the shard is drained.
+  bool Wait(const size_t index) {
+    auto& shard = *shards_[index];
+    const absl::MutexLock lock(&shard.mutex);
+    shard.idle.fetch_add(1);
+    bool res = true;
+    for (;;) {
+      if (!shard.tasks.empty()) {
+        break;
+      }
+
+      if (IsStoppingOrStopped()) {
+        res = false;
+        break;
+      }
+
+      if (shard.steal_requested || HasStealable(index)) {
+        shard.steal_requested = false;
+        break;
+      }
+
+      shard.cond_var.Wait(&shard.mutex);
+    }
+    shard.idle.fetch_sub(1);
+
+    return res;
+  }
+
+  void Run(const size_t index, ExecutorTask task) noexcept {
+    auto& shard = *shards_[index];
+    try {
+      std::move(task)();
+    } catch (...) {
+      shard.failed.fetch_add(1, std::memory_order_relaxed);
+      auto eptr = std::current_exception();
+      std::string message;
+      try {
+        std::rethrow_exception(eptr);
+      } catch (const std::exception& exc) {
+        message = exc.what();
+      }
+
+      LOG(ERROR) << *this << "; what() = " << message;
+    }
+    shard.completed.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void WorkerTask(const size_t index, const size_t worker) {
+    internal_executor::SetCurrentThreadName(
+        name_ + ":" + std::to_string(index) + "." + std::to_string(worker));
+    if (!cpus_.empty()) {
+      const auto cpu = cpus_[(index * threads_per_shard_ + worker) %
+                             cpus_.size()];
+      if (!internal_executor::PinCurrentThread(std::span(&cpu, 1))) {
+        LOG(WARNING) << *this << "; failed to pin worker " << index << "."
+                     << worker;
+      }
+    }
+
+    current_worker = {.owner = this, .shard = index};
+    const internal_executor::ScopedCurrentExecutor current_executor(owner_);
+    const internal_executor::ScopedCurrentExecutor current_shard(
+        &shards_[index]->executor);
+
+    for (;;) {
+      QueuedTask task;
+      if (TryPop(index, false, task)) {
+        Run(index, std::move(task.task));
+        continue;
+      }
+
+      if (const auto victim = TrySteal(index, task); victim.has_value()) {
+        Run(*victim, std::move(task.task));
+        continue;
+      }
+
+      if (!Wait(index)) {
+        break;
+      }
+    }
+
+    current_worker = {};
+  }
+
+ private:
+  // The public executor, for `IsCurrentThreadIn`.
+  const IExecutor* const owner_;
+  const std::string name_;
+  const size_t threads_per_shard_;
+  const std::vector<size_t> cpus_;
+  // `size_t` max when stealing is off.
+  const size_t steal_threshold_;
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<size_t> next_shard_ = 0;
+  std::vector<std::future<void>> workers_;
+};
+
+ShardedExecutor::ShardedExecutor(NotPubliclyConstructible /*npc*/,
+                                 const ShardedExecutorParams& params)
+    : i_(std::make_unique<Impl>(this, params)) {}
+
+ShardedExecutor::~ShardedExecutor() = default;
+
+std::unique_ptr<ShardedExecutor> ShardedExecutor::create(
+    const ShardedExecutorParams& params) {
+  auto res =
+      std::make_unique<ShardedExecutor>(NotPubliclyConstructible(), params);
+  return res;
+}
+
+void ShardedExecutor::Add(absl::AnyInvocable<void() &&> task) noexcept {
+  i_->Add(std::move(task));
+}
+
+bool ShardedExecutor::TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept {
+  auto res = i_->TryAdd(std::move(task));
+  return res;
+}
+
+void ShardedExecutor::AddTask(ExecutorTask task,
+                              const TaskOptions& options) noexcept {
+  i_->AddTask(std::move(task), options);
+}
+
+size_t ShardedExecutor::GetShardCount() const noexcept {
+  auto res = i_->GetShardCount();
+  return res;
+}
+
+IExecutor& ShardedExecutor::GetShard(const size_t index) noexcept {
+  auto& res = i_->GetShard(index);
+  return res;
+}
+
+std::vector<ShardStats> ShardedExecutor::GetStats() const noexcept {
+  auto res = i_->GetStats();
+  return res;
+}
+
+std::future<void> ShardedExecutor::stop() {
+  auto res = i_->stop();
+  return res;
+}
+
+}  // namespace handbag::executor
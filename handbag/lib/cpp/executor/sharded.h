@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/functional/any_invocable.h"
+#include "absl/hash/hash.h"
+#include "lib/cpp/executor/executor.h"
+#include "lib/cpp/executor/stats.h"
+#include "lib/cpp/start_stop/start_stop.h"
+
+namespace handbag::executor {
+
+struct ShardedExecutorParams {
+  /// Also names the worker threads ("<name>:<shard>.<worker>").
+  std::optional<std::string> name = {};
+  /// Defaults to the number of CPUs the process may run on.
+  std::optional<size_t> shard_count = {};
+  /// Workers sharing the queue of a shard. Defaults to 1.
+  std::optional<size_t> threads_per_shard = {};
+  /// Workers are pinned to these CPUs one by one, in order, so the workers of
+  /// a shard get neighbouring CPUs. Not pinned unless set.
+  std::optional<std::vector<size_t>> cpus = {};
+  /// Overflow stealing: idle workers take tasks from other shards that have
+  /// at least this many queued. A stolen task runs away from its shard's
+  /// cache, so stealing is off unless set.
+  std::optional<size_t> steal_threshold = {};
+};
+
+/// Counters are cumulative since the executor was created.
+struct ShardStats {
+  uint64_t submitted = 0;
+  /// Tasks of the shard that finished running, including the `failed` ones
+  /// and the ones stolen by other shards.
+  uint64_t completed = 0;
+  uint64_t failed = 0;
+  /// Tasks taken by the workers of other shards.
+  uint64_t stolen = 0;
+  /// Tasks submitted but not yet picked by a worker.
+  uint64_t queue_depth = 0;
+  size_t idle_thread_count = 0;
+  /// Time from submission until a worker picked the task.
+  DurationHistogram queue_wait;
+};
+
+/// Runs every task on the workers of a single shard, chosen by a key: tasks
+/// for the same key (e.g. a tenant) always run on the same worker, or worker
+/// group, so its data stays in that worker's cache. Every shard has its own
+/// FIFO queue.
+///
+/// Queues are unbounded: `TryAdd` always succeeds. Task options are ignored,
+/// except for cancellation. Tasks added without a key go round-robin, or to
+/// the caller's shard when added from a worker.
+class ShardedExecutor final : public IExecutor, public start_stop::IStoppable {
+  class NotPubliclyConstructible {};
+
+ public:
+  ShardedExecutor() = delete;
+  ShardedExecutor(const ShardedExecutor&) = delete;
+  ShardedExecutor(ShardedExecutor&&) = delete;
+  ShardedExecutor& operator=(const ShardedExecutor&) = delete;
+  ShardedExecutor& operator=(ShardedExecutor&&) = delete;
+
+  ShardedExecutor(NotPubliclyConstructible /*npc*/,
+                  const ShardedExecutorParams& params);
+  ~ShardedExecutor() override;
+
+  static std::unique_ptr<ShardedExecutor> create(
+      const ShardedExecutorParams& params = {});
+
+  void Add(absl::AnyInvocable<void() &&> task) noexcept override;
+  bool TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept override;
+  void AddTask(ExecutorTask task, const TaskOptions& options) noexcept override;
+
+  size_t GetShardCount() const noexcept;
+
+  /// The shard as an executor of its own, for everything that takes an
+  /// `IExecutor`: `AddTo` with options, `AddDetachedTo`, a strand, etc.
+  IExecutor& GetShard(size_t index) noexcept;
+
+  /// Shard of `key`, by `absl::Hash`.
+  template <typename Key>
+  IExecutor& GetShardFor(const Key& key) noexcept;
+
+  /// One entry per shard. Locks every shard for a moment.
+  std::vector<ShardStats> GetStats() const noexcept;
+
+  std::future<void> stop() override;
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> i_;
+};
+
+/// Impl
+
+template <typename Key>
+IExecutor& ShardedExecutor::GetShardFor(const Key& key) noexcept {
+  auto& res = GetShard(absl::HashOf(key) % GetShardCount());
+  return res;
+}
+
+}  // namespace handbag::executor
+
+namespace handbag {
+
+/// Runs `invocable(args...)` on the shard of `key`.
+template <typename Key, typename Invocable, typename... Args>
+Future<internal_executor::TaskResult<Invocable, Args...>> AddTo(
+    executor::ShardedExecutor& executor, const Key& key, Invocable&& invocable,
+    Args&&... args) {
+  auto res = AddTo(executor.GetShardFor(key),
+                   std::forward<Invocable>(invocable),
+                   std::forward<Args>(args)...);
+  return res;
+}
+
+}  // namespace handbag
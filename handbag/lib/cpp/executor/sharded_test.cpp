@@ -0,0 +1,146 @@
+#include "lib/cpp/executor/sharded.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/synchronization/notification.h"
+
+using namespace ::testing;
+
+namespace handbag::executor::tests {
+namespace {
+
+TEST(ShardedExecutorTest, RunsTasks) {
+  auto executor = ShardedExecutor::create({.shard_count = 4});
+  ASSERT_THAT(executor->GetShardCount(), Eq(4));
+
+  std::vector<Future<int>> results;
+  for (int i = 0; i < 1000; ++i) {
+    results.push_back(AddTo(*executor, [i] { return i * 2; }));
+  }
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_THAT(results[i].Get(), Eq(i * 2));
+  }
+
+  executor->stop().get();
+  uint64_t submitted = 0;
+  uint64_t completed = 0;
+  for (const auto& stats : executor->GetStats()) {
+    // Round-robin.
+    EXPECT_THAT(stats.submitted, Eq(250));
+    submitted += stats.submitted;
+    completed += stats.completed;
+  }
+  EXPECT_THAT(submitted, Eq(1000));
+  EXPECT_THAT(completed, Eq(1000));
+}
+
+TEST(ShardedExecutorTest, SameKeySameThread) {
+  auto executor =
+      ShardedExecutor::create({.shard_count = 4, .threads_per_shard = 1});
+
+  for (int key = 0; key < 100; ++key) {
+    const auto name = "tenant" + std::to_string(key);
+    auto first =
+        AddTo(*executor, name, [] { return std::this_thread::get_id(); });
+    auto second =
+        AddTo(*executor, name, [] { return std::this_thread::get_id(); });
+    EXPECT_THAT(first.Get(), Eq(second.Get()));
+
+    auto& shard = executor->GetShardFor(name);
+    EXPECT_TRUE(AddTo(*executor, name, [&] {
+                  return IsCurrentThreadIn(shard) &&
+                         IsCurrentThreadIn(*executor);
+                }).Get());
+  }
+
+  executor->stop().get();
+}
+
+TEST(ShardedExecutorTest, TasksFromWorkersStayOnTheirShard) {
+  auto executor = ShardedExecutor::create({.shard_count = 4});
+
+  std::atomic<bool> same_shard = false;
+  absl::Notification done;
+  executor->GetShard(2).Add([&] {
+    executor->Add([&] {
+      same_shard = IsCurrentThreadIn(executor->GetShard(2));
+      done.Notify();
+    });
+  });
+  done.WaitForNotification();
+  EXPECT_TRUE(same_shard.load());
+
+  executor->stop().get();
+}
+
+TEST(ShardedExecutorTest, NoStealingByDefault) {
+  auto executor = ShardedExecutor::create({.shard_count = 2});
+
+  absl::Notification started;
+  absl::Notification release;
+  executor->GetShard(0).Add([&] {
+    started.Notify();
+    release.WaitForNotification();
+  });
+  started.WaitForNotification();
+
+  auto result = AddTo(executor->GetShard(0), [] { return 1; });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_FALSE(result.IsReady());
+  EXPECT_THAT(executor->GetStats()[0].queue_depth, Eq(1));
+
+  release.Notify();
+  EXPECT_THAT(result.Get(), Eq(1));
+  executor->stop().get();
+}
+
+TEST(ShardedExecutorTest, StealsFromHotShard) {
+  auto executor =
+      ShardedExecutor::create({.shard_count = 2, .steal_threshold = 2});
+
+  absl::Notification started;
+  absl::Notification release;
+  executor->GetShard(0).Add([&] {
+    started.Notify();
+    release.WaitForNotification();
+  });
+  started.WaitForNotification();
+
+  // Shard 0 is stuck, shard 1 takes its tasks while there are at least two.
+  std::vector<Future<int>> results;
+  for (int i = 0; i < 10; ++i) {
+    results.push_back(AddTo(executor->GetShard(0), [i] { return i; }));
+  }
+  for (int i = 0; i < 9; ++i) {
+    EXPECT_THAT(results[i].Get(), Eq(i));
+  }
+  EXPECT_FALSE(results[9].IsReady());
+
+  const auto stats = executor->GetStats();
+  EXPECT_THAT(stats[0].stolen, Eq(9));
+  EXPECT_THAT(stats[0].queue_depth, Eq(1));
+
+  release.Notify();
+  EXPECT_THAT(results[9].Get(), Eq(9));
+  executor->stop().get();
+}
+
+TEST(ShardedExecutorTest, ExceptionsAreCounted) {
+  auto executor = ShardedExecutor::create({.shard_count = 1});
+
+  executor->Add([] { throw std::runtime_error("boom"); });
+  executor->stop().get();
+  EXPECT_THAT(executor->GetStats()[0].failed, Eq(1));
+}
+
+}  // namespace
+}  // namespace handbag::executor::tests
@@ -0,0 +1,88 @@
+#include "lib/cpp/executor/stats.h"
+
+#include <bit>
+
+#include "lib/cpp/repr/repr.h"
+
+namespace handbag::executor {
+
+size_t DurationHistogram::BucketIndex(const uint64_t nanos) noexcept {
+  const auto res = static_cast<size_t>(std::bit_width(nanos));
+  return res < kBucketCount ? res : kBucketCount - 1;
+}
+
+DurationHistogram::DurationHistogram(
+    const std::array<uint64_t, kBucketCount>& buckets,
+    const uint64_t sum_nanos) noexcept
+    : buckets_(buckets), sum_nanos_(sum_nanos) {
+  for (const auto count : buckets_) {
+    count_ += count;
+  }
+}
+
+void DurationHistogram::Add(const uint64_t nanos) noexcept {
+  ++buckets_[BucketIndex(nanos)];
+  ++count_;
+  sum_nanos_ += nanos;
+}
+
+void DurationHistogram::Merge(const DurationHistogram& other) noexcept {
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    buckets_[i] += other.buckets_[i];
+  }
+  count_ += other.count_;
+  sum_nanos_ += other.sum_nanos_;
+}
+
+absl::Duration DurationHistogram::sum() const noexcept {
+  auto res = absl::Nanoseconds(sum_nanos_);
+  return res;
+}
+
+absl::Duration DurationHistogram::Mean() const noexcept {
+  if (count_ == 0) {
+    return absl::ZeroDuration();
+  }
+
+  auto res = absl::Nanoseconds(sum_nanos_ / count_);
+  return res;
+}
+
+absl::Duration DurationHistogram::Percentile(
+    const double quantile) const noexcept {
+  if (count_ == 0) {
+    return absl::ZeroDuration();
+  }
+
+  const auto rank = static_cast<uint64_t>(quantile * (count_ - 1)) + 1;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      return absl::Nanoseconds(uint64_t{1} << i);
+    }
+  }
+
+  return absl::InfiniteDuration();
+}
+
+std::ostream& operator<<(std::ostream& out, const DurationHistogram& value) {
+  return out << Repr::create("DurationHistogram")
+                    .field("count", value.count())
+                    .field("mean", value.Mean())
+                    .field("p50", value.Percentile(0.5))
+                    .field("p99", value.Percentile(0.99))
+                    .field("max", value.Percentile(1.0))
+                    .end();
+}
+
+std::ostream& operator<<(std::ostream& out, const TaskLabelStats& value) {
+  return out << Repr::create("TaskLabelStats")
+                    .field("label", value.label)
+                    .field("count", value.count)
+                    .field("wall_time", value.wall_time)
+                    .field("cpu_time", value.cpu_time)
+                    .end();
+}
+
+}  // namespace handbag::executor
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "absl/time/time.h"
+
+namespace handbag::executor {
+
+/// Distribution of durations in log2 buckets: bucket `i` counts durations
+/// in [2^(i-1), 2^i) nanoseconds, the last one everything above.
+class DurationHistogram {
+ public:
+  static constexpr size_t kBucketCount = 48;
+
+  static size_t BucketIndex(uint64_t nanos) noexcept;
+
+  DurationHistogram() = default;
+  DurationHistogram(const std::array<uint64_t, kBucketCount>& buckets,
+                    uint64_t sum_nanos) noexcept;
+
+  void Add(uint64_t nanos) noexcept;
+  void Merge(const DurationHistogram& other) noexcept;
+
+  uint64_t count() const noexcept { return count_; }
+  absl::Duration sum() const noexcept;
+  absl::Duration Mean() const noexcept;
+
+  /// Upper bound of the bucket containing the `quantile` (in [0, 1]).
+  absl::Duration Percentile(double quantile) const noexcept;
+
+  const std::array<uint64_t, kBucketCount>& buckets() const noexcept {
+    return buckets_;
+  }
+
+ private:
+  std::array<uint64_t, kBucketCount> buckets_ = {};
+  uint64_t count_ = 0;
+  uint64_t sum_nanos_ = 0;
+};
+
+std::ostream& operator<<(std::ostream& out, const DurationHistogram& value);
+
+/// Tasks that ran with the same `TaskOptions::label`.
+struct TaskLabelStats {
+  std::string label;
+  uint64_t count = 0;
+  absl::Duration wall_time = {};
+  /// CPU time of the worker thread while running the tasks, less than
+  /// `wall_time` for tasks that block or get preempted.
+  absl::Duration cpu_time = {};
+};
+
+std::ostream& operator<<(std::ostream& out, const TaskLabelStats& value);
+
+}  // namespace handbag::executor
@@ -0,0 +1,122 @@
+#include "lib/cpp/executor/stats.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "lib/cpp/executor/internal/stats.h"
+
+using namespace ::testing;
+
+namespace handbag::executor::tests {
+namespace {
+
+TEST(DurationHistogramTest, Empty) {
+  const DurationHistogram histogram;
+  EXPECT_THAT(histogram.count(), Eq(0));
+  EXPECT_THAT(histogram.Mean(), Eq(absl::ZeroDuration()));
+  EXPECT_THAT(histogram.Percentile(0.5), Eq(absl::ZeroDuration()));
+}
+
+TEST(DurationHistogramTest, Buckets) {
+  EXPECT_THAT(DurationHistogram::BucketIndex(0), Eq(0));
+  EXPECT_THAT(DurationHistogram::BucketIndex(1), Eq(1));
+  EXPECT_THAT(DurationHistogram::BucketIndex(2), Eq(2));
+  EXPECT_THAT(DurationHistogram::BucketIndex(3), Eq(2));
+  EXPECT_THAT(DurationHistogram::BucketIndex(1024), Eq(11));
+  EXPECT_THAT(DurationHistogram::BucketIndex(~uint64_t{0}),
+              Eq(DurationHistogram::kBucketCount - 1));
+}
+
+TEST(DurationHistogramTest, Percentiles) {
+  DurationHistogram histogram;
+  for (int i = 0; i < 99; ++i) {
+    histogram.Add(100);
+  }
+  histogram.Add(1'000'000);
+
+  EXPECT_THAT(histogram.count(), Eq(100));
+  EXPECT_THAT(histogram.sum(), Eq(absl::Nanoseconds(99 * 100 + 1'000'000)));
+  EXPECT_THAT(histogram.Percentile(0.5), Eq(absl::Nanoseconds(128)));
+  EXPECT_THAT(histogram.Percentile(0.98), Eq(absl::Nanoseconds(128)));
+  EXPECT_THAT(histogram.Percentile(1.0), Eq(absl::Nanoseconds(1 << 20)));
+}
+
+TEST(DurationHistogramTest, Merge) {
+  DurationHistogram lhs;
+  lhs.Add(10);
+  DurationHistogram rhs;
+  rhs.Add(30);
+  lhs.Merge(rhs);
+
+  EXPECT_THAT(lhs.count(), Eq(2));
+  EXPECT_THAT(lhs.Mean(), Eq(absl::Nanoseconds(20)));
+
+  std::ostringstream out;
+  out << lhs;
+  EXPECT_THAT(out.str(), StartsWith("DurationHistogram(count=2"));
+}
+
+TEST(OwnedLabelTableTest, CollectsByLabelText) {
+  internal_executor::OwnedLabelTable first;
+  first.Add("parse", 10, 5);
+  first.Add("parse", 20, 5);
+  first.Add("compress", 100, 90);
+  internal_executor::OwnedLabelTable second;
+  // Same text at another address.
+  const std::string parse = "parse";
+  second.Add(parse, 30, 10);
+
+  std::vector<TaskLabelStats> stats;
+  first.CollectInto(stats);
+  second.CollectInto(stats);
+  EXPECT_THAT(
+      stats,
+      UnorderedElementsAre(
+          AllOf(Field(&TaskLabelStats::label, Eq("parse")),
+                Field(&TaskLabelStats::count, Eq(3)),
+                Field(&TaskLabelStats::wall_time, Eq(absl::Nanoseconds(60))),
+                Field(&TaskLabelStats::cpu_time, Eq(absl::Nanoseconds(20)))),
+          AllOf(Field(&TaskLabelStats::label, Eq("compress")),
+                Field(&TaskLabelStats::count, Eq(1)))));
+}
+
+TEST(OwnedLabelTableTest, Overflow) {
+  internal_executor::OwnedLabelTable table;
+  std::vector<std::string> labels;
+  labels.reserve(internal_executor::OwnedLabelTable::kCapacity + 10);
+  for (size_t i = 0; i < labels.capacity(); ++i) {
+    labels.push_back("label" + std::to_string(i));
+    table.Add(labels.back(), 1, 1);
+  }
+
+  std::vector<TaskLabelStats> stats;
+  table.CollectInto(stats);
+  ASSERT_THAT(stats.size(), Eq(internal_executor::OwnedLabelTable::kCapacity));
+  uint64_t count = 0;
+  for (const auto& entry : stats) {
+    count += entry.count;
+  }
+  EXPECT_THAT(count, Eq(labels.size()));
+  EXPECT_THAT(stats,
+              Contains(AllOf(
+                  Field(&TaskLabelStats::label,
+                        Eq(internal_executor::OwnedLabelTable::kOtherLabel)),
+                  Field(&TaskLabelStats::count, Eq(11)))));
+}
+
+TEST(ThreadCpuNanosTest, CountsCpuTime) {
+  const auto started_at = internal_executor::ThreadCpuNanos();
+  volatile uint64_t sink = 0;
+  for (uint64_t i = 0; i < 10'000'000; ++i) {
+    sink = sink + i;
+  }
+  EXPECT_THAT(internal_executor::ThreadCpuNanos(), Gt(started_at));
+}
+
+}  // namespace
+}  // namespace handbag::executor::tests
@@ -0,0 +1,517 @@
+#include "lib/cpp/executor/timer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/log/log.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "lib/cpp/executor/internal/timing_wheel.h"
+#include "lib/cpp/repr/repr.h"
+#include "lib/cpp/start_stop/state.h"
+
+namespace handbag::internal_executor {
+
+/// Owned by the wheel while pending or running, and by its handle.
+class TimerEntry : public TimingWheelNode {
+ public:
+  enum class EState { Pending, Running, Done, Cancelled };
+
+  void Ref() noexcept { refs_.fetch_add(1, std::memory_order_relaxed); }
+
+  void Unref() noexcept {
+    if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+
+  // Guarded by the executor's mutex.
+  EState state = EState::Pending;
+  absl::Duration period = absl::ZeroDuration();
+  absl::AnyInvocable<void() &&> once;
+  absl::AnyInvocable<void()> repeated;
+
+ private:
+  std::atomic<uint32_t> refs_ = 1;
+};
+
+}  // namespace handbag::internal_executor
+
+namespace handbag::executor {
+
+namespace {
+using internal_executor::TimerEntry;
+using Task = absl::AnyInvocable<void() &&>;
+
+constexpr absl::Duration kDefaultTick = absl::Milliseconds(1);
+
+struct Params {
+  std::string name;
+  absl::Duration tick;
+};
+}  // namespace
+
+class TimerExecutor::Impl final : public IExecutor,
+                                  public start_stop::IStoppable,
+                                  public IRepr,
+                                  public start_stop::StoppableState {
+  /// Hands a periodic timer back to the wheel once its run is over, or once
+  /// the target executor dropped it without running.
+  class PeriodicRun {
+   public:
+    PeriodicRun(Impl* const impl, TimerEntry* const entry) noexcept
+        : impl_(impl), entry_(entry) {}
+    PeriodicRun(PeriodicRun&& other) noexcept
+        : impl_(std::exchange(other.impl_, nullptr)), entry_(other.entry_) {}
+    PeriodicRun& operator=(PeriodicRun&&) = delete;
+    ~PeriodicRun() {
+      if (impl_ != nullptr) {
+        impl_->Rearm(entry_);
+      }
+    }
+
+    void operator()() { entry_->repeated(); }
+
+   private:
+    Impl* impl_;
+    TimerEntry* entry_;
+  };
+
+ public:
+  Impl(IExecutor& target, const TimerExecutorParams& params)
+      : params_{.name = params.name.has_value() ? params.name.value()
+                                                : "TimerExec",
+                .tick = params.tick > absl::ZeroDuration()
+                            ? params.tick.value()
+                            : kDefaultTick},
+        target_(target),
+        origin_(absl::Now()),
+        wheel_(0) {
+    thread_ = std::async(std::launch::async, &Impl::TimerTask, this);
+  }
+
+  void Add(absl::AnyInvocable<void() &&> task) noexcept override {
+    target_.Add(std::move(task));
+  }
+
+  bool TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept override {
+    auto res = target_.TryAdd(std::move(task));
+    return res;
+  }
+
+  void Add(absl::AnyInvocable<void() &&> task,
+           const TaskOptions& options) noexcept override {
+    target_.Add(std::move(task), options);
+  }
+
+  bool TryAdd(absl::AnyInvocable<void() &&>&& task,
+              const TaskOptions& options) noexcept override {
+    auto res = target_.TryAdd(std::move(task), options);
+    return res;
+  }
+
+  void AddTask(ExecutorTask task,
+               const TaskOptions& options) noexcept override {
+    target_.AddTask(std::move(task), options);
+  }
+
+  void AddBatch(
+      std::span<absl::AnyInvocable<void() &&>> tasks) noexcept override {
+    target_.AddBatch(tasks);
+  }
+
+  size_t TryAddBatch(
+      std::span<absl::AnyInvocable<void() &&>> tasks) noexcept override {
+    auto res = target_.TryAddBatch(tasks);
+    return res;
+  }
+
+  bool TryAddTask(ExecutorTask&& task,
+                  const TaskOptions& options) noexcept override {
+    auto res = target_.TryAddTask(std::move(task), options);
+    return res;
+  }
+
+  void AddTaskBatch(std::span<ExecutorTask> tasks) noexcept override {
+    target_.AddTaskBatch(tasks);
+  }
+
+  size_t TryAddTaskBatch(std::span<ExecutorTask> tasks) noexcept override {
+    auto res = target_.TryAddTaskBatch(tasks);
+    return res;
+  }
+
+  Future<void> WhenHasCapacity(const TaskOptions& options) noexcept override {
+    auto res = target_.WhenHasCapacity(options);
+    return res;
+  }
+
+  /// Returns the entry with a reference for the handle.
+  TimerEntry* Schedule(const absl::Time time,
+                       absl::AnyInvocable<void() &&> task) noexcept {
+    auto* const res = new TimerEntry();
+    res->once = std::move(task);
+    Schedule(res, time);
+    return res;
+  }
+
+  TimerEntry* SchedulePeriodic(const absl::Duration period,
+                               absl::AnyInvocable<void()> task) noexcept {
+    auto* const res = new TimerEntry();
+    // A zero period would make the timer fire in a loop.
+    res->period = std::max(period, params_.tick);
+    res->repeated = std::move(task);
+    Schedule(res, absl::Now() + res->period);
+    return res;
+  }
+
+  bool Cancel(TimerEntry* const entry) noexcept {
+    const absl::MutexLock lock(&mutex_);
+    switch (entry->state) {
+      case TimerEntry::EState::Pending:
+        entry->state = TimerEntry::EState::Cancelled;
+        if (entry->linked) {
+          wheel_.Remove(entry);
+          entry->Unref();
+        }
+        return true;
+      case TimerEntry::EState::Running:
+        // `Rearm` releases the wheel's reference.
+        entry->state = TimerEntry::EState::Cancelled;
+        return true;
+      case TimerEntry::EState::Done:
+      case TimerEntry::EState::Cancelled:
+        return false;
+    }
+
+    return false;
+  }
+
+  std::future<void> stop() override {
+    {
+      const absl::MutexLock lock(&mutex_);
+      SetStopping();
+      wake_.Signal();
+    }
+
+    auto res = std::async(std::launch::async, [this]() noexcept {
+      try {
+        thread_.get();
+      } catch (const std::exception& exc) {
+        LOG(ERROR) << *this << "; what() = " << exc.what();
+      }
+
+      std::vector<internal_executor::TimingWheelNode*> dropped;
+      {
+        const absl::MutexLock lock(&mutex_);
+        wheel_.Advance(std::numeric_limits<uint64_t>::max(), dropped);
+        for (auto* const node : dropped) {
+          static_cast<TimerEntry*>(node)->state =
+              TimerEntry::EState::Cancelled;
+        }
+
+        mutex_.Await(absl::Condition(this, &Impl::NothingInFlight));
+      }
+
+      // Tasks are destroyed outside of the lock, they may cancel timers.
+      for (auto* const node : dropped) {
+        static_cast<TimerEntry*>(node)->Unref();
+      }
+
+      SetStopped();
+    });
+
+    return res;
+  }
+
+  std::string GetRepr() const noexcept override {
+    const absl::MutexLock lock(&mutex_);
+    return Repr::create("TimerExecutor")
+        .field("name", params_.name)
+        .field("tick", params_.tick)
+        .field("pending", wheel_.size())
+        .field("in_flight", in_flight_)
+        .end();
+  }
+
+ private:
+  uint64_t TickOf(const absl::Time time, const bool round_up) const noexcept {
+    if (time <= origin_) {
+      return 0;
+    }
+
+    // Saturates for far away times, so does the division.
+    const auto nanos = absl::ToInt64Nanoseconds(time - origin_);
+    const auto tick = absl::ToInt64Nanoseconds(params_.tick);
+    auto res = static_cast<uint64_t>(nanos / tick);
+    if (round_up && nanos % tick != 0) {
+      ++res;
+    }
+    return res;
+  }
+
+  void Schedule(TimerEntry* const entry, const absl::Time time) noexcept {
+    Task due;
+    {
+      const absl::MutexLock lock(&mutex_);
+      if (IsStoppingOrStopped()) {
+        entry->state = TimerEntry::EState::Cancelled;
+        return;
+      }
+
+      const auto expiry = TickOf(time, true);
+      if (wheel_.Insert(entry, expiry)) {
+        entry->Ref();
+        if (expiry < next_event_) {
+          wake_.Signal();
+        }
+        return;
+      }
+
+      // Periodic timers are always in the future.
+      due = std::move(entry->once);
+      entry->state = TimerEntry::EState::Done;
+    }
+
+    target_.Add(std::move(due));
+  }
+
+  void Rearm(TimerEntry* const entry) noexcept {
+    {
+      const absl::MutexLock lock(&mutex_);
+      --in_flight_;
+      if (entry->state != TimerEntry::EState::Cancelled &&
+          IsNotStoppingOrStopped()) {
+        entry->state = TimerEntry::EState::Pending;
+        const auto expiry = std::max(
+            TickOf(absl::Now() + entry->period, true), wheel_.now() + 1);
+        wheel_.Insert(entry, expiry);
+        if (expiry < next_event_) {
+          wake_.Signal();
+        }
+        return;
+      }
+
+      entry->state = TimerEntry::EState::Cancelled;
+    }
+
+    // The task is destroyed outside of the lock, it may cancel timers.
+    entry->Unref();
+  }
+
+  bool NothingInFlight() const noexcept ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    auto res = in_flight_ == 0;
+    return res;
+  }
+
+  void TimerTask() {
+    std::vector<internal_executor::TimingWheelNode*> expired;
+    std::vector<Task> due;
+    std::vector<TimerEntry*> periodic;
+    for (;;) {
+      {
+        const absl::MutexLock lock(&mutex_);
+        for (;;) {
+          if (IsStoppingOrStopped()) {
+            return;
+          }
+
+          wheel_.Advance(TickOf(absl::Now(), false), expired);
+          if (!expired.empty()) {
+            break;
+          }
+
+          const auto next = wheel_.NextEvent();
+          next_event_ = next.value_or(std::numeric_limits<uint64_t>::max());
+          const auto deadline =
+              next.has_value()
+                  ? origin_ + params_.tick * static_cast<int64_t>(*next)
+                  : absl::InfiniteFuture();
+          wake_.WaitWithDeadline(&mutex_, deadline);
+        }
+
+        next_event_ = 0;
+        for (auto* const node : expired) {
+          auto* const entry = static_cast<TimerEntry*>(node);
+          if (entry->period > absl::ZeroDuration()) {
+            // The wheel's reference goes to the `PeriodicRun`.
+            entry->state = TimerEntry::EState::Running;
+            ++in_flight_;
+            periodic.push_back(entry);
+          } else {
+            entry->state = TimerEntry::EState::Done;
+            due.push_back(std::move(entry->once));
+          }
+        }
+      }
+
+      for (auto* const node : expired) {
+        auto* const entry = static_cast<TimerEntry*>(node);
+        if (entry->period == absl::ZeroDuration()) {
+          entry->Unref();
+        }
+      }
+      expired.clear();
+
+      for (auto& task : due) {
+        target_.Add(std::move(task));
+      }
+      due.clear();
+
+      for (auto* const entry : periodic) {
+        target_.Add(PeriodicRun(this, entry));
+      }
+      periodic.clear();
+    }
+  }
+
+ private:
+  const Params params_;
+  IExecutor& target_;
+  const absl::Time origin_;
+
+  mutable absl::Mutex mutex_;
+  absl::CondVar wake_;
+  internal_executor::TimingWheel wheel_ ABSL_GUARDED_BY(mutex_);
+  // Tick the timer thread sleeps until; zero while it is awake.
+  uint64_t next_event_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Periodic timers handed over to the target executor.
+  size_t in_flight_ ABSL_GUARDED_BY(mutex_) = 0;
+
+  std::future<void> thread_;
+};
+
+TimerExecutor::TimerExecutor(NotPubliclyConstructible /*npc*/,
+                             IExecutor& target,
+                             const TimerExecutorParams& params)
+    : i_(std::make_unique<Impl>(target, params)) {}
+
+TimerExecutor::~TimerExecutor() = default;
+
+std::unique_ptr<TimerExecutor> TimerExecutor::create(
+    IExecutor& target, const TimerExecutorParams& params) {
+  auto res = std::make_unique<TimerExecutor>(NotPubliclyConstructible(),
+                                             target, params);
+  return res;
+}
+
+void TimerExecutor::Add(absl::AnyInvocable<void() &&> task) noexcept {
+  i_->Add(std::move(task));
+}
+
+bool TimerExecutor::TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept {
+  auto res = i_->TryAdd(std::move(task));
+  return res;
+}
+
+void TimerExecutor::Add(absl::AnyInvocable<void() &&> task,
+                        const TaskOptions& options) noexcept {
+  i_->Add(std::move(task), options);
+}
+
+bool TimerExecutor::TryAdd(absl::AnyInvocable<void() &&>&& task,
+                           const TaskOptions& options) noexcept {
+  auto res = i_->TryAdd(std::move(task), options);
+  return res;
+}
+
+void TimerExecutor::AddTask(ExecutorTask task,
+                            const TaskOptions& options) noexcept {
+  i_->AddTask(std::move(task), options);
+}
+
+void TimerExecutor::AddBatch(
+    std::span<absl::AnyInvocable<void() &&>> tasks) noexcept {
+  i_->AddBatch(tasks);
+}
+
+size_t TimerExecutor::TryAddBatch(
+    std::span<absl::AnyInvocable<void() &&>> tasks) noexcept {
+  auto res = i_->TryAddBatch(tasks);
+  return res;
+}
+
+bool TimerExecutor::TryAddTask(ExecutorTask&& task,
+                               const TaskOptions& options) noexcept {
+  auto res = i_->TryAddTask(std::move(task), options);
+  return res;
+}
+
+void TimerExecutor::AddTaskBatch(std::span<ExecutorTask> tasks) noexcept {
+  i_->AddTaskBatch(tasks);
+}
+
+size_t TimerExecutor::TryAddTaskBatch(std::span<ExecutorTask> tasks) noexcept {
+  auto res = i_->TryAddTaskBatch(tasks);
+  return res;
+}
+
+Future<void> TimerExecutor::WhenHasCapacity(
+    const TaskOptions& options) noexcept {
+  auto res = i_->WhenHasCapacity(options);
+  return res;
+}
+
+TimerHandle TimerExecutor::ScheduleAt(
+    const absl::Time time, absl::AnyInvocable<void() &&> task) noexcept {
+  TimerHandle res(i_.get(), i_->Schedule(time, std::move(task)));
+  return res;
+}
+
+TimerHandle TimerExecutor::ScheduleAfter(
+    const absl::Duration delay, absl::AnyInvocable<void() &&> task) noexcept {
+  auto res = ScheduleAt(absl::Now() + delay, std::move(task));
+  return res;
+}
+
+TimerHandle TimerExecutor::SchedulePeriodic(
+    const absl::Duration period, absl::AnyInvocable<void()> task) noexcept {
+  TimerHandle res(i_.get(), i_->SchedulePeriodic(period, std::move(task)));
+  return res;
+}
+
+std::future<void> TimerExecutor::stop() {
+  auto res = i_->stop();
+  return res;
+}
+
+TimerHandle::TimerHandle(TimerExecutor::Impl* const impl,
+                         internal_executor::TimerEntry* const entry) noexcept
+    : impl_(impl), entry_(entry) {}
+
+TimerHandle::TimerHandle(TimerHandle&& other) noexcept
+    : impl_(std::exchange(other.impl_, nullptr)),
+      entry_(std::exchange(other.entry_, nullptr)) {}
+
+TimerHandle& TimerHandle::operator=(TimerHandle&& other) noexcept {
+  if (this != &other) {
+    Reset();
+    impl_ = std::exchange(other.impl_, nullptr);
+    entry_ = std::exchange(other.entry_, nullptr);
+  }
+  return *this;
+}
+
+TimerHandle::~TimerHandle() { Reset(); }
+
+bool TimerHandle::Cancel() noexcept {
+  auto res = entry_ != nullptr && impl_->Cancel(entry_);
+  return res;
+}
+
+void TimerHandle::Reset() noexcept {
+  if (entry_ != nullptr) {
+    std::exchange(entry_, nullptr)->Unref();
+    impl_ = nullptr;
+  }
+}
+
+}  // namespace handbag::executor
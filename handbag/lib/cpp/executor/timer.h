@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+
+#include "absl/functional/any_invocable.h"
+#include "absl/time/time.h"
+#include "lib/cpp/executor/executor.h"
+#include "lib/cpp/start_stop/start_stop.h"
+
+namespace handbag::internal_executor {
+class TimerEntry;
+}  // namespace handbag::internal_executor
+
+namespace handbag::executor {
+
+struct TimerExecutorParams {
+  std::optional<std::string> name = {};
+  /// Resolution of the timers: they fire at most one tick late and never
+  /// early. Defaults to 1ms.
+  std::optional<absl::Duration> tick = {};
+};
+
+class TimerHandle;
+
+/// Runs tasks at a given time. Timers are kept in a hierarchical timing wheel,
+/// so scheduling and cancelling are O(1) and millions of pending timers are
+/// cheap; a single thread advances the wheel and hands the due tasks over to
+/// the target executor, which must outlive this one.
+///
+/// `Add` and `TryAdd` pass tasks over to the target right away.
+class TimerExecutor final : public IExecutor, public start_stop::IStoppable {
+  class NotPubliclyConstructible {};
+
+ public:
+  TimerExecutor() = delete;
+  TimerExecutor(const TimerExecutor&) = delete;
+  TimerExecutor(TimerExecutor&&) = delete;
+  TimerExecutor& operator=(const TimerExecutor&) = delete;
+  TimerExecutor& operator=(TimerExecutor&&) = delete;
+
+  TimerExecutor(NotPubliclyConstructible /*npc*/, IExecutor& target,
+                const TimerExecutorParams& params);
+  ~TimerExecutor() override;
+
+  static std::unique_ptr<TimerExecutor> create(
+      IExecutor& target, const TimerExecutorParams& params = {});
+
+  void Add(absl::AnyInvocable<void() &&> task) noexcept override;
+  bool TryAdd(absl::AnyInvocable<void() &&>&& task) noexcept override;
+  void Add(absl::AnyInvocable<void() &&> task,
+           const TaskOptions& options) noexcept override;
+  bool TryAdd(absl::AnyInvocable<void() &&>&& task,
+              const TaskOptions& options) noexcept override;
+  void AddTask(ExecutorTask task, const TaskOptions& options) noexcept override;
+  void AddBatch(
+      std::span<absl::AnyInvocable<void() &&>> tasks) noexcept override;
+  size_t TryAddBatch(
+      std::span<absl::AnyInvocable<void() &&>> tasks) noexcept override;
+  bool TryAddTask(ExecutorTask&& task,
+                  const TaskOptions& options) noexcept override;
+  void AddTaskBatch(std::span<ExecutorTask> tasks) noexcept override;
+  size_t TryAddTaskBatch(std::span<ExecutorTask> tasks) noexcept override;
+  Future<void> WhenHasCapacity(const TaskOptions& options) noexcept override;
+
+  TimerHandle ScheduleAt(absl::Time time,
+                         absl::AnyInvocable<void() &&> task) noexcept;
+  TimerHandle ScheduleAfter(absl::Duration delay,
+                            absl::AnyInvocable<void() &&> task) noexcept;
+
+  /// Runs `task` every `period`, the first time a `period` from now. The next
+  /// run is scheduled once the previous one has finished, so runs never
+  /// overlap and a slow run delays the following ones.
+  TimerHandle SchedulePeriodic(absl::Duration period,
+                               absl::AnyInvocable<void()> task) noexcept;
+
+  /// Pending timers are dropped. Completes once periodic tasks already handed
+  /// over to the target executor are done.
+  std::future<void> stop() override;
+
+ private:
+  friend class TimerHandle;
+
+  class Impl;
+  std::unique_ptr<Impl> i_;
+};
+
+/// Lets a scheduled task be cancelled. Dropping the handle doesn't cancel the
+/// task. Must not be used after its executor is destroyed.
+class TimerHandle {
+ public:
+  TimerHandle() = default;
+  TimerHandle(const TimerHandle&) = delete;
+  TimerHandle& operator=(const TimerHandle&) = delete;
+  TimerHandle(TimerHandle&& other) noexcept;
+  TimerHandle& operator=(TimerHandle&& other) noexcept;
+  ~TimerHandle();
+
+  bool IsValid() const noexcept { return entry_ != nullptr; }
+
+  /// Keeps the task from running (again); a periodic run that has already
+  /// started still completes. Returns `false` if the task already ran or was
+  /// cancelled before.
+  bool Cancel() noexcept;
+
+ private:
+  friend class TimerExecutor;
+
+  TimerHandle(TimerExecutor::Impl* impl,
+              internal_executor::TimerEntry* entry) noexcept;
+
+  void Reset() noexcept;
+
+ private:
+  TimerExecutor::Impl* impl_ = nullptr;
+  internal_executor::TimerEntry* entry_ = nullptr;
+};
+
+}  // namespace handbag::executor
@@ -0,0 +1,135 @@
+#include "lib/cpp/executor/timer.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "lib/cpp/executor/cpu.h"
+
+using namespace ::testing;
+
+namespace handbag::executor::tests {
+namespace {
+
+class TimerExecutorTest : public Test {
+ protected:
+  void TearDown() override {
+    timer_->stop().get();
+    cpu_->stop().get();
+  }
+
+  std::unique_ptr<CpuExecutor> cpu_ = CpuExecutor::create({.thread_count = 2});
+  std::unique_ptr<TimerExecutor> timer_ = TimerExecutor::create(*cpu_, {});
+};
+
+TEST_F(TimerExecutorTest, ScheduleAfter) {
+  absl::Notification fired;
+  absl::Time fired_at;
+  const auto start = absl::Now();
+  timer_->ScheduleAfter(absl::Milliseconds(30), [&] {
+    fired_at = absl::Now();
+    fired.Notify();
+  });
+
+  fired.WaitForNotification();
+  EXPECT_THAT(fired_at - start, Ge(absl::Milliseconds(30)));
+}
+
+TEST_F(TimerExecutorTest, ScheduleAtInThePast) {
+  absl::Notification fired;
+  timer_->ScheduleAt(absl::Now() - absl::Seconds(1), [&] { fired.Notify(); });
+  fired.WaitForNotification();
+}
+
+TEST_F(TimerExecutorTest, EarlierTimerWakesTheThread) {
+  timer_->ScheduleAfter(absl::Hours(1), [] {});
+
+  absl::Notification fired;
+  timer_->ScheduleAfter(absl::Milliseconds(5), [&] { fired.Notify(); });
+  EXPECT_TRUE(fired.WaitForNotificationWithTimeout(absl::Seconds(10)));
+}
+
+TEST_F(TimerExecutorTest, Cancel) {
+  std::atomic<bool> fired = false;
+  auto handle =
+      timer_->ScheduleAfter(absl::Milliseconds(20), [&] { fired = true; });
+  EXPECT_TRUE(handle.Cancel());
+  EXPECT_FALSE(handle.Cancel());
+
+  absl::SleepFor(absl::Milliseconds(50));
+  EXPECT_FALSE(fired.load());
+
+  absl::Notification done;
+  auto ran = timer_->ScheduleAfter(absl::ZeroDuration(),
+                                   [&] { done.Notify(); });
+  done.WaitForNotification();
+  EXPECT_FALSE(ran.Cancel());
+}
+
+TEST_F(TimerExecutorTest, Periodic) {
+  std::atomic<int> runs = 0;
+  absl::Notification enough;
+  auto handle = timer_->SchedulePeriodic(absl::Milliseconds(2), [&] {
+    if (runs.fetch_add(1) + 1 == 5) {
+      enough.Notify();
+    }
+  });
+
+  enough.WaitForNotification();
+  EXPECT_TRUE(handle.Cancel());
+  const auto after_cancel = runs.load();
+  absl::SleepFor(absl::Milliseconds(20));
+  EXPECT_THAT(runs.load(), Le(after_cancel + 1));
+}
+
+TEST_F(TimerExecutorTest, ManyTimers) {
+  constexpr int kCount = 100000;
+  std::mt19937 random(42);
+  std::atomic<int> fired = 0;
+  absl::Notification all_fired;
+  std::vector<TimerHandle> cancelled;
+  for (int i = 0; i < kCount; ++i) {
+    auto handle = timer_->ScheduleAfter(
+        absl::Milliseconds(random() % 200), [&] {
+          if (fired.fetch_add(1) + 1 == kCount / 2) {
+            all_fired.Notify();
+          }
+        });
+    if (i % 2 == 0) {
+      cancelled.push_back(std::move(handle));
+    }
+  }
+
+  // Some may have fired already.
+  int not_cancelled = 0;
+  for (auto& handle : cancelled) {
+    not_cancelled += handle.Cancel() ? 0 : 1;
+  }
+
+  if (not_cancelled == 0) {
+    all_fired.WaitForNotification();
+  }
+  absl::SleepFor(absl::Milliseconds(250));
+  EXPECT_THAT(fired.load(), Eq(kCount / 2 + not_cancelled));
+}
+
+TEST_F(TimerExecutorTest, StopDropsPendingTimers) {
+  std::atomic<bool> fired = false;
+  timer_->ScheduleAfter(absl::Hours(1), [&] { fired = true; });
+  auto periodic = timer_->SchedulePeriodic(absl::Milliseconds(1), [] {});
+  absl::SleepFor(absl::Milliseconds(10));
+
+  timer_->stop().get();
+  EXPECT_FALSE(fired.load());
+  EXPECT_FALSE(periodic.Cancel());
+}
+
+}  // namespace
+}  // namespace handbag::executor::tests
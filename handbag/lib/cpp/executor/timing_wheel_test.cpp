@@ -0,0 +1,115 @@
+#include "lib/cpp/executor/internal/timing_wheel.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace ::testing;
+
+namespace handbag::internal_executor::tests {
+namespace {
+
+struct Node : TimingWheelNode {
+  uint64_t deadline = 0;
+};
+
+TEST(TimingWheelTest, Basic) {
+  TimingWheel wheel(10);
+  Node first;
+  Node second;
+  EXPECT_FALSE(wheel.Insert(&first, 10));
+  EXPECT_TRUE(wheel.Insert(&first, 11));
+  EXPECT_TRUE(wheel.Insert(&second, 5000));
+  EXPECT_THAT(wheel.size(), Eq(2));
+  EXPECT_THAT(wheel.NextEvent(), Optional(Eq(11)));
+
+  std::vector<TimingWheelNode*> expired;
+  wheel.Advance(4999, expired);
+  EXPECT_THAT(expired, ElementsAre(&first));
+  EXPECT_THAT(wheel.size(), Eq(1));
+
+  wheel.Advance(5000, expired);
+  EXPECT_THAT(expired, ElementsAre(&first, &second));
+  EXPECT_THAT(wheel.size(), Eq(0));
+  EXPECT_THAT(wheel.NextEvent(), Eq(std::nullopt));
+}
+
+TEST(TimingWheelTest, Remove) {
+  TimingWheel wheel(0);
+  Node node;
+  ASSERT_TRUE(wheel.Insert(&node, 100000));
+  wheel.Remove(&node);
+  EXPECT_FALSE(node.linked);
+
+  std::vector<TimingWheelNode*> expired;
+  wheel.Advance(1000000, expired);
+  EXPECT_THAT(expired, IsEmpty());
+}
+
+TEST(TimingWheelTest, Overflow) {
+  // Right before a boundary of the last level.
+  const uint64_t start = (uint64_t{1} << 42) - 2;
+  TimingWheel wheel(start);
+  Node near;
+  Node far;
+  ASSERT_TRUE(wheel.Insert(&near, start + 5));
+  ASSERT_TRUE(wheel.Insert(&far, std::numeric_limits<uint64_t>::max() / 2));
+
+  std::vector<TimingWheelNode*> expired;
+  wheel.Advance(start + 4, expired);
+  EXPECT_THAT(expired, IsEmpty());
+  wheel.Advance(start + 5, expired);
+  EXPECT_THAT(expired, ElementsAre(&near));
+  wheel.Advance(std::numeric_limits<uint64_t>::max(), expired);
+  EXPECT_THAT(expired, ElementsAre(&near, &far));
+}
+
+TEST(TimingWheelTest, MatchesSortedOrder) {
+  std::mt19937_64 random(42);
+  TimingWheel wheel(random() % 1000000);
+  std::vector<std::unique_ptr<Node>> nodes;
+  std::multimap<uint64_t, Node*> pending;
+
+  for (int round = 0; round < 200; ++round) {
+    for (int i = 0; i < 100; ++i) {
+      auto node = std::make_unique<Node>();
+      // Mostly short delays, some of them spanning several levels.
+      const auto bits = random() % 4 == 0 ? 30 : 12;
+      node->deadline = wheel.now() + 1 + random() % (uint64_t{1} << bits);
+      ASSERT_TRUE(wheel.Insert(node.get(), node->deadline));
+      pending.emplace(node->deadline, node.get());
+      nodes.push_back(std::move(node));
+    }
+
+    for (int i = 0; i < 10 && !pending.empty(); ++i) {
+      auto it = std::next(pending.begin(),
+                          static_cast<long>(random() % pending.size()));
+      wheel.Remove(it->second);
+      pending.erase(it);
+    }
+
+    const auto now = wheel.now() + random() % 5000;
+    std::vector<TimingWheelNode*> expired;
+    wheel.Advance(now, expired);
+
+    std::vector<TimingWheelNode*> expected;
+    while (!pending.empty() && pending.begin()->first <= now) {
+      expected.push_back(pending.begin()->second);
+      pending.erase(pending.begin());
+    }
+    ASSERT_THAT(expired, UnorderedElementsAreArray(expected));
+    ASSERT_THAT(wheel.size(), Eq(pending.size()));
+    if (!pending.empty()) {
+      ASSERT_THAT(wheel.NextEvent(), Optional(Le(pending.begin()->first)));
+    }
+  }
+}
+
+}  // namespace
+}  // namespace handbag::internal_executor::tests
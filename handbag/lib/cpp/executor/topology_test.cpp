@@ -0,0 +1,34 @@
+#include "lib/cpp/executor/internal/topology.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+
+namespace handbag::internal_executor::tests {
+namespace {
+
+TEST(TopologyTest, ParseCpuList) {
+  EXPECT_THAT(ParseCpuList("0-3,8,10-11\n"),
+              Optional(ElementsAre(0, 1, 2, 3, 8, 10, 11)));
+  EXPECT_THAT(ParseCpuList("5"), Optional(ElementsAre(5)));
+  EXPECT_THAT(ParseCpuList(""), Optional(IsEmpty()));
+  EXPECT_THAT(ParseCpuList("3-1"), Eq(std::nullopt));
+  EXPECT_THAT(ParseCpuList("a"), Eq(std::nullopt));
+  EXPECT_THAT(ParseCpuList("1,,2"), Eq(std::nullopt));
+}
+
+TEST(TopologyTest, NodesCoverAvailableCpus) {
+  const auto available = GetAvailableCpus();
+  ASSERT_THAT(available, Not(IsEmpty()));
+
+  std::vector<size_t> cpus;
+  for (const auto& node : GetNumaNodes()) {
+    EXPECT_THAT(node.cpus, Not(IsEmpty()));
+    cpus.insert(cpus.end(), node.cpus.begin(), node.cpus.end());
+  }
+  EXPECT_THAT(cpus, UnorderedElementsAreArray(available));
+}
+
+}  // namespace
+}  // namespace handbag::internal_executor::tests
@@ -0,0 +1,144 @@
+#include "lib/cpp/io/input_mmap.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include "absl/base/optimization.h"
+
+namespace handbag::io {
+
+namespace {
+void advise(void* const data, const size_t size, const int advice) noexcept {
+  // Only a hint, the mapping works the same without it.
+  (void)::madvise(data, size, advice);
+}
+}  // namespace
+
+absl::StatusOr<MmapInputStream> MmapInputStream::open(
+    const std::string& path, const MmapInputStreamParams& params) noexcept {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return absl::ErrnoToStatus(errno, "open(" + path + ")");
+  }
+
+  struct stat st {};
+  if (::fstat(fd, &st) != 0) {
+    const auto error = errno;
+    ::close(fd);
+    return absl::ErrnoToStatus(error, "fstat(" + path + ")");
+  }
+
+  // FIFOs, devices and most of /proc report no size, and mapping them would
+  // either fail or look like an empty file.
+  if (!S_ISREG(st.st_mode)) {
+    ::close(fd);
+    return absl::InvalidArgumentError("Not a regular file: " + path);
+  }
+
+  // `mmap` refuses empty mappings.
+  const auto size = static_cast<size_t>(st.st_size);
+  if (size == 0) {
+    ::close(fd);
+    return MmapInputStream(nullptr, 0);
+  }
+
+  void* const data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  const auto error = errno;
+  // The mapping keeps the file open.
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return absl::ErrnoToStatus(error, "mmap(" + path + ")");
+  }
+
+  if (params.sequential.value_or(false)) {
+    advise(data, size, MADV_SEQUENTIAL);
+  }
+  if (params.willneed.value_or(false)) {
+    advise(data, size, MADV_WILLNEED);
+  }
+#if defined(MADV_HUGEPAGE)
+  if (params.hugepage.value_or(false)) {
+    advise(data, size, MADV_HUGEPAGE);
+  }
+#endif
+
+  return MmapInputStream(static_cast<const char*>(data), size);
+}
+
+MmapInputStream::MmapInputStream(const char* const data,
+                                 const size_t size) noexcept
+    : data_(data), size_(size) {}
+
+MmapInputStream::MmapInputStream(MmapInputStream&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      cursor_(std::exchange(other.cursor_,
+                            std::numeric_limits<size_t>::max())) {}
+
+MmapInputStream::~MmapInputStream() {
+  if (!isClosed()) {
+    (void)close();
+  }
+}
+
+absl::StatusOr<size_t> MmapInputStream::read(
+    void* const dst, const size_t dst_capacity) noexcept {
+  if (ABSL_PREDICT_FALSE(isClosed())) {
+    return absl::FailedPreconditionError("Closed");
+  } else if (ABSL_PREDICT_FALSE(cursor_ >= size_)) {
+    return absl::ResourceExhaustedError("EOF");
+  }
+
+  const auto bytes_to_read = std::min(size_ - cursor_, dst_capacity);
+  std::memcpy(dst, data_ + cursor_, bytes_to_read);
+  cursor_ += bytes_to_read;
+
+  return bytes_to_read;
+}
+
+absl::Status MmapInputStream::close() noexcept {
+  if (ABSL_PREDICT_FALSE(isClosed())) {
+    return absl::FailedPreconditionError("Already closed.");
+  }
+
+  cursor_ = std::numeric_limits<size_t>::max();
+  if (data_ == nullptr) {
+    return absl::OkStatus();
+  }
+
+  const auto size = std::exchange(size_, 0);
+  if (::munmap(const_cast<char*>(std::exchange(data_, nullptr)), size) != 0) {
+    return absl::ErrnoToStatus(errno, "munmap");
+  }
+
+  return absl::OkStatus();
+}
+
+std::string_view MmapInputStream::view() const noexcept {
+  auto res = std::string_view(data_, size_);
+  return res;
+}
+
+std::string_view MmapInputStream::remaining() const noexcept {
+  if (isClosed()) {
+    return {};
+  }
+
+  auto res = view().substr(cursor_);
+  return res;
+}
+
+void MmapInputStream::skip(const size_t size) noexcept {
+  if (!isClosed()) {
+    cursor_ += std::min(size, size_ - cursor_);
+  }
+}
+
+}  // namespace handbag::io
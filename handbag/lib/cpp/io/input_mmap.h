@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "lib/cpp/io/input.h"
+
+namespace handbag::io {
+
+/// `madvise` hints applied to the whole mapping right after it's made. They
+/// are best-effort: a hint the kernel doesn't support is ignored.
+struct MmapInputStreamParams {
+  /// The file is read front to back (`MADV_SEQUENTIAL`): more aggressive
+  /// readahead, pages behind the reader are dropped sooner.
+  std::optional<bool> sequential = {};
+  /// Start reading the whole file in now (`MADV_WILLNEED`).
+  std::optional<bool> willneed = {};
+  /// Back the mapping with huge pages where the filesystem allows it
+  /// (`MADV_HUGEPAGE`), fewer TLB misses on multi-GB files.
+  std::optional<bool> hugepage = {};
+};
+
+/// Input stream over a regular file mapped read-only. `read` copies out of
+/// the mapping like any other stream; consumers that know the type can use
+/// `view` and `remaining` instead and copy nothing. `readAll` knows only
+/// `IInputStream`, so it still copies every byte twice: into its buffer and
+/// then into the string. Use `std::string(view())` for a single copy.
+///
+/// The file must not be truncated while mapped: touching a page past the new
+/// end raises `SIGBUS`.
+class MmapInputStream final : public IInputStream {
+ public:
+  static absl::StatusOr<MmapInputStream> open(
+      const std::string& path,
+      const MmapInputStreamParams& params = {}) noexcept;
+
+  MmapInputStream(const MmapInputStream&) = delete;
+  MmapInputStream& operator=(const MmapInputStream&) = delete;
+  MmapInputStream(MmapInputStream&& other) noexcept;
+  MmapInputStream& operator=(MmapInputStream&&) = delete;
+  ~MmapInputStream() override;
+
+  absl::StatusOr<size_t> read(void* dst, size_t dst_capacity) noexcept final;
+
+  /// Unmaps the file, invalidating the views.
+  absl::Status close() noexcept final;
+
+  /// The whole file. Borrowed from the stream, valid until `close`.
+  std::string_view view() const noexcept;
+
+  /// The part of `view` that `read` hasn't returned yet.
+  std::string_view remaining() const noexcept;
+
+  /// Consumes `size` bytes of `remaining`, at most all of them, as if they
+  /// were read.
+  void skip(size_t size) noexcept;
+
+ private:
+  MmapInputStream(const char* data, size_t size) noexcept;
+
+  bool isClosed() const noexcept {
+    return cursor_ == std::numeric_limits<size_t>::max();
+  }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  size_t cursor_ = 0;
+};
+
+}  // namespace handbag::io
@@ -0,0 +1,104 @@
+#include "lib/cpp/io/input_mmap.h"
+
+#include <fcntl.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <string>
+#include <utility>
+
+using namespace ::testing;
+
+namespace handbag::io::tests {
+namespace {
+std::string writeFile(const std::string& name, const std::string& content) {
+  auto res = TempDir() + "/" + name;
+  std::ofstream(res, std::ios::binary) << content;
+  return res;
+}
+
+TEST(MmapInput, ReadAll) {
+  std::string expected;
+  for (int i = 0; i < 10000; ++i) {
+    expected += std::to_string(i);
+  }
+  const auto path = writeFile("read_all", expected);
+  auto stream = MmapInputStream::open(path, {.sequential = true});
+  ASSERT_TRUE(stream.ok()) << stream.status();
+
+  const auto all = readAll(stream.value());
+  ASSERT_TRUE(all.ok());
+  EXPECT_THAT(all.value(), Eq(expected));
+  EXPECT_TRUE(stream->close().ok());
+}
+
+TEST(MmapInput, View) {
+  const auto path = writeFile("view", "CONTENT");
+  auto stream = MmapInputStream::open(
+      path, {.sequential = true, .willneed = true, .hugepage = true});
+  ASSERT_TRUE(stream.ok()) << stream.status();
+  EXPECT_THAT(stream->view(), Eq("CONTENT"));
+
+  char buffer[3];
+  ASSERT_THAT(stream->read(buffer, sizeof(buffer)).value_or(0), Eq(3));
+  EXPECT_THAT(std::string(buffer, 3), Eq("CON"));
+  EXPECT_THAT(stream->remaining(), Eq("TENT"));
+  stream->skip(2);
+  EXPECT_THAT(stream->remaining(), Eq("NT"));
+  stream->skip(100);
+  EXPECT_THAT(stream->remaining(), IsEmpty());
+  EXPECT_TRUE(absl::IsResourceExhausted(
+      stream->read(buffer, sizeof(buffer)).status()));
+  EXPECT_THAT(stream->view(), Eq("CONTENT"));
+
+  EXPECT_TRUE(stream->close().ok());
+  EXPECT_THAT(stream->view(), IsEmpty());
+  EXPECT_TRUE(absl::IsFailedPrecondition(
+      stream->read(buffer, sizeof(buffer)).status()));
+  EXPECT_TRUE(absl::IsFailedPrecondition(stream->close()));
+}
+
+TEST(MmapInput, Empty) {
+  const auto path = writeFile("empty", "");
+  auto stream = MmapInputStream::open(path);
+  ASSERT_TRUE(stream.ok()) << stream.status();
+  EXPECT_THAT(stream->view(), IsEmpty());
+
+  const auto all = readAll(stream.value());
+  ASSERT_TRUE(all.ok());
+  EXPECT_THAT(all.value(), IsEmpty());
+}
+
+TEST(MmapInput, Move) {
+  const auto path = writeFile("move", "CONTENT");
+  auto stream = MmapInputStream::open(path);
+  ASSERT_TRUE(stream.ok()) << stream.status();
+
+  auto moved = std::move(stream).value();
+  EXPECT_THAT(moved.view(), Eq("CONTENT"));
+  EXPECT_TRUE(moved.close().ok());
+}
+
+TEST(MmapInput, Missing) {
+  const auto stream = MmapInputStream::open(TempDir() + "/missing");
+  EXPECT_TRUE(absl::IsNotFound(stream.status()));
+}
+
+TEST(MmapInput, NotRegularFile) {
+  const auto path = TempDir() + "/fifo";
+  ::unlink(path.c_str());
+  ASSERT_THAT(::mkfifo(path.c_str(), 0600), Eq(0));
+  // Opened read-write so that `open` doesn't wait for a writer.
+  const int writer = ::open(path.c_str(), O_RDWR);
+  ASSERT_THAT(writer, Ge(0));
+
+  const auto stream = MmapInputStream::open(path);
+  EXPECT_TRUE(absl::IsInvalidArgument(stream.status())) << stream.status();
+  ::close(writer);
+  ::unlink(path.c_str());
+}
+}  // namespace
+}  // namespace handbag::io::tests
@@ -54,7 +54,7 @@ inline Repr Repr::create(const std::string_view name) noexcept {
 
 template <typename T>
 inline Repr&& Repr::field(const std::string_view name, const T& value) && {
-  std::ostringstream out(std::move(repr_));
+  std::ostringstream out(std::move(repr_), std::ios_base::ate);
   out << (has_fields_ ? ", " : "(") << name << "=" << value;
   has_fields_ = true;
   repr_ = std::move(out).str();
@@ -7,13 +7,13 @@ namespace handbag::start_stop {
 struct IStartable {
   virtual ~IStartable() = default;
 
-  virtual std::future<void> start();
+  virtual std::future<void> start() = 0;
 };
 
 struct IStoppable {
   virtual ~IStoppable() = default;
 
-  virtual std::future<void> stop();
+  virtual std::future<void> stop() = 0;
 };
 
 struct IStartableStoppable : public IStartable, public IStoppable {};
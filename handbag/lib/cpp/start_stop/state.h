@@ -31,37 +31,41 @@ class StoppableState {
 
 // Implementation
 
-void StoppableState::SetStopping() noexcept {
+inline void StoppableState::SetStopping() noexcept {
   state_.store(EState::Stopping, std::memory_order_release);
 }
 
-void StoppableState::SetStopped() noexcept {
+inline void StoppableState::SetStopped() noexcept {
   state_.store(EState::Stopped, std::memory_order_release);
 }
 
-bool StoppableState::IsStopping() const noexcept {
+inline bool StoppableState::IsStopping() const noexcept {
   const auto state = state_.load(std::memory_order_acquire);
   auto res = state == EState::Stopping;
   return res;
 }
 
-bool StoppableState::IsNotStopping() const noexcept { return !IsStopping(); }
+inline bool StoppableState::IsNotStopping() const noexcept {
+  return !IsStopping();
+}
 
-bool StoppableState::IsStopped() const noexcept {
+inline bool StoppableState::IsStopped() const noexcept {
   const auto state = state_.load(std::memory_order_acquire);
   auto res = state == EState::Stopped;
   return res;
 }
 
-bool StoppableState::IsNotStopped() const noexcept { return !IsStopped(); }
+inline bool StoppableState::IsNotStopped() const noexcept {
+  return !IsStopped();
+}
 
-bool StoppableState::IsStoppingOrStopped() const noexcept {
+inline bool StoppableState::IsStoppingOrStopped() const noexcept {
   const auto state = state_.load(std::memory_order_acquire);
   auto res = state != EState::Unknown;
   return res;
 }
 
-bool StoppableState::IsNotStoppingOrStopped() const noexcept {
+inline bool StoppableState::IsNotStoppingOrStopped() const noexcept {
   return !IsStoppingOrStopped();
 }
 